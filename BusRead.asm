@@ -14,6 +14,8 @@
 
 //            MODULE      BusRead
             PUBLIC      BusRead
+            PUBLIC      BusReadAt
+            PUBLIC      bus_gen
 
 
 EXTERN      BusAddress                                     ; The bridge between Assembler code and C code. Relative opti      
@@ -29,6 +31,14 @@ EXTERN      BusData                                        ; The bridge between
 //DATACONST     DC16    1C02H;                         ; The bridge between Assembler code and C code. Absolute option                         
 
 
+            RSEG        DATA16_N                    ;
+            EVEN                                    ;
+
+bus_gen     DS16        1                           ; Bumped by every bus cycle (BusRead.asm and BusWrite.asm).
+                                                    ; A routine that sees it change while it was latching
+                                                    ; knows an ISR used the bus and starts again.
+
+
 
 ;------------------------------------------------------------------------------------------------------
 
@@ -38,153 +48,153 @@ EXTERN      BusData                                        ; The bridge between
 
 BusRead 
 
+; Legacy entry point: address from BusAddress, data to BusData. All registers preserved.
+
            BIC.B    #03H,P1IE                       ;  Disable P1.0 P1.1 interrupts CAM
 
-; Save registers used           
+           PUSH.W   R12                             ; Save what BusReadAt clobbers
+           PUSH.W   R13                             ;
+           PUSH.W   R14                             ;
+           PUSH.W   R15                             ;
 
-           PUSH.W   R4                              ;          
-           PUSH.W   R5                              ;          
-           PUSH.W   R6                              ;           
-           PUSH.W   R7                              ;
+           MOV.W    BusAddress,R12                  ; Relative variable option
+           CALLA    #BusReadAt                      ;
+           MOV.W    R12,BusData                     ; Relative address option
 
-           
-           MOV.B    #0FH,P5DIR                      ; PORT5 as an Output
+           POP.W    R15                             ; Clean up the stack
+           POP.W    R14                             ;
+           POP.W    R13                             ;
+           POP.W    R12                             ;
+
+           BIS.B    #03H,P1IE                       ;  Enable P1.0 P1.1 interrupt CAM
+
+           RETA                                     ; Return from CALLA
+
+
+;------------------------------------------------------------------------------------------------------
+; BusReadAt: register calling convention (MSP430 EABI)
+;
+; In:  R12 = bus address            C prototype: unsigned int BusReadAt(unsigned int address);
+; Out: R12 = data read
+; Clobbers R13-R15 only (caller-saved), no globals, so main and ISRs can both call it.
+;
+; The address is latched with interrupts enabled. Interrupts are masked only from the
+; bus_gen check to the end of the E cycle; if an ISR used the bus while the address was
+; being latched, bus_gen has moved on and the address is latched again.
+;------------------------------------------------------------------------------------------------------
 
 
-;Get the bus address value
-//           MOV.W    ADDRCONST,R5                    ;          
-//           MOV.W    @R5,R4                          ; Get the memory address from 1C00H
+BusReadAt
 
-           MOV.W    BusAddress,R4                   ; Relative variable option
+BRA_Start  MOV.W    &bus_gen,R15                    ; Snapshot of the bus generation
 
-           MOV.W    R4,R5                           ; Copy into R5
+           MOV.B    #0FH,P5DIR                      ; PORT5 as an Output
 
+           MOV.W    R12,R13                         ; Copy the address into R13
 
-           MOV.W    #01,PJOUT                       ; Control1: Open gate for the least significant nibble                
-           MOV.B    R4,P5OUT                        ; Put least significant nibble out of Port5
-          
+           MOV.W    #01,PJOUT                       ; Control1: Open gate for the least significant nibble
+           MOV.B    R13,P5OUT                       ; Put least significant nibble out of Port5
 
-           RRA.B    R4                              ; Get the next nibble ready           
-           RRA.B    R4                              ;           
-           RRA.B    R4                              ;           
-           RRA.B    R4                              ;
-           MOV.W    #02,PJOUT                       ; Control2: Lock the latch of the least significant nibble and prepare the gate for the second nobble 
-           MOV.B    R4,P5OUT                        ; Output nibble
-          
-                                                                                                                                 
-           SWPB     R5                              ; Get the other byte           
-           MOV.W    #03H,PJOUT                      ; Control3: Lock the latch of the second nibble and prepare the gate for the third nibble         
-           MOV.B    R5,P5OUT                        ; Output nibble
-          
-                                                                                         
+           RRA.B    R13                             ; Get the next nibble ready
+           RRA.B    R13                             ;
+           RRA.B    R13                             ;
+           RRA.B    R13                             ;
+           MOV.W    #02,PJOUT                       ; Control2: Lock the latch of the least significant nibble and prepare the gate for the second nobble
+           MOV.B    R13,P5OUT                       ; Output nibble
 
-           RRA.B    R5                              ; Get the last nibble in position           
-           RRA.B    R5                              ;           
-           RRA.B    R5                              ;           
-           RRA.B    R5                              ;           
+           MOV.W    R12,R13                         ;
+           SWPB     R13                             ; Get the other byte
+           MOV.W    #03H,PJOUT                      ; Control3: Lock the latch of the second nibble and prepare the gate for the third nibble
+           MOV.B    R13,P5OUT                       ; Output nibble
+
+           RRA.B    R13                             ; Get the last nibble in position
+           RRA.B    R13                             ;
+           RRA.B    R13                             ;
+           RRA.B    R13                             ;
            MOV.W    #04,PJOUT                       ; Control4: Lock the latch of the third nibble and prepare the gate for the fourth nibble
-           MOV.B    R5,P5OUT                        ; Output nibble
-        
-           NOP                                      ;  Give it a chance to appear           
-           NOP                                      ;           
+           MOV.B    R13,P5OUT                       ; Output nibble
+
+           NOP                                      ;  Give it a chance to appear
            NOP                                      ;
-         
-         
-           MOV.W    #05H,PJOUT                      ; Control5: Lock the last nibble and get Address on the bus          
-           NOP                                      ;  Give it a chance to appear           
-           NOP                                      ;           
            NOP                                      ;
-           
-
-           MOV.B    #00H,P5DIR                      ; PORT5 as an Input
 
 
+           PUSH.W   SR                              ; Bus cycle proper: no interrupts from here
+           DINT                                     ;
+           NOP                                      ;
+           CMP.W    &bus_gen,R15                    ; Did an ISR use the bus while we latched?
+           JNE      BRA_Again                       ;
+           INC.W    &bus_gen                        ; Claim this cycle
 
-           BIS.B    #40H,P4OUT                      ; E active from S12 system
 
+           MOV.W    #05H,PJOUT                      ; Control5: Lock the last nibble and get Address on the bus
+           NOP                                      ;  Give it a chance to appear
+           NOP                                      ;
+           NOP                                      ;
 
-           MOV.W    #11,PJOUT                       ; Control11 to collect first nibble. 4 cycles 
+           MOV.B    #00H,P5DIR                      ; PORT5 as an Input
 
+           BIS.B    #40H,P4OUT                      ; E active from S12 system
 
-           NOP                                      ; Match timing requirements with external peripheral           
-           NOP                                      ;                          
-           NOP                                      ;           
-           NOP                                      ;                                
-           NOP                                      ;                   
+           MOV.W    #11,PJOUT                       ; Control11 to collect first nibble. 4 cycles
 
-           NOP                                      ;           
+           NOP                                      ; Match timing requirements with external peripheral
            NOP                                      ;
            NOP                                      ;
-           NOP                                      ;           
            NOP                                      ;
-           NOP                                      ;           
            NOP                                      ;
-           
-                
-                 
-           MOV.B    P5IN,R4                         ; Get the first nibble
-                    
-          
-           MOV.W    #12,PJOUT                       ; Control12 to collect second nibble       
-           MOV.B    P5IN,R5                         ; Get the secont nibble
-         
-
-           MOV.W    #13,PJOUT                       ; Control13 to clollect third nibble          
-           MOV.B    P5IN,R6                         ; Get the third nibble
-         
 
-           MOV.W    #14,PJOUT                       ; Control14 to collect fourth nibble         
-           MOV.B    P5IN,R7                         ; Get the fourth nibble
-          
-           
-           AND.W    #0FH,R4                         ; Mask R4
-           AND.W    #0FH,R5                         ; Mask R5
-           AND.W    #0FH,R6                         ; Mask R6  
-           AND.W    #0FH,R7                         ; Mask R7
+           NOP                                      ;
+           NOP                                      ;
+           NOP                                      ;
+           NOP                                      ;
+           NOP                                      ;
+           NOP                                      ;
+           NOP                                      ;
 
+           MOV.B    P5IN,R12                        ; Get the first nibble
 
-           RLA.B    R5                              ; Move nibble in R5 left four places
-           RLA.B    R5                              ;           
-           RLA.B    R5                              ;
-           RLA.B    R5                              ;
-           RLA.B    R7                              ; Move nibble in R7 left four spaces
-           RLA.B    R7                              ;           
-           RLA.B    R7                              ;
-           RLA.B    R7                              ;                                             
-           ADD.W    R4,R5                           ; Set least significant byte in R5
-           ADD.W    R6,R7                           ; Set most significant byte in lower byte of R7
-           SWPB     R7                              ; Move the bytes over in R7
-           ADD.W    R5,R7                           ; Put it all together in R7 for return          
-                   
+           MOV.W    #12,PJOUT                       ; Control12 to collect second nibble
+           MOV.B    P5IN,R13                        ; Get the secont nibble
 
-//           MOV.W    DATACONST,R5                    ;           
-//           MOV.W    R7,0(R5)                        ; Data ready  
+           MOV.W    #13,PJOUT                       ; Control13 to clollect third nibble
+           MOV.B    P5IN,R14                        ; Get the third nibble
 
-           MOV.W    R7,BusData                      ; Relative address option         
+           MOV.W    #14,PJOUT                       ; Control14 to collect fourth nibble
+           MOV.B    P5IN,R15                        ; Get the fourth nibble
 
-           
            BIC.B    #40H,P4OUT                      ; E passive
-           
-           
+
            MOV.W    #00,PJOUT                       ; Disconnect all
 
-                                 
+           POP.W    SR                              ; Bus released: interrupts back as they were
+           NOP                                      ;
+
 
-           POP.W    R7                              ; Clean up the stack
-           POP.W    R6                              ;          
-           POP.W    R5                              ;           
-           POP.W    R4                              ;
+           AND.W    #0FH,R12                        ; Mask R12
+           AND.W    #0FH,R13                        ; Mask R13
+           AND.W    #0FH,R14                        ; Mask R14
+           AND.W    #0FH,R15                        ; Mask R15
 
+           RLA.B    R13                             ; Move nibble in R13 left four places
+           RLA.B    R13                             ;
+           RLA.B    R13                             ;
+           RLA.B    R13                             ;
+           RLA.B    R15                             ; Move nibble in R15 left four spaces
+           RLA.B    R15                             ;
+           RLA.B    R15                             ;
+           RLA.B    R15                             ;
+           ADD.W    R13,R12                         ; Set least significant byte in R12
+           ADD.W    R14,R15                         ; Set most significant byte in lower byte of R15
+           SWPB     R15                             ; Move the bytes over in R15
+           ADD.W    R15,R12                         ; Put it all together in R12 for return
 
-                                            
-//           MOV.W    0(SP),2(SP)                     ; No need to CALLA subroutine
-           
-//           INCD.W   SP                              ; No need to CALLA subroutine
-                      
-      
-           BIS.B    #03H,P1IE                       ;  Enable P1.0 P1.1 interrupt CAM           
+           RETA                                     ; Return from CALLA
 
-           RETA                                      ; Return from CALLA
+
+BRA_Again  POP.W    SR                              ; An ISR got in first: latch the address again
+           NOP                                      ;
+           JMP      BRA_Start                       ;
 
 
 ;--------------------------------------------------------------------------------------------------
@@ -15,12 +15,16 @@
 
 //            MODULE      BusWrite
             PUBLIC      BusWrite 
+            PUBLIC      BusWriteBurst
+            PUBLIC      BusWriteAt
 
 
 EXTERN         BusAddress                                ; The bridge between Assembler code and C code. Relative option 
 
 EXTERN         BusData                                   ; The bridge between Assembler code and C code. Relative option
 
+EXTERN         bus_gen                                   ; Bus cycle generation (BusRead.asm)
+
 
 
 
@@ -44,143 +48,304 @@ EXTERN         BusData                                   ; The bridge between As
             
 BusWrite 
 
-
+; Legacy entry point: address from BusAddress, data from BusData. All registers preserved.
 
            BIC.B    #03H,P1IE                       ;  Disable P1.0 and P1.1 interrupts CAM
-           PUSH.W   R4                              ;           
-           PUSH.W   R5                              ;
+
+           PUSH.W   R12                             ; Save what BusWriteAt clobbers
+           PUSH.W   R13                             ;
+           PUSH.W   R14                             ;
+           PUSH.W   R15                             ;
+
+           MOV.W    BusAddress,R12                  ; Relative variable option
+           MOV.W    BusData,R13                     ; Relative variable option
+           CALLA    #BusWriteAt                     ;
+
+           POP.W    R15                             ; Restore registers
+           POP.W    R14                             ;
+           POP.W    R13                             ;
+           POP.W    R12                             ;
+
+           BIS.B    #03H,P1IE                       ;  Enable P1.0 and P1.1 Interrupt
+
+           RETA                                     ; Return from CALLA
+
+
+;-------------------------------------------------------------------------------------------------------------
+; BusWriteAt: register calling convention (MSP430 EABI)
+;
+; In:  R12 = bus address, R13 = data     C prototype: void BusWriteAt(unsigned int address, unsigned int data);
+; Clobbers R14 and R15 only (caller-saved), no globals, so main and ISRs can both call it.
+;
+; Address and data are latched with interrupts enabled. Interrupts are masked only from
+; the bus_gen check to the end of the strobe; if an ISR used the bus in the meantime the
+; latches no longer hold our nibbles, so they are latched again before anything is written.
+;-------------------------------------------------------------------------------------------------------------
+
+
+BusWriteAt
+
+BWA_Start  MOV.W    &bus_gen,R15                    ; Snapshot of the bus generation
+
            MOV.B    #0FH,P5DIR                      ; PORT as an Output
-           
 
-;Get the bus address value
-//           MOV.W    ADDRCONST,R5                    ;
-//           MOV.W    @R5,R4                          ; Get the memory address from 1C00H
+           MOV.W    R12,R14                         ; Copy the address into R14
 
-            MOV.W    BusAddress,R4                   ; Relative variable option
+           MOV.W    #01,PJOUT                       ; Control1: Open the gate to the least significant nibble
+           MOV.B    R14,P5OUT                       ; Output nibble
 
+           RRA.B    R14                             ; Get this nibble ready
+           RRA.B    R14                             ;
+           RRA.B    R14                             ;
+           RRA.B    R14                             ;
+           MOV.W    #02,PJOUT                       ; Control2: Lock least significant nibble and open the gate for the second one
+           MOV.B    R14,P5OUT                       ; Output this nibble
 
-            MOV.W    R4,R5                           ; Copy into R5 
+           MOV.W    R12,R14                         ;
+           SWPB     R14                             ; Prepare the second byte
+           MOV.W    #03H,PJOUT                      ; Control3: Lock the second nibble and open the gate for the third nibble
+           MOV.B    R14,P5OUT                       ; Output nibble
 
+           RRA.B    R14                             ; Get the last nibble in position
+           RRA.B    R14                             ;
+           RRA.B    R14                             ;
+           RRA.B    R14                             ;
+           MOV.W    #04,PJOUT                       ; Control4: Lock the third nibble and open the gate for the fourth nibble
+           MOV.B    R14,P5OUT                       ; Output nibble
 
 
-           MOV.W    #01,PJOUT                       ; Control1: Open the gate to the least significant nibble  
-           MOV.B    R4,P5OUT                        ; Output nibble
-            
-          
-           RRA.B    R4                              ; Get this nibble ready           
-           RRA.B    R4                              ;           
-           RRA.B    R4                              ;           
-           RRA.B    R4                              ;
-           MOV.W    #02,PJOUT                       ; Control2: Lock least significant nibble and open the gate for the second one    
-           MOV.B    R4,P5OUT                        ; Output this nibble           
-          
- 
-           SWPB     R5                              ; Prepare the second byte           
-           MOV.W   #03H,PJOUT                       ; Control3: Lock the second nibble and open the gate for the third nibble   
-           MOV.B    R5,P5OUT                        ; Output nibble                      
-          
+           MOV.W    R13,R14                         ; Copy the data into R14
 
-          
-           RRA.B    R5                              ; Get the last nibble in position           
-           RRA.B    R5                              ;           
-           RRA.B    R5                              ;
-           RRA.B    R5                              ;  
-           MOV.W    #04,PJOUT                       ; Control4: Lock the third nibble and open the gate for the fourth nibble                                 
-           MOV.B    R5,P5OUT                        ; Output nibble
+           MOV.W    #06,PJOUT                       ; Control6: Lock the fourth nibble and open gate for the first data nibble
+           MOV.B    R14,P5OUT                       ; First data nibble
 
+           RRA.B    R14                             ; Get the second data nibble in position
+           RRA.B    R14                             ;
+           RRA.B    R14                             ;
+           RRA.B    R14                             ;
+           MOV.W    #07,PJOUT                       ; Control7: Lock the first data nibble and open the gate for the second data nibble
+           MOV.B    R14,P5OUT                       ; Output nibble
 
-//           MOV.W    DATACONST,R5                    ;            
-//           MOV.W    @R5,R4                          ; From data from address 1C02H
+           MOV.W    R13,R14                         ;
+           SWPB     R14                             ; Get high order byte
+           MOV.W    #08,PJOUT                       ; Control8: Lock the second data nibble and open gate for the third data nibble
+           MOV.B    R14,P5OUT                       ; Output nibble
 
-            MOV.W    BusData,R4                      ; Relative variable option
+           RRA.B    R14                             ;
+           RRA.B    R14                             ;
+           RRA.B    R14                             ;
+           RRA.B    R14                             ;
+           MOV.W    #09,PJOUT                       ; Control9: Lock the third data nibble and open the gate for the fourth data nibble
+           MOV.B    R14,P5OUT                       ; Most significant data nibble out
 
-            MOV.W    R4,R5                           ; Copy into R5
-            
-            
-            
-           MOV.W    #06,PJOUT                       ; Control6: Lock the fourth nibble and open gate for the first data nibble           
-           MOV.B    R4,P5OUT                        ; First data nibble                                                        
-          
 
-           RRA.B    R4                              ; Get the second data nibble in position                                 
-           RRA.B    R4                              ;           
-           RRA.B    R4                              ;                                
-           RRA.B    R4                              ;
-           MOV.W    #07,PJOUT                       ; Control7: Lock the first data nibble and open the gate for the second data nibble  
-           MOV.B    R4,P5OUT                        ; Output nibble           
-          
-                                                                                         
-           SWPB     R5                              ; Get high order byte
-           MOV.W    #08,PJOUT                       ; Control8: Lock the second data nibble and open gate for the third data nibble  
-           MOV.B    R5,P5OUT                        ; Output nibble          
-          
+           PUSH.W   SR                              ; Strobe: no interrupts from here
+           DINT                                     ;
+           NOP                                      ;
+           CMP.W    &bus_gen,R15                    ; Did an ISR use the bus while we latched?
+           JNE      BWA_Again                       ;
+           INC.W    &bus_gen                        ; Claim this cycle
 
 
-           RRA.B    R5                              ;                                
-           RRA.B    R5                              ;          
-           RRA.B    R5                              ;                                 
-           RRA.B    R5                              ;
-           MOV.W    #09,PJOUT                       ; Control9: Lock the third data nibble and open the gate for the fourth data nibble 
-           MOV.B    R5,P5OUT                        ; Most significant data nibble out
-           
-                      
-           
            MOV.W    #05H,PJOUT                      ; Control5: Lock most significant nibble and put address on the bus
-           NOP                                      ;            
-           NOP                                      ;           
+           NOP                                      ;
+           NOP                                      ;
            NOP                                      ;
 
+           BIS.B    #40H,P4OUT                      ; E active
 
-           
-           BIS.B    #40H,P4OUT                      ; E active                    
+           NOP                                      ;
+           NOP                                      ;
+           NOP                                      ;
 
-           NOP                                      ;           
-           NOP                                      ;           
+           MOV.W    #10,PJOUT                       ; Control10 Data on the bus
+           NOP                                      ;
+           NOP                                      ;
            NOP                                      ;
 
+           BIC.B    #80H,P4OUT                      ; /WRITE active
 
-           
-           MOV.W    #10,PJOUT                       ; Control10 Data on the bus
-           NOP                                      ;            
-           NOP                                      ;     
            NOP                                      ;
-                      
+           NOP                                      ;
+           NOP                                      ;
+           NOP                                      ;
+           NOP                                      ;
+           NOP                                      ;
 
+           BIS.B    #80H,P4OUT                      ; /WRITE inactive
 
-           BIC.B    #80H,P4OUT                      ; /WRITE active                                 
+           BIC.B    #40H,P4OUT                      ; E passive
 
-         
-         
-           NOP                                      ;            
-           NOP                                      ;                      
-           NOP                                      ;           
-           NOP                                      ;           
-           NOP                                      ;           
+           MOV.W    #00,PJOUT                       ; Disconnect all
+
+           POP.W    SR                              ; Bus released: interrupts back as they were
            NOP                                      ;
 
-           
-           BIS.B    #80H,P4OUT                      ; /WRITE inactive
+           RETA                                     ; Return from CALLA
+
+
+BWA_Again  POP.W    SR                              ; An ISR got in first: latch everything again
+           NOP                                      ;
+           JMP      BWA_Start                       ;
+
+
+;-------------------------------------------------------------------------------------------------------------
+; BusWriteBurst: several writes in one call
+;
+; R12 = pointer to an array of (address, data) word pairs, R13 = number of pairs.
+; C prototype: void BusWriteBurst(const BusXfer *items, unsigned int count);
+;
+; R4-R7 are saved once for the whole burst. An address nibble is only re-latched
+; when it differs from the previous item (the first item latches all four), the
+; data nibbles are always latched and E is pulsed once per item.
+; Interrupts are masked for the burst so no ISR can change the address latches
+; between two items. Clobbers R12, R13 and R15 (caller-saved in C).
+;-------------------------------------------------------------------------------------------------------------
+
+
+BusWriteBurst
+
+           CMP.W    #0,R13                          ; Nothing to do?
+           JZ       BWB_Return                      ;
+
+           PUSH.W   R4                              ; Save registers once for the burst
+           PUSH.W   R5                              ;
+           PUSH.W   R6                              ;
+           PUSH.W   R7                              ;
+           PUSH.W   SR                              ; Keep the caller's GIE
+           DINT                                     ; Latches must not change under us
+           NOP                                      ;
+           INC.W    &bus_gen                        ; Tell interrupted BusReadAt/BusWriteAt callers
+
+           BIC.B    #03H,P1IE                       ;  Disable P1.0 and P1.1 interrupts CAM
+           MOV.B    #0FH,P5DIR                      ; PORT as an Output
+
+           MOV.W    @R12,R6                         ; R6 = address held in the latches:
+           INV.W    R6                              ; start with every nibble different
+
+
+BWB_Loop   MOV.W    @R12+,R4                        ; Address of this item
+           MOV.W    @R12+,R5                        ; Data of this item
+           CALL     #BWB_Item                       ; Latch and strobe
+           DEC.W    R13                             ;
+           JNZ      BWB_Loop                        ;
 
 
-           BIC.B    #40H,P4OUT                      ; E passive
-                      
-           
            MOV.W    #00,PJOUT                       ; Disconnect all
-          
 
-           POP.W    R5                              ; Restore registers           
+           BIS.B    #03H,P1IE                       ;  Enable P1.0 and P1.1 Interrupt
+
+           POP.W    SR                              ; Restore GIE
+           NOP                                      ;
+           POP.W    R7                              ; Restore registers
+           POP.W    R6                              ;
+           POP.W    R5                              ;
            POP.W    R4                              ;
-           
 
-//           MOV.W    0(SP),2(SP)                     ;  No need to CALLA subroutine
+BWB_Return RETA                                     ; Return from CALLA
+
+
+;-------------------------------------------------------------------------------------------------------------
+; One burst item. R4 = address, R5 = data, R6 = address in the latches (updated).
+; Uses R7 and R15.
+;-------------------------------------------------------------------------------------------------------------
+
+
+BWB_Item
+
+           MOV.W    R4,R7                           ; R7 = address bits that changed
+           XOR.W    R6,R7                           ;
+           MOV.W    R4,R6                           ; The latches will hold this address
+
+
+           BIT.W    #000FH,R7                       ; Least significant nibble changed?
+           JZ       BWB_A2                          ;
+           MOV.W    #01,PJOUT                       ; Control1: Open the gate to the least significant nibble
+           MOV.B    R4,P5OUT                        ; Output nibble
+
+BWB_A2     BIT.W    #00F0H,R7                       ; Second nibble changed?
+           JZ       BWB_A3                          ;
+           MOV.W    R4,R15                          ;
+           RRA.B    R15                             ; Get this nibble ready
+           RRA.B    R15                             ;
+           RRA.B    R15                             ;
+           RRA.B    R15                             ;
+           MOV.W    #02,PJOUT                       ; Control2: Open the gate for the second nibble
+           MOV.B    R15,P5OUT                       ; Output nibble
+
+BWB_A3     BIT.W    #0F00H,R7                       ; Third nibble changed?
+           JZ       BWB_A4                          ;
+           MOV.W    R4,R15                          ;
+           SWPB     R15                             ; Prepare the second byte
+           MOV.W    #03H,PJOUT                      ; Control3: Open the gate for the third nibble
+           MOV.B    R15,P5OUT                       ; Output nibble
+
+BWB_A4     BIT.W    #0F000H,R7                      ; Most significant nibble changed?
+           JZ       BWB_Data                        ;
+           MOV.W    R4,R15                          ;
+           SWPB     R15                             ;
+           RRA.B    R15                             ; Get the last nibble in position
+           RRA.B    R15                             ;
+           RRA.B    R15                             ;
+           RRA.B    R15                             ;
+           MOV.W    #04,PJOUT                       ; Control4: Open the gate for the fourth nibble
+           MOV.B    R15,P5OUT                       ; Output nibble
+
+
+BWB_Data   MOV.W    #06,PJOUT                       ; Control6: Lock the address nibble and open gate for the first data nibble
+           MOV.B    R5,P5OUT                        ; First data nibble
+
+           MOV.W    R5,R15                          ;
+           RRA.B    R15                             ; Get the second data nibble in position
+           RRA.B    R15                             ;
+           RRA.B    R15                             ;
+           RRA.B    R15                             ;
+           MOV.W    #07,PJOUT                       ; Control7: Lock the first data nibble and open the gate for the second data nibble
+           MOV.B    R15,P5OUT                       ; Output nibble
+
+           SWPB     R5                              ; Get high order byte
+           MOV.W    #08,PJOUT                       ; Control8: Lock the second data nibble and open gate for the third data nibble
+           MOV.B    R5,P5OUT                        ; Output nibble
+
+           RRA.B    R5                              ;
+           RRA.B    R5                              ;
+           RRA.B    R5                              ;
+           RRA.B    R5                              ;
+           MOV.W    #09,PJOUT                       ; Control9: Lock the third data nibble and open the gate for the fourth data nibble
+           MOV.B    R5,P5OUT                        ; Most significant data nibble out
+
+
+           MOV.W    #05H,PJOUT                      ; Control5: Lock most significant nibble and put address on the bus
+           NOP                                      ;
+           NOP                                      ;
+           NOP                                      ;
+
+           BIS.B    #40H,P4OUT                      ; E active
+
+           NOP                                      ;
+           NOP                                      ;
+           NOP                                      ;
+
+           MOV.W    #10,PJOUT                       ; Control10 Data on the bus
+           NOP                                      ;
+           NOP                                      ;
+           NOP                                      ;
+
+           BIC.B    #80H,P4OUT                      ; /WRITE active
+
+           NOP                                      ;
+           NOP                                      ;
+           NOP                                      ;
+           NOP                                      ;
+           NOP                                      ;
+           NOP                                      ;
+
+           BIS.B    #80H,P4OUT                      ; /WRITE inactive
+
+           BIC.B    #40H,P4OUT                      ; E passive
+
+           RET                                      ;
 
-//           INCD.W   SP                              ;  No need to CALLA subroutine
-           
-           
-           BIS.B    #03H,P1IE                       ;  Enable P1.0 and P1.1 Interrupt
-                                           
-           RETA                                      ; Return from CALLA
-           
 
 ;-------------------------------------------------------------------------------------------------------------
 
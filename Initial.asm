@@ -1,4 +1,5 @@
 #include  "msp430f5308.h"
+#include  "clock.h"
 
 
 ;--------------------------------------------------------------------------------------------------------------------------
@@ -38,6 +39,8 @@ Flag2      BIT.W    #SVSMLDLYIFG,&PMMIFG             ; Flag is not set
 
 
 
+#if CLOCK_PMMCOREV >= 1                                     ; Step the core voltage only as far as CLOCK_MHZ needs
+
            MOV.W    #(SVSHE+SVSHRVL_1+SVMHE+SVSMHRRL_1),&SVSMHCTL;
            
            MOV.W    #(SVSLE+SVMLE+SVSMLRRL_1),&SVSMLCTL;
@@ -67,10 +70,14 @@ Flag4      BIT.W    #SVMLVLRIFG,&PMMIFG              ;
 
 Proceed1   MOV.W    #(SVSLE+SVSLRVL_1+SVMLE+SVSMLRRL_1),&SVSMLCTL;
 
+#endif
+
 
 ;---------------------------------------------------------------------------------------------------------------
 
 
+#if CLOCK_PMMCOREV >= 2
+
 Flag5      BIT.W    #SVSMHDLYIFG,&PMMIFG             ;
            
            JZ       Flag5                            
@@ -110,10 +117,14 @@ Flag8      BIT.W    #SVMLVLRIFG,&PMMIFG              ;
 
 Proceed2   MOV.W    #(SVSLE+SVSLRVL_2+SVMLE+SVSMLRRL_2),&SVSMLCTL;
 
+#endif
+
 
 ;----------------------------------------------------------------------------------------------------
 
 
+#if CLOCK_PMMCOREV >= 3
+
 Flag9      BIT.W    #SVSMHDLYIFG,&PMMIFG             ;
            
            JZ       Flag9                            
@@ -153,6 +164,8 @@ Flag12     BIT.W    #SVMLVLRIFG,&PMMIFG              ;
 
 Proceed3   MOV.W    #(SVSLE+SVSLRVL_3+SVMLE+SVSMLRRL_3),&SVSMLCTL;
 
+#endif
+
 
            CLR.B    PMMCTL0_H                        ; Switch Off Power management controller
 
@@ -164,13 +177,41 @@ Proceed3   MOV.W    #(SVSLE+SVSLRVL_3+SVMLE+SVSMLRRL_3),&SVSMLCTL;
 
 
 
-           BIS.W    #DCORSEL_4,&UCSCTL1             ; Set up frequency range
-          
+#if CLOCK_XT1
+
+           BIS.B    #30H,&P5SEL                     ; P5.4 = XIN, P5.5 = XOUT
+
+           BIC.W    #XT1OFF,&UCSCTL6                ; Start XT1
+
+           BIS.W    #XCAP_3,&UCSCTL6                ; Internal load capacitors
 
-           MOV.W    #762,&UCSCTL2                   ; Devider for FLL: 762 aiming at 25MHz
+WaitXT1    BIC.W    #(XT2OFFG+XT1LFOFFG+DCOFFG),&UCSCTL7 ; Clear oscillator faults
 
+           BIC.W    #OFIFG,&SFRIFG1                 ;
 
+           BIT.W    #OFIFG,&SFRIFG1                 ; Until XT1 has settled
+           
+           JNZ      WaitXT1                         ;
+
+#endif
+
+
+           BIS.W    #SCG0,SR                        ; Hold the FLL while the DCO is set up
+
+           CLR.W    &UCSCTL0                        ; Lowest DCO tap, the FLL works up from here
+
+           MOV.W    #CLOCK_DCORSEL,&UCSCTL1         ; Set up frequency range
+          
+
+           MOV.W    #CLOCK_FLLN,&UCSCTL2            ; Devider for FLL: DCOCLK = (N+1) x 32768 Hz
+
+#if CLOCK_XT1
+           MOV.W    #SELREF__XT1CLK,&UCSCTL3        ; XT1 as a reference for FLL
+#else
            MOV.W    #0020H,&UCSCTL3                 ; REFCLK as a reference for FLL
+#endif
+
+           BIC.W    #SCG0,SR                        ; Let the FLL lock
         
 
            MOV.W    #0333H,&UCSCTL4                 ;  from DCOCLK as a souce for ACLK, SMCLK & MCLK
@@ -195,7 +236,7 @@ WaitPLL1   DEC.W    R4                              ;
           
 
 
-           MOV.W    #24999,&TA1CCR0                 ; TimerA1 divider
+           MOV.W    #(CLOCK_TICK_CYCLES-1),&TA1CCR0 ; TimerA1 divider
                
 
            BIS.W    #(TASSEL_1+MC_1),&TA1CTL        ; ACLK as a sorce fro Timer1, Timer1 counts to TA1CCR0
@@ -254,7 +295,7 @@ WaitPLL1   DEC.W    R4                              ;
 
           
 
-           MOV.W    #10000,R4                     ;
+           MOV.W    #CLOCK_LOOP3_US(1200),R4      ; 1.2 ms at any clock
            
 ResetLCD1  DEC.W    R4                            ;
            
@@ -266,7 +307,7 @@ ResetLCD1  DEC.W    R4                            ;
 
 
 
-           MOV.W    #10000,R4                     ;
+           MOV.W    #CLOCK_LOOP3_US(1200),R4      ;
            
 ResetLCD2  DEC.W    R4                            ;
            
@@ -1,4 +1,5 @@
 #include "msp430f5308.h"
+#include "clock.h"
 ; =====================================================================
 ; CLIC3 (MSP430F5308 Microcontroller Board) Timer System
 ; =====================================================================
@@ -6,8 +7,14 @@
             PUBLIC      BusAddress
             PUBLIC      BusData
             EXTERN      Initial
-            EXTERN      BusRead
-            EXTERN      BusWrite
+            EXTERN      BusReadAt           ; R12 = address -> R12 = data
+            EXTERN      BusWriteAt          ; R12 = address, R13 = data
+            EXTERN      BusWriteBurst
+            EXTERN      LCD_Init            ; lcd.c: I2C queue + shadow framebuffer
+            EXTERN      LCD_Screen          ; R12 = screen, R13 = field renderer
+            EXTERN      LCD_Service
+            EXTERN      lcd_done
+            EXTERN      I2C_Watchdog        ; R12 = ms since the last call -> R12 = 1 to wake main
 
 ; =====================================================================
 ; Hardware Addresses
@@ -24,32 +31,61 @@ KEYPAD_ADDR     EQU     4008h       ; Keypad input address
 SWITCH_S3_BIT   EQU     80h         ; S3 is bit 7
 LED_D0          EQU     01h         ; Alarm LED (bit 0) - active low in shadow
 LED_D7          EQU     80h         ; S3 status LED (bit 7) - active low in shadow
-DEBOUNCE_MS     EQU     20          ; 20ms debounce time
-BLINK_MS        EQU     250         ; 250ms for ~2Hz blink (toggle every 250ms)
+
+; =====================================================================
+; Build Options (-D on the assembler command line; a variant carries only
+; the code it uses, see README, Build variants)
+; =====================================================================
+#ifndef DEBOUNCE_MS
+#define DEBOUNCE_MS     20          // 20ms debounce time
+#endif
+#ifndef BLINK_MS
+#define BLINK_MS        250         // 250ms for ~2Hz blink (toggle every 250ms)
+#endif
+#ifndef DEFAULT_THRESHOLD
+#define DEFAULT_THRESHOLD   0139h   // Packed BCD mm:ss (99 s)
+#endif
+#ifndef RESET_ON_STOP
+#define RESET_ON_STOP   1           // 1 = S3 off clears the threshold entry
+#endif
+#ifndef KEYPAD_POLL
+#define KEYPAD_POLL     0           // 1 = timer polls the keypad, no PORT2 ISR
+#endif
+KEY_POLL_MS     EQU     20          ; Keypad poll period (KEYPAD_POLL)
+KEY_PRESS_MS    EQU     5           ; Settle time before the scan code is read
+KEY_RELEASE_MS  EQU     10          ; P2.0 must stay low this long to count as released
+
+; Keypad states (KEYPAD_POLL=0, see Keypad_Deadline)
+KEY_IDLE        EQU     0
+KEY_PRESS_WAIT  EQU     1
+KEY_DOWN        EQU     2
+KEY_RELEASE_WAIT EQU    3
 
 ; =====================================================================
 ; Data Segment - Application State Variables
 ; =====================================================================
             RSEG        DATA16_I
 
-; ---- Bus Comms (Used by BusRead/BusWrite) ----
+; ---- Bus Comms (Used by the legacy BusRead/BusWrite wrappers) ----
 BusAddress      DW      0
 BusData         DW      0
 
-; ---- Timing State ----
-seconds         DW      0           ; elapsed seconds (0..99)
+; ---- Timing State (packed BCD: one decimal digit per nibble) ----
+seconds         DW      0           ; elapsed mm:ss (0000h..5959h)
 ms_count        DW      0           ; ms within current second
+tick_frac       DW      0           ; CLOCK_TICK_FRAC carried between ticks (/1000)
 timing          DB      0           ; 1 = timing
+hours           DB      0           ; elapsed hours (00h..99h)
 
 ; ---- S3 Debounce ----
+debounce_cnt    DW      0
 s3_debounced    DB      0
 s3_last         DB      0
 s3_raw          DB      0
-debounce_cnt    DW      0
 
 ; ---- Alarm/Blink ----
-threshold       DB      99          ; default threshold (10 s)
 alarm_on        DB      0
+threshold       DW      DEFAULT_THRESHOLD   ; packed BCD mm:ss
 blink_count     DW      0
 
 ; ---- Flags for Main Loop ----
@@ -65,6 +101,21 @@ digit_buffer    DB      0, 0        ; two digits
 ; ---- LED shadow (ACTIVE-LOW: 0=ON, 1=OFF) ----
 leds            DB      0FFh
 
+; ---- Seven-segment burst: (address, data) pairs for BusWriteBurst ----
+seg_burst       DW      SEG_LOW, 0
+                DW      SEG_HIGH, 0
+
+#if KEYPAD_POLL
+; ---- Keypad Poll ----
+key_poll_ms     DW      0           ; ms since the last keypad poll
+g_key_last      DB      0           ; last raw code (edge suppress)
+#else
+; ---- Keypad Deadline ----
+key_state       DB      0           ; KEY_IDLE..KEY_RELEASE_WAIT
+key_deadline    DB      0           ; ms until Keypad_Deadline (0 = none)
+key_held        DB      0           ; raw code of the key down
+#endif
+
 ; ---- Seven-Segment Lookup Table (0..9) ----
 SegmentLookup   DB      40h, 79h, 24h, 30h, 19h
                 DB      12h, 02h, 78h, 00h, 18h
@@ -73,20 +124,71 @@ SegmentLookup   DB      40h, 79h, 24h, 30h, 19h
 KeypadLookup    DB      82h, 11h, 12h, 14h, 21h
                 DB      22h, 24h, 41h, 42h, 44h
 
-; ---- LCD buffers and constant strings (16 chars each line) ----
-lcd_line1       DB      '                '
-lcd_line2       DB      '                '
-
-str_enter_thr   DB      'Enter threshold:'
-str_press_09    DB      '  Press 0-9     '
-str_thresh      DB      'Thresh: '
-str_2nd_digit   DB      'Enter 2nd digit:'
-str_threshold   DB      'Threshold: '
-str_press_s3    DB      'Press S3 to run '
-str_timing      DB      'Timing: '
-str_elapsed     DB      'Elapsed: '
-str_limit       DB      'Limit: '
-str_exceeded    DB      'EXCEEDED! '
+; =====================================================================
+; Screens (flash): a 2x16 frame and the fields LCD_Screen patches into it.
+; The static text goes from here to the display without a copy; a new
+; screen is one more entry below.
+; =====================================================================
+            RSEG        DATA16_C
+
+; LcdScreen (lcd.h): DW text, DW fields, DB field count, DB pad
+SCREEN_SIZE     EQU     6
+; Field sources, rendered by ScreenField
+FIELD_ELAPSED   EQU     0           ; "mm:ss", or "hh:mm:ss" in an 8-wide field
+FIELD_THRESHOLD EQU     1           ; "mm:ss"
+FIELD_DIGIT     EQU     2           ; first digit entered and '_'
+
+scr_prompt      DW      txt_prompt, 0
+                DB      0, 0
+scr_digit       DW      txt_digit, fld_digit
+                DB      1, 0
+scr_ready       DW      txt_ready, fld_ready
+                DB      1, 0
+; Each hh:mm:ss screen follows its mm:ss form (see ShowTimeScreen)
+scr_timing      DW      txt_timing, fld_timing
+                DB      2, 0
+                DW      txt_timing_h, fld_hours
+                DB      2, 0
+scr_exceeded    DW      txt_exceeded, fld_exceeded
+                DB      2, 0
+                DW      txt_exceeded_h, fld_hours
+                DB      2, 0
+scr_elapsed     DW      txt_elapsed, fld_elapsed
+                DB      1, 0
+                DW      txt_elapsed_h, fld_elapsed_h
+                DB      1, 0
+
+; Text under a field is never shown; it documents the layout
+txt_prompt      DB      '  Press 0-9     '
+                DB      'Enter threshold:'
+txt_digit       DB      'Thresh: d_      '
+                DB      'Enter 2nd digit:'
+txt_ready       DB      'Threshold: mm:ss'
+                DB      'Press S3 to run '
+txt_timing      DB      'Timing: mm:ss   '
+                DB      'Limit: mm:ss    '
+txt_timing_h    DB      'Timing: hh:mm:ss'
+                DB      'Limit: mm:ss    '
+txt_exceeded    DB      'EXCEEDED! mm:ss '
+                DB      'Limit: mm:ss    '
+txt_exceeded_h  DB      'EXCEED! hh:mm:ss'
+                DB      'Limit: mm:ss    '
+txt_elapsed     DB      'Elapsed: mm:ss  '
+                DB      'Enter threshold:'
+txt_elapsed_h   DB      'Elapsed hh:mm:ss'
+                DB      'Enter threshold:'
+
+; LcdField (lcd.h): DB cell (16-31 = line 2), DB width, DB source
+fld_digit       DB      8, 2, FIELD_DIGIT
+fld_ready       DB      11, 5, FIELD_THRESHOLD
+fld_timing      DB      8, 5, FIELD_ELAPSED
+                DB      23, 5, FIELD_THRESHOLD
+fld_exceeded    DB      10, 5, FIELD_ELAPSED
+                DB      23, 5, FIELD_THRESHOLD
+fld_hours       DB      8, 8, FIELD_ELAPSED
+                DB      23, 5, FIELD_THRESHOLD
+fld_elapsed     DB      9, 5, FIELD_ELAPSED
+fld_elapsed_h   DB      8, 8, FIELD_ELAPSED
 
 ; =====================================================================
 ; Code Segment
@@ -98,11 +200,13 @@ str_exceeded    DB      'EXCEEDED! '
 main:
             ; Board / LCD init
             CALLA       #Initial
-            CALL        #LCD_Init
+            CALLA       #LCD_Init
 
             ; Clear states
             MOV.W       #0,      ms_count
+            MOV.W       #0,      tick_frac
             MOV.W       #0,      seconds
+            MOV.B       #0,      hours
             MOV.B       #0,      timing
             MOV.B       #0,      alarm_on
             MOV.W       #0,      blink_count
@@ -115,21 +219,31 @@ main:
             MOV.B       #0,      flag_blink
             MOV.B       #0,      lcd_refresh
             MOV.B       #0FFh,   leds
+#if KEYPAD_POLL
+            MOV.B       #0,      g_key_last
+            MOV.W       #0,      key_poll_ms
+#else
+            MOV.B       #KEY_IDLE, key_state
+            MOV.B       #0,      key_deadline
+            MOV.B       #0,      key_held
+#endif
 
             ; Initial displays
             MOV.B       #0, R12
             CALL        #UpdateDisplay
             CALL        #UpdateLEDs
 
-            ; ---- Keypad GPIO IRQ on P2.0 ----
+            ; ---- Keypad data-available line on P2.0 ----
             BIC.B       #01h, &P2DIR        ; P2.0 input
             BIC.B       #01h, &P2REN        ; no pull
+#if !KEYPAD_POLL
             BIC.B       #01h, &P2IES        ; rising edge (key press)
             BIC.B       #01h, &P2IFG        ; clear flag
             BIS.B       #01h, &P2IE         ; enable IRQ
+#endif
 
-            ; ---- Timer A0: 1ms tick (SMCLK = 25 MHz) ----
-            MOV.W       #24999, &TA0CCR0
+            ; ---- Timer A0: 1ms tick (period from clock.h) ----
+            MOV.W       #(CLOCK_TICK_CYCLES-1), &TA0CCR0
             MOV.W       #CCIE,  &TA0CCTL0
             MOV.W       #TASSEL_2|MC_1|TACLR, &TA0CTL
 
@@ -158,6 +272,7 @@ MainLoop:
             ; ---- Rising: start timing ----
             MOV.W       #0,  ms_count
             MOV.W       #0,  seconds
+            MOV.B       #0,  hours
             MOV.B       #1,  timing
             MOV.B       #0,  alarm_on
             BIS.B       #LED_D0, leds       ; D0 OFF (active-low)
@@ -179,10 +294,12 @@ CheckFall:
             CALL        #UpdateLEDs
             CALL        #ShowElapsedStatus
 
+#if RESET_ON_STOP
             ; Reset keypad threshold entry state
             MOV.B       #0, digit_count
             MOV.B       #0, digit_buffer
             MOV.B       #0, digit_buffer+1
+#endif
 
 UpdateS3Last:
             MOV.B       s3_debounced, s3_last
@@ -193,8 +310,15 @@ CheckSecond:
             JZ          CheckBlinkFlag
             MOV.B       #0, flag_second
 
-            ; Update SSD with seconds
-            MOV.W       seconds, R12
+            ; Update SSD with the top field in use (ss, then mm, then hh)
+            MOV.B       hours, R12
+            TST.B       R12
+            JNZ         SecondDigits
+            MOV.B       seconds+1, R12
+            TST.B       R12
+            JNZ         SecondDigits
+            MOV.B       seconds, R12
+SecondDigits:
             CALL        #UpdateDisplay
 
             ; Update LCD while timing
@@ -203,11 +327,12 @@ CheckSecond:
             CALL        #ShowTimingStatus
 
 CheckAlarmSecond:
-            ; Threshold check (byte compare: seconds >= threshold?)
-            MOV.B       threshold, R13
-            MOV.B       seconds,   R12
-            CMP.B       R13, R12
-            JL          CheckBlinkFlag
+            ; Threshold check: hh:mm:ss >= mm:ss (packed BCD orders like binary)
+            TST.B       hours
+            JNZ         ThresholdReached
+            CMP.W       threshold, seconds
+            JLO         CheckBlinkFlag
+ThresholdReached:
 
             ; Threshold exceeded
             CMP.B       #0, alarm_on
@@ -228,11 +353,19 @@ CheckBlinkFlag:
 
 CheckLCDRefresh:
             CMP.B       #0, lcd_refresh
-            JZ          MainLoop
+            JZ          CheckLCDDone
             MOV.B       #0, lcd_refresh
             CALL        #UpdateLCDStatus
             JMP         MainLoop
 
+CheckLCDDone:
+            ; LCD queue drained - send frame changes that did not fit earlier
+            CMP.B       #0, lcd_done
+            JZ          MainLoop
+            MOV.B       #0, lcd_done
+            CALLA       #LCD_Service
+            JMP         MainLoop
+
 ; ---------------------------------------------------------------------
 ; TIMER0_A0 ISR - 1ms tick 
 ; ---------------------------------------------------------------------
@@ -242,11 +375,41 @@ TIMER0_A0_ISR:
             PUSH.W      R12
             PUSH.W      R13
             PUSH.W      R14
+            PUSH.W      R15
+
+            ; ---- Tick length: one cycle longer CLOCK_TICK_FRAC times in 1000 ----
+            MOV.W       #(CLOCK_TICK_CYCLES-1), &TA0CCR0
+            ADD.W       #CLOCK_TICK_FRAC, tick_frac
+            CMP.W       #1000, tick_frac
+            JLO         Tick_Set
+            SUB.W       #1000, tick_frac
+            MOV.W       #CLOCK_TICK_CYCLES, &TA0CCR0
+Tick_Set:
+
+#if !KEYPAD_POLL
+            ; ---- Keypad deadline armed by PORT2_ISR ----
+            TST.B       key_deadline
+            JZ          Tick_Watchdog
+            DEC.B       key_deadline
+            JNZ         Tick_Watchdog
+            CALL        #Keypad_Deadline    ; clobbers R12-R15
+            CMP.B       #0, lcd_refresh
+            JZ          Tick_Watchdog
+            BIC.W       #LPM0, 8(SP)       ; wake main for the LCD
+#endif
+
+Tick_Watchdog:
+            ; ---- LCD link: end a stuck transfer, time the rest after an error ----
+            MOV.B       #1, R12
+            CALLA       #I2C_Watchdog       ; clobbers R13-R15
+            TST.B       R12
+            JZ          S3_Read
+            BIC.W       #LPM0, 8(SP)       ; wake main: lcd_done is set
 
             ; ---- Read S3 ----
-            MOV.W       #SWITCHES_ADDR, BusAddress
-            CALLA       #BusRead
-            MOV.W       BusData, R12
+S3_Read:
+            MOV.W       #SWITCHES_ADDR, R12
+            CALLA       #BusReadAt          ; clobbers R13-R15
             AND.B       #SWITCH_S3_BIT, R12
             JZ          S3_Off
             MOV.B       #1, R13
@@ -273,7 +436,7 @@ S3_CheckStable:
             JZ          UpdateD7
             MOV.B       s3_raw, s3_debounced
             MOV.B       #1, flag_switch
-            BIC.W       #LPM0, 6(SP)       ; wake main
+            BIC.W       #LPM0, 8(SP)       ; wake main
 
 UpdateD7:
             ; Mirror S3 onto D7 (active-low shadow)
@@ -293,13 +456,28 @@ TimeKeep:
             CMP.W       #1000, ms_count
             JL          AfterSecond
 
-            ; one second elapsed
+            ; one second elapsed: packed BCD, a field at 60 gets +40 to roll
+            ; to 00 and carry; 99:59:59 holds
             MOV.W       #0, ms_count
-            CMP.W       #99, seconds
-            JGE         AfterSecond
-            INC.W       seconds
+            SETC
+            DADC.W      seconds             ; ss + 1
+            CMP.B       #60h, seconds
+            JNE         SecondDone
+            CLRC
+            DADD.W      #40h, seconds       ; ss 60 -> 00, mm + 1
+            CMP.W       #6000h, seconds
+            JNE         SecondDone
+            CMP.B       #99h, hours
+            JEQ         SecondMax
+            MOV.W       #0, seconds         ; mm 60 -> 00, hh + 1
+            SETC
+            DADC.B      hours
+            JMP         SecondDone
+SecondMax:
+            MOV.W       #5959h, seconds
+SecondDone:
             MOV.B       #1, flag_second
-            BIC.W       #LPM0, 6(SP)       ; wake main
+            BIC.W       #LPM0, 8(SP)       ; wake main
 
 AfterSecond:
 
@@ -313,70 +491,111 @@ BlinkCheck:
             MOV.W       #0, blink_count
             XOR.B       #LED_D0, leds       ; toggle D0 (active-low)
             MOV.B       #1, flag_blink
-            BIC.W       #LPM0, 6(SP)       ; wake main
+            BIC.W       #LPM0, 8(SP)       ; wake main
             JMP         WriteLEDs
 
 EnsureD0Off:
             BIS.B       #LED_D0, leds       ; force OFF when no alarm
 
+#if KEYPAD_POLL
+            ; ---- Keypad poll every KEY_POLL_MS: act on a new code ----
+            INC.W       key_poll_ms
+            CMP.W       #KEY_POLL_MS, key_poll_ms
+            JL          WriteLEDs
+            MOV.W       #0, key_poll_ms
+            CLR.W       R12                 ; no key unless P2.0 says so
+            BIT.B       #01h, &P2IN
+            JZ          KeyPollSample
+            MOV.W       #KEYPAD_ADDR, R12
+            CALLA       #BusReadAt          ; clobbers R13-R15
+KeyPollSample:
+            CMP.B       R12, g_key_last     ; edge-suppress repeats
+            JEQ         WriteLEDs
+            MOV.B       R12, g_key_last
+            TST.B       R12                 ; released
+            JZ          WriteLEDs
+            CALL        #Keypad_HandleRaw
+            CMP.B       #0, lcd_refresh
+            JZ          WriteLEDs
+            BIC.W       #LPM0, 8(SP)       ; wake main for the LCD
+#endif
+
 WriteLEDs:
-            ; NO KEYPAD POLLING HERE - THIS WAS THE BUG!
             CALL        #UpdateLEDs
 
+            POP.W       R15
             POP.W       R14
             POP.W       R13
             POP.W       R12
             RETI
 
+#if !KEYPAD_POLL
 ; ---------------------------------------------------------------------
-; PORT2 ISR (keypad IRQ and Debouncing)
+; PORT2 ISR (keypad edge): only arms the deadline; TIMER0_A0_ISR reads the
+; key when it expires. P2.0 stays masked until then, so bounces cost nothing.
 ; ---------------------------------------------------------------------
             RSEG        CODE
             EVEN
 PORT2_ISR:
-            PUSH.W      R12
-            PUSH.W      R13
-            PUSH.W      R14
-            
-            ; Clear IFG immediately
             BIC.B       #01h, &P2IFG
+            BIC.B       #01h, &P2IE
+            CMP.B       #KEY_DOWN, key_state
+            JEQ         P2_Release
+            MOV.B       #KEY_PRESS_WAIT, key_state      ; rising edge: a press
+            MOV.B       #KEY_PRESS_MS, key_deadline
+            RETI
+P2_Release:
+            MOV.B       #KEY_RELEASE_WAIT, key_state    ; falling edge: a release
+            MOV.B       #KEY_RELEASE_MS, key_deadline
+            RETI
 
-            ; Longer debounce delay for more stability
-            MOV.W       #5000, R12
-P2_Delay:   DEC.W       R12
-            JNZ         P2_Delay
-
-            ; Read keypad
-            MOV.W       #KEYPAD_ADDR, BusAddress
-            CALLA       #BusRead
-            MOV.B       BusData, R12
-
-            ; Ignore zero (no key)
-            CMP.B       #0, R12
-            JZ          P2_Done
-
-            ; Decode & update threshold
+; ---------------------------------------------------------------------
+; Keypad deadline (from TIMER0_A0_ISR), the state machine of main_all.c:
+;   KEY_PRESS_WAIT    P2.0 still high -> read and act on the key, listen
+;                     for the release (P2IES falling)
+;   KEY_RELEASE_WAIT  P2.0 still low -> released, listen for the next press;
+;                     high again -> a bounce, or the next key already down
+;                     (a different code: act on it)
+; A P2IES change can raise P2IFG by itself and the level may have moved
+; already, so each listen checks P2.0 by hand. Clobbers R12-R15.
+; ---------------------------------------------------------------------
+Keypad_Deadline:
+            BIT.B       #01h, &P2IN
+            JZ          KD_Idle             ; low: glitch, or released
+            MOV.W       #KEYPAD_ADDR, R12
+            CALLA       #BusReadAt          ; clobbers R13-R15
+            CMP.B       #KEY_PRESS_WAIT, key_state
+            JEQ         KD_Press
+            CMP.B       R12, key_held       ; still the key down: a bounce
+            JEQ         KD_Down
+KD_Press:
+            MOV.B       R12, key_held
             CALL        #Keypad_HandleRaw
 
-            ; Wake main for LCD update if needed
-            CMP.B       #0, lcd_refresh
-            JZ          P2_WaitRelease
-            BIC.W       #LPM0, 6(SP)
-
-P2_WaitRelease:
-            ; Wait for key release (important!)
-            MOV.W       #10000, R12
-P2_RDelay:  DEC.W       R12
-            JNZ         P2_RDelay
-            
-            ; Clear flag again after release delay
+KD_Down:
+            MOV.B       #KEY_DOWN, key_state
+            BIS.B       #01h, &P2IES        ; falling edge (release)
             BIC.B       #01h, &P2IFG
+            BIT.B       #01h, &P2IN
+            JNZ         KD_Listen
+            MOV.B       #KEY_RELEASE_WAIT, key_state    ; released already
+            MOV.B       #KEY_RELEASE_MS, key_deadline
+            RET
 
-P2_Done:
-            POP.W       R14
-            POP.W       R13
-            POP.W       R12
-            RETI
+KD_Idle:
+            MOV.B       #KEY_IDLE, key_state
+            BIC.B       #01h, &P2IES        ; rising edge (press)
+            BIC.B       #01h, &P2IFG
+            BIT.B       #01h, &P2IN
+            JZ          KD_Listen
+            MOV.B       #KEY_PRESS_WAIT, key_state      ; pressed again already
+            MOV.B       #KEY_PRESS_MS, key_deadline
+            RET
+
+KD_Listen:
+            BIS.B       #01h, &P2IE
+            RET
+#endif
 
 ; ---------------------------------------------------------------------
 ; Keypad decode helper
@@ -419,22 +638,22 @@ KP_Second:
             ; Second digit
             MOV.B       R13, digit_buffer+1
 
-            ; threshold = (d0*10 + d1), clamped to 1..99
-            MOV.B       digit_buffer, R14   ; d0
-            MOV.B       #10, R15
-            CALL        #Multiply8          ; R12 = d0 * 10
+            ; threshold = d0 d1 seconds as packed BCD mm:ss, at least 00:01
+            MOV.B       digit_buffer, R12
+            RLA.B       R12
+            RLA.B       R12
+            RLA.B       R12
+            RLA.B       R12                 ; d0 -> tens nibble
             ADD.B       digit_buffer+1, R12 ; + d1
-            
-            ; clamp to 1..99
-            CMP.B       #100, R12
-            JL          KP_ClampLo
-            MOV.B       #99, R12
-KP_ClampLo:
-            CMP.B       #0, R12
-            JNZ         KP_Store
+            JNZ         KP_Minutes
             MOV.B       #1, R12
+KP_Minutes:
+            CMP.W       #60h, R12
+            JLO         KP_Store
+            CLRC
+            DADD.W      #40h, R12           ; 60-99 s -> 01:00-01:39
 KP_Store:
-            MOV.B       R12, threshold
+            MOV.W       R12, threshold
             MOV.B       #2, digit_count
             MOV.B       #1, lcd_refresh
 
@@ -451,210 +670,137 @@ KP_Exit:
 ; Update LEDs from shadow (active-low)
 UpdateLEDs:
             PUSH.W      R12
-            MOV.W       #LED_ADDR, BusAddress
-            MOV.B       leds, R12
-            MOV.W       R12, BusData
-            CALLA       #BusWrite
+            PUSH.W      R13
+            PUSH.W      R14
+            PUSH.W      R15
+            MOV.W       #LED_ADDR, R12
+            MOV.B       leds, R13
+            CALLA       #BusWriteAt         ; clobbers R14, R15
+            POP.W       R15
+            POP.W       R14
+            POP.W       R13
             POP.W       R12
             RET
 
-; Update 7-seg display with R12 (0..99)
+; Update 7-seg display with R12 (packed BCD 00..99), both digits in one bus burst
 UpdateDisplay:
             PUSH.W      R12
             PUSH.W      R13
             PUSH.W      R14
+            PUSH.W      R15
 
-            AND.W       #00FFh, R12
-            CMP.B       #100, R12
-            JL          Disp_OK
-            MOV.B       #99, R12
-Disp_OK:
-            ; tens = R12/10, ones = R12%10
-            MOV.B       #10, R13
-            CALL        #Divide8            ; R12=quot, R13=rem
-
-            ; ones -> SEG_LOW
-            MOV.W       #SEG_LOW, BusAddress
+            ; ones nibble -> SEG_LOW
+            MOV.W       R12, R13
             AND.W       #000Fh, R13
-            MOV.W       #SegmentLookup, R14
-            ADD.W       R13, R14
-            MOV.B       @R14, R13
-            MOV.W       R13, BusData
-            CALLA       #BusWrite
-
-            ; tens -> SEG_HIGH
-            MOV.W       #SEG_HIGH, BusAddress
-            AND.W       #000Fh, R12
-            MOV.W       #SegmentLookup, R14
-            ADD.W       R12, R14
-            MOV.B       @R14, R13
-            MOV.W       R13, BusData
-            CALLA       #BusWrite
+            MOV.B       SegmentLookup(R13), R13
+            MOV.W       R13, seg_burst+2
+
+            ; tens nibble -> SEG_HIGH
+            MOV.W       R12, R13
+            AND.W       #00F0h, R13
+            RRA.W       R13
+            RRA.W       R13
+            RRA.W       R13
+            RRA.W       R13
+            MOV.B       SegmentLookup(R13), R13
+            MOV.W       R13, seg_burst+6
+
+            ; commit both digits (clobbers R12, R13, R15)
+            MOV.W       #seg_burst, R12
+            MOV.W       #2, R13
+            CALLA       #BusWriteBurst
 
+            POP.W       R15
             POP.W       R14
             POP.W       R13
             POP.W       R12
             RET
 
-; 8-bit multiply: R12 = R14 * R15
-Multiply8:
+; Two packed-BCD digits (low byte of R13) as ASCII at R12
+; R12 ends up past them; R13 is clobbered
+PutBCD:
             PUSH.W      R13
-            MOV.B       R14, R12
-            MOV.B       #0,  R13
-MulClr:     CMP.B       #0, R15
-            JEQ         MulDone
-            ADD.B       R12, R13
-            DEC.B       R15
-            JMP         MulClr
-MulDone:    MOV.B       R13, R12
+            AND.W       #00F0h, R13
+            RRA.W       R13
+            RRA.W       R13
+            RRA.W       R13
+            RRA.W       R13
+            ADD.B       #'0', R13
+            MOV.B       R13, 0(R12)
             POP.W       R13
+            AND.W       #000Fh, R13
+            ADD.B       #'0', R13
+            MOV.B       R13, 1(R12)
+            INCD.W      R12
             RET
 
-; 8-bit divide: Input R12=dividend, R13=divisor
-; Output: R12=quotient, R13=remainder
-Divide8:
-            PUSH.W      R14
-            PUSH.W      R15
-            MOV.B       R12, R14        ; dividend
-            MOV.B       R13, R15        ; divisor
-            MOV.B       #0,  R12        ; quotient
-DivLoop:
-            CMP.B       R15, R14
-            JLO         DivDone
-            SUB.B       R15, R14
-            INC.B       R12
-            JMP         DivLoop
-DivDone:
-            MOV.B       R14, R13        ; remainder
-            POP.W       R15
-            POP.W       R14
+; Packed-BCD mm:ss in R13 as "mm:ss" at R12 (R12 ends up past it)
+PutMinSec:
+            PUSH.W      R13
+            SWPB        R13
+            CALL        #PutBCD             ; minutes
+            MOV.B       #':', 0(R12)
+            INC.W       R12
+            POP.W       R13
+            CALL        #PutBCD             ; seconds
             RET
 
 ; ---------------------------------------------------------------------
 ; LCD Functions
 ; ---------------------------------------------------------------------
 
-LCD_Init:
-            PUSH.W      R12
-            PUSH.W      R13
-
-            BIS.B       #UCSWRST, &UCB1CTL1
-            MOV.B       #UCMST|UCMODE_3|UCSYNC, &UCB1CTL0
-            MOV.B       #UCSSEL_1|UCSWRST,  &UCB1CTL1
-            MOV.B       #63,               &UCB1BR0
-            MOV.W       #003Eh,            &UCB1I2CSA
-            BIS.B       #06h,              &P4SEL
-            BIC.B       #UCSWRST,          &UCB1CTL1
-
-            BIS.B       #UCTR|UCTXSTT,     &UCB1CTL1
-WaitTX1:    BIT.B       #UCTXIFG,          &UCB1IFG
-            JZ          WaitTX1
-            MOV.B       #00h,              &UCB1TXBUF
-WaitTX2:    BIT.B       #UCTXIFG,          &UCB1IFG
-            JZ          WaitTX2
-            MOV.B       #39h,              &UCB1TXBUF
-WaitTX3:    BIT.B       #UCTXIFG,          &UCB1IFG
-            JZ          WaitTX3
-            MOV.B       #14h,              &UCB1TXBUF
-WaitTX4:    BIT.B       #UCTXIFG,          &UCB1IFG
-            JZ          WaitTX4
-            MOV.B       #74h,              &UCB1TXBUF
-WaitTX5:    BIT.B       #UCTXIFG,          &UCB1IFG
-            JZ          WaitTX5
-            MOV.B       #54h,              &UCB1TXBUF
-WaitTX6:    BIT.B       #UCTXIFG,          &UCB1IFG
-            JZ          WaitTX6
-            MOV.B       #6Fh,              &UCB1TXBUF
-WaitTX7:    BIT.B       #UCTXIFG,          &UCB1IFG
-            JZ          WaitTX7
-            MOV.B       #0Eh,              &UCB1TXBUF
-WaitTX8:    BIT.B       #UCTXIFG,          &UCB1IFG
-            JZ          WaitTX8
-            MOV.B       #01h,              &UCB1TXBUF
-WaitTX9:    BIT.B       #UCTXIFG,          &UCB1IFG
-            JZ          WaitTX9
-            BIS.B       #UCTXSTP,          &UCB1CTL1
-WaitSTP1:   BIT.B       #UCTXSTP,          &UCB1CTL1
-            JNZ         WaitSTP1
-            BIC.B       #UCTXIFG,          &UCB1IFG
-
-            MOV.W       #10000, R12
-InitDelay:  DEC.W       R12
-            JNZ         InitDelay
-
-            POP.W       R13
-            POP.W       R12
-            RET
-
-LCD_SendBoth:
-            CALL        #LCD_SendLine1
-            CALL        #LCD_SendLine2
-            RET
-
-LCD_SendLine1:
-            PUSH.W      R12
-            PUSH.W      R13
-
-            BIS.B       #UCTR|UCTXSTT, &UCB1CTL1
-W1_1:       BIT.B       #UCTXIFG, &UCB1IFG
-            JZ          W1_1
-            MOV.B       #80h,  &UCB1TXBUF
-W1_2:       BIT.B       #UCTXIFG, &UCB1IFG
-            JZ          W1_2
-            MOV.B       #80h,  &UCB1TXBUF
-W1_3:       BIT.B       #UCTXIFG, &UCB1IFG
-            JZ          W1_3
-            MOV.B       #40h,  &UCB1TXBUF
-W1_4:       BIT.B       #UCTXIFG, &UCB1IFG
-            JZ          W1_4
-
-            MOV.W       #lcd_line1, R13
-            MOV.B       #16, R12
-W1_Loop:    MOV.B       @R13+, &UCB1TXBUF
-W1_D:       BIT.B       #UCTXIFG, &UCB1IFG
-            JZ          W1_D
-            DEC.B       R12
-            JNZ         W1_Loop
-
-            BIS.B       #UCTXSTP, &UCB1CTL1
-W1_S:       BIT.B       #UCTXSTP, &UCB1CTL1
-            JNZ         W1_S
-            BIC.B       #UCTXIFG, &UCB1IFG
+; LCD_Screen field renderer, called from lcd.c with CALLA (so it returns
+; with RETA): R12 = source, R13 = where the field goes, R14 = its width.
+; Uses only R12-R15, which C may clobber anyway.
+ScreenField:
+            MOV.W       R12, R15
+            MOV.W       R13, R12
+            CMP.B       #FIELD_THRESHOLD, R15
+            JEQ         SF_Threshold
+            CMP.B       #FIELD_DIGIT, R15
+            JEQ         SF_Digit
+            CMP.B       #8, R14             ; FIELD_ELAPSED: 8 wide = hh:mm:ss
+            JNE         SF_MinSec
+            MOV.B       hours, R13
+            CALL        #PutBCD
+            MOV.B       #':', 0(R12)
+            INC.W       R12
+SF_MinSec:
+            MOV.W       seconds, R13
+            CALL        #PutMinSec
+            RETA
 
-            POP.W       R13
-            POP.W       R12
-            RET
+SF_Threshold:
+            MOV.W       threshold, R13
+            CALL        #PutMinSec
+            RETA
 
-LCD_SendLine2:
+SF_Digit:
+            MOV.B       digit_buffer, R13
+            ADD.B       #'0', R13
+            MOV.B       R13, 0(R12)
+            MOV.B       #'_', 1(R12)
+            RETA
+
+; Screen at R12 in its mm:ss form, or the hh:mm:ss form after it once the
+; hours are running. Falls through to ShowScreen.
+ShowTimeScreen:
+            TST.B       hours
+            JZ          ShowScreen
+            ADD.W       #SCREEN_SIZE, R12
+
+; Show the screen at R12 through the shared LCD layer (lcd.c). Only the
+; characters that differ from what the display holds go out over I2C, and
+; the transfer itself is interrupt-driven. C may clobber R12-R15.
+ShowScreen:
             PUSH.W      R12
             PUSH.W      R13
-
-            BIS.B       #UCTR|UCTXSTT, &UCB1CTL1
-W2_1:       BIT.B       #UCTXIFG, &UCB1IFG
-            JZ          W2_1
-            MOV.B       #80h,  &UCB1TXBUF
-W2_2:       BIT.B       #UCTXIFG, &UCB1IFG
-            JZ          W2_2
-            MOV.B       #0C0h, &UCB1TXBUF
-W2_3:       BIT.B       #UCTXIFG, &UCB1IFG
-            JZ          W2_3
-            MOV.B       #40h,  &UCB1TXBUF
-W2_4:       BIT.B       #UCTXIFG, &UCB1IFG
-            JZ          W2_4
-
-            MOV.W       #lcd_line2, R13
-            MOV.B       #16, R12
-W2_Loop:    MOV.B       @R13+, &UCB1TXBUF
-W2_D:       BIT.B       #UCTXIFG, &UCB1IFG
-            JZ          W2_D
-            DEC.B       R12
-            JNZ         W2_Loop
-
-            BIS.B       #UCTXSTP, &UCB1CTL1
-W2_S:       BIT.B       #UCTXSTP, &UCB1CTL1
-            JNZ         W2_S
-            BIC.B       #UCTXIFG, &UCB1IFG
-
+            PUSH.W      R14
+            PUSH.W      R15
+            MOV.W       #ScreenField, R13
+            CALLA       #LCD_Screen
+            POP.W       R15
+            POP.W       R14
             POP.W       R13
             POP.W       R12
             RET
@@ -664,199 +810,34 @@ W2_S:       BIT.B       #UCTXSTP, &UCB1CTL1
 ; ---------------------------------------------------------------------
 
 ShowThresholdPrompt:
-            CALL        #ClearLCDBuffers
-            MOV.W       #lcd_line1, R12
-            MOV.W       #str_press_09, R13
-            MOV.B       #16, R14
-            CALL        #CopyString
-            MOV.W       #lcd_line2, R12
-            MOV.W       #str_enter_thr, R13
-            MOV.B       #16, R14
-            CALL        #CopyString
-            CALL        #LCD_SendBoth
+            MOV.W       #scr_prompt, R12
+            CALL        #ShowScreen
             RET
 
 UpdateLCDStatus:
-            CALL        #ClearLCDBuffers
-            CMP.B       #0, digit_count
-            JNZ         UL_1st
-            CALL        #ShowThresholdPrompt
-            RET
-
-UL_1st:
+            MOV.W       #scr_prompt, R12
             CMP.B       #1, digit_count
-            JNZ         UL_Done
-
-            MOV.W       #lcd_line1, R12
-            MOV.W       #str_thresh, R13
-            MOV.B       #8, R14
-            CALL        #CopyString
-
-            MOV.B       digit_buffer, R13
-            ADD.B       #'0', R13
-            MOV.B       R13, lcd_line1+8
-            MOV.B       #'_', lcd_line1+9
-
-            MOV.W       #lcd_line2, R12
-            MOV.W       #str_2nd_digit, R13
-            MOV.B       #16, R14
-            CALL        #CopyString
-            CALL        #LCD_SendBoth
-            RET
-
-UL_Done:
-            MOV.W       #lcd_line1, R12
-            MOV.W       #str_threshold, R13
-            MOV.B       #11, R14
-            CALL        #CopyString
-
-            MOV.B       threshold, R12
-            MOV.B       #10, R13
-            CALL        #Divide8
-            ADD.B       #'0', R12
-            MOV.B       R12, lcd_line1+11
-            ADD.B       #'0', R13
-            MOV.B       R13, lcd_line1+12
-            MOV.B       #'s', lcd_line1+13
-
-            MOV.W       #lcd_line2, R12
-            MOV.W       #str_press_s3, R13
-            MOV.B       #16, R14
-            CALL        #CopyString
-            CALL        #LCD_SendBoth
+            JLO         UL_Show
+            MOV.W       #scr_digit, R12
+            JEQ         UL_Show
+            MOV.W       #scr_ready, R12
+UL_Show:
+            CALL        #ShowScreen
             RET
 
 ShowTimingStatus:
-            CALL        #ClearLCDBuffers
-
-            MOV.W       #lcd_line1, R12
-            MOV.W       #str_timing, R13
-            MOV.B       #8, R14
-            CALL        #CopyString
-
-            MOV.W       seconds, R12
-            MOV.B       #10, R13
-            CALL        #Divide8
-            ADD.B       #'0', R12
-            MOV.B       R12, lcd_line1+8
-            ADD.B       #'0', R13
-            MOV.B       R13, lcd_line1+9
-            MOV.B       #'s', lcd_line1+10
-
-            MOV.W       #lcd_line2, R12
-            MOV.W       #str_limit, R13
-            MOV.B       #7, R14
-            CALL        #CopyString
-
-            MOV.B       threshold, R12
-            MOV.B       #10, R13
-            CALL        #Divide8
-            ADD.B       #'0', R12
-            MOV.B       R12, lcd_line2+7
-            ADD.B       #'0', R13
-            MOV.B       R13, lcd_line2+8
-            MOV.B       #'s', lcd_line2+9
-
-            CALL        #LCD_SendBoth
+            MOV.W       #scr_timing, R12
+            CALL        #ShowTimeScreen
             RET
 
 ShowElapsedStatus:
-            CALL        #ClearLCDBuffers
-
-            MOV.W       #lcd_line1, R12
-            MOV.W       #str_elapsed, R13
-            MOV.B       #9, R14
-            CALL        #CopyString
-
-            MOV.W       seconds, R12
-            MOV.B       #10, R13
-            CALL        #Divide8
-            ADD.B       #'0', R12
-            MOV.B       R12, lcd_line1+9
-            ADD.B       #'0', R13
-            MOV.B       R13, lcd_line1+10
-            MOV.B       #'s', lcd_line1+11
-
-            MOV.W       #lcd_line2, R12
-            MOV.W       #str_enter_thr, R13
-            MOV.B       #16, R14
-            CALL        #CopyString
-
-            CALL        #LCD_SendBoth
+            MOV.W       #scr_elapsed, R12
+            CALL        #ShowTimeScreen
             RET
 
 ShowExceededStatus:
-            CALL        #ClearLCDBuffers
-
-            MOV.W       #lcd_line1, R12
-            MOV.W       #str_exceeded, R13
-            MOV.B       #10, R14
-            CALL        #CopyString
-
-            MOV.W       seconds, R12
-            MOV.B       #10, R13
-            CALL        #Divide8
-            ADD.B       #'0', R12
-            MOV.B       R12, lcd_line1+10
-            ADD.B       #'0', R13
-            MOV.B       R13, lcd_line1+11
-            MOV.B       #'s', lcd_line1+12
-
-            MOV.W       #lcd_line2, R12
-            MOV.W       #str_limit, R13
-            MOV.B       #7, R14
-            CALL        #CopyString
-
-            MOV.B       threshold, R12
-            MOV.B       #10, R13
-            CALL        #Divide8
-            ADD.B       #'0', R12
-            MOV.B       R12, lcd_line2+7
-            ADD.B       #'0', R13
-            MOV.B       R13, lcd_line2+8
-            MOV.B       #'s', lcd_line2+9
-
-            CALL        #LCD_SendBoth
-            RET
-
-ClearLCDBuffers:
-            PUSH.W      R12
-            PUSH.W      R13
-
-            MOV.W       #lcd_line1, R12
-            MOV.B       #16, R13
-CL1:        MOV.B       #' ', 0(R12)
-            INC.W       R12
-            DEC.B       R13
-            JNZ         CL1
-
-            MOV.W       #lcd_line2, R12
-            MOV.B       #16, R13
-CL2:        MOV.B       #' ', 0(R12)
-            INC.W       R12
-            DEC.B       R13
-            JNZ         CL2
-
-            POP.W       R13
-            POP.W       R12
-            RET
-
-; Copy string: R12=dest, R13=source, R14=len
-CopyString:
-            PUSH.W      R12
-            PUSH.W      R13
-            PUSH.W      R14
-CS_Loop:
-            CMP.B       #0, R14
-            JZ          CS_Done
-            MOV.B       @R13+, 0(R12)
-            INC.W       R12
-            DEC.B       R14
-            JMP         CS_Loop
-CS_Done:
-            POP.W       R14
-            POP.W       R13
-            POP.W       R12
+            MOV.W       #scr_exceeded, R12
+            CALL        #ShowTimeScreen
             RET
 
 ; =====================================================================
@@ -867,8 +848,10 @@ CS_Done:
             ORG         TIMER0_A0_VECTOR
             DW          TIMER0_A0_ISR
 
+#if !KEYPAD_POLL
             ORG         PORT2_VECTOR
             DW          PORT2_ISR
+#endif
 
             ORG         RESET_VECTOR
             DW          main
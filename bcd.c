@@ -0,0 +1,40 @@
+#include "intrinsics.h"
+#include "bcd.h"
+
+/* ========================= Tick ========================= */
+// Seconds, then minutes: a field that reaches BCD 60 gets +40, which rolls it
+// to 00 and carries one into the field above
+unsigned long Bcd_Tick(unsigned long time) {
+    if(time >= BCD_TIME_MAX) return BCD_TIME_MAX;
+
+    time = __bcd_add_long(time, 0x000001UL);
+    if((time & 0xFF) == 0x60) {
+        time = __bcd_add_long(time, 0x000040UL);
+        if((time & 0xFF00) == 0x6000) time = __bcd_add_long(time, 0x004000UL);
+    }
+    return time;
+}
+
+/* ========================= Conversions ========================= */
+static unsigned char Bcd_Value(unsigned char bcd) {
+    return (bcd >> 4) * 10 + (bcd & 0x0F);
+}
+
+static unsigned char Bcd_Byte(unsigned char value) {
+    return ((value / 10) << 4) | (value % 10);
+}
+
+unsigned long Bcd_Seconds(unsigned long time) {
+    unsigned long minutes = (unsigned long)Bcd_Value((unsigned char)(time >> 16)) * 60
+                          + Bcd_Value((unsigned char)(time >> 8));
+    return minutes * 60 + Bcd_Value((unsigned char)time);
+}
+
+unsigned long Bcd_FromSeconds(unsigned long seconds) {
+    unsigned long minutes = seconds / 60;
+
+    if(minutes / 60 > 99) return BCD_TIME_MAX;
+    return ((unsigned long)Bcd_Byte((unsigned char)(minutes / 60)) << 16)
+         | ((unsigned int)Bcd_Byte((unsigned char)(minutes % 60)) << 8)
+         | Bcd_Byte((unsigned char)(seconds % 60));
+}
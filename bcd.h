@@ -0,0 +1,24 @@
+#ifndef BCD_H
+#define BCD_H
+
+/* ========================= Packed-BCD Time =========================
+ * Times are kept in packed BCD, one decimal digit per nibble, so neither
+ * display ever divides: a nibble indexes SegmentLookup or becomes '0' + n.
+ *
+ *   elapsed time   0x00hhmmss   unsigned long, up to 99:59:59
+ *   threshold      0xmmss       unsigned int, up to 99:59
+ *
+ * Packed BCD orders the same way as binary, so elapsed >= threshold is a
+ * plain compare. Bcd_Tick() is the only arithmetic on the tick path: one
+ * DADD, and a second one (+40) when a field reaches 60.
+ */
+#define BCD_TIME_MAX    0x995959UL  // 99:59:59
+#define BCD_MMSS_MAX    0x9959      // 99:59
+
+unsigned long Bcd_Tick(unsigned long time);             // One second later; stops at BCD_TIME_MAX
+unsigned long Bcd_Seconds(unsigned long time);          // hh:mm:ss (or mm:ss) -> seconds, multiplies only
+
+// Seconds -> hh:mm:ss, saturating at BCD_TIME_MAX. Divides: not for the tick or render paths.
+unsigned long Bcd_FromSeconds(unsigned long seconds);
+
+#endif
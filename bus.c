@@ -0,0 +1,79 @@
+#include "msp430f5308.h"
+#include "intrinsics.h"
+#include "bus.h"
+#include "prof.h"
+
+/* ========================= Output Shadow Registers ========================= */
+#define BUS_OUT_COUNT   3
+#define BUS_UNKNOWN     0xFFFF      // Latch contents not known yet (forces a write)
+
+// Outputs sit at LED_ADDR + 2 * slot: LED_ADDR, SEG_LOW, SEG_HIGH
+#define BUS_OUT_SLOT(address)   (((address) - LED_ADDR) >> 1)
+
+static volatile unsigned int bus_wanted[BUS_OUT_COUNT];    // Value the application asked for
+static volatile unsigned int bus_latched[BUS_OUT_COUNT];   // Value last written to the bus
+
+volatile unsigned long bus_writes_issued;
+volatile unsigned long bus_writes_suppressed;
+
+// The counters are shared by Timer_ISR and main, and 32-bit increments are not atomic
+static void BusOut_Count(volatile unsigned long *counter) {
+    __istate_t state = __get_interrupt_state();
+    __disable_interrupt();
+    (*counter)++;
+    __set_interrupt_state(state);
+}
+
+void BusOut_Init(void) {
+    unsigned char slot;
+
+    for(slot = 0; slot < BUS_OUT_COUNT; slot++) {
+        bus_wanted[slot] = BUS_UNKNOWN;
+        bus_latched[slot] = BUS_UNKNOWN;
+    }
+    bus_writes_issued = 0;
+    bus_writes_suppressed = 0;
+}
+
+void BusOut_Set(unsigned int address, unsigned char value) {
+    unsigned char slot = BUS_OUT_SLOT(address);
+
+    // Same as the latch, or replacing a value that was never flushed: one write saved
+    if(value == bus_latched[slot] || bus_wanted[slot] != bus_latched[slot]) {
+        BusOut_Count(&bus_writes_suppressed);
+    }
+    bus_wanted[slot] = value;
+}
+
+// Main and the timer ISRs both flush: the latch bookkeeping and the burst run
+// as one critical section, so a flush from an ISR never splits another one
+unsigned char BusOut_Flush(unsigned char mask) {
+    BusXfer burst[BUS_OUT_COUNT];
+    unsigned char count = 0, written = 0;
+    unsigned char slot;
+    unsigned int value;
+    __istate_t state = __get_interrupt_state();
+
+    __disable_interrupt();
+    for(slot = 0; slot < BUS_OUT_COUNT; slot++, mask >>= 1) {
+        if(!(mask & 0x01)) continue;
+
+        value = bus_wanted[slot];
+        if(value == bus_latched[slot]) continue;
+
+        burst[count].address = LED_ADDR + (slot << 1);
+        burst[count].data = value;
+        count++;
+        bus_latched[slot] = value;
+        written |= 1 << slot;
+        BusOut_Count(&bus_writes_issued);
+    }
+
+    if(count) {
+        PROF_ENTER(PROF_BUS_WRITE);
+        BusWriteBurst(burst, count);
+        PROF_EXIT(PROF_BUS_WRITE);
+    }
+    __set_interrupt_state(state);
+    return written;
+}
@@ -0,0 +1,53 @@
+#ifndef BUS_H
+#define BUS_H
+
+/* ========================= Bus Interface (provided) ========================= */
+// Register-based entry points (address/data in R12/R13, result in R12). They use
+// no globals and are safe to call from main and from ISRs alike.
+unsigned int BusReadAt(unsigned int address);
+void BusWriteAt(unsigned int address, unsigned int data);
+
+// Legacy entry points: thin wrappers taking their arguments from these globals
+extern volatile unsigned int BusAddress, BusData;
+void BusRead(void);
+void BusWrite(void);
+
+// Several writes in one call (BusWrite.asm): address nibbles that match the
+// previous item are not re-latched, and E is pulsed once per item
+typedef struct {
+    unsigned int address;
+    unsigned int data;
+} BusXfer;
+
+void BusWriteBurst(const BusXfer *items, unsigned int count);
+
+/* ========================= Hardware Addresses ========================= */
+#define SWITCHES_ADDR   0x4000
+#define LED_ADDR        0x4002
+#define SEG_LOW         0x4004
+#define SEG_HIGH        0x4006
+#define KEYPAD_ADDR     0x4008
+
+/* ========================= Output Shadow Registers =========================
+ * Write-combining layer for the CLIC3 output latches. BusOut_Set() only records
+ * the wanted value; BusOut_Flush() commits the selected outputs whose wanted
+ * value differs from what was last written, all in one BusWriteBurst. Redundant and
+ * overwritten-before-flush writes are dropped and counted as suppressed.
+ *
+ * A flush runs as one critical section, so main and the timer ISRs may all
+ * flush any output.
+ */
+#define BUS_OUT_LED       0x01      // Flush masks
+#define BUS_OUT_SEG_LOW   0x02
+#define BUS_OUT_SEG_HIGH  0x04
+#define BUS_OUT_SEG       (BUS_OUT_SEG_LOW | BUS_OUT_SEG_HIGH)
+#define BUS_OUT_ALL       (BUS_OUT_LED | BUS_OUT_SEG)
+
+extern volatile unsigned long bus_writes_issued;
+extern volatile unsigned long bus_writes_suppressed;
+
+void BusOut_Init(void);
+void BusOut_Set(unsigned int address, unsigned char value);   // LED_ADDR, SEG_LOW or SEG_HIGH
+unsigned char BusOut_Flush(unsigned char mask);               // Returns the outputs written
+
+#endif
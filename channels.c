@@ -0,0 +1,86 @@
+#include "intrinsics.h"
+#include "channels.h"
+#include "bcd.h"
+
+Channel channels[CHANNEL_COUNT];
+volatile unsigned char channels_running;
+volatile unsigned char channels_alarm;
+volatile unsigned long channels_next_due;
+
+/* ========================= Vertical-Counter Debounce ========================= */
+// Where the sample disagrees with the state the 2-bit count goes up (cnt1 takes
+// the carry from cnt0), elsewhere it is cleared. The count wraps to 0 on the
+// DEBOUNCE_SAMPLES-th disagreeing sample in a row, which is the change.
+unsigned char Debounce8_Sample(Debounce8 *d, unsigned char sample) {
+    unsigned char delta = sample ^ d->state;
+    unsigned char toggle;
+
+    d->cnt1 = (d->cnt1 ^ d->cnt0) & delta;
+    d->cnt0 = ~d->cnt0 & delta;
+    toggle = delta & ~(d->cnt0 | d->cnt1);
+    d->state ^= toggle;
+    return toggle;
+}
+
+/* ========================= Channels ========================= */
+// Earliest due among the running channels, published with interrupts off
+// (the tick reads it, and it is 32 bits)
+static void Channels_Schedule(void) {
+    unsigned long next = 0;
+    unsigned char n, bit, found = 0;
+    __istate_t state;
+
+    for(n = 0, bit = 1; n < CHANNEL_COUNT; n++, bit <<= 1) {
+        if(!(channels_running & bit)) continue;
+        if(!found || (long)(channels[n].due - next) < 0) next = channels[n].due;
+        found = 1;
+    }
+
+    state = __get_interrupt_state();
+    __disable_interrupt();
+    channels_next_due = next;
+    __set_interrupt_state(state);
+}
+
+void Channels_Init(unsigned int threshold) {
+    unsigned char n;
+
+    for(n = 0; n < CHANNEL_COUNT; n++) channels[n].threshold = threshold;
+}
+
+void Channels_Start(unsigned char mask, unsigned long now) {
+    unsigned char n, bit;
+
+    mask &= ~channels_running;
+    for(n = 0, bit = 1; n < CHANNEL_COUNT; n++, bit <<= 1) {
+        if(!(mask & bit)) continue;
+        channels[n].elapsed = 0;
+        channels[n].due = now + CHANNEL_TICKS_PER_SECOND;
+    }
+    channels_alarm &= ~mask;
+    channels_running |= mask;
+    Channels_Schedule();
+}
+
+void Channels_Stop(unsigned char mask) {
+    channels_running &= ~mask;
+    channels_alarm &= ~mask;
+    Channels_Schedule();
+}
+
+unsigned char Channels_Due(unsigned long now) {
+    unsigned char n, bit, ticked = 0;
+    Channel *channel = channels;
+
+    for(n = 0, bit = 1; n < CHANNEL_COUNT; n++, bit <<= 1, channel++) {
+        if(!(channels_running & bit)) continue;
+        while((long)(now - channel->due) >= 0) {
+            channel->due += CHANNEL_TICKS_PER_SECOND;
+            channel->elapsed = Bcd_Tick(channel->elapsed);
+            ticked |= bit;
+        }
+        if(channel->elapsed >= channel->threshold) channels_alarm |= bit;   // Packed BCD compares like binary
+    }
+    Channels_Schedule();
+    return ticked;
+}
@@ -0,0 +1,56 @@
+#ifndef CHANNELS_H
+#define CHANNELS_H
+
+/* ========================= Stopwatch Channels (MULTI_CHANNEL=1) =========================
+ * Each of the eight switches runs its own stopwatch: switch bit n starts and
+ * stops channel n, which has its own threshold and drives LED Dn (on while the
+ * switch is on, blinking once the threshold is reached). S3 is channel 7.
+ *
+ * The switches are debounced all at once by 2-bit vertical counters: bit n of
+ * cnt0 and cnt1 is switch n's count, so a sample is six byte operations
+ * however many switches there are. A switch takes its new level once it has
+ * read it on DEBOUNCE_SAMPLES samples in a row; a sample back at the old level
+ * clears its count.
+ *
+ * The tick does not walk the channels either. Each running channel's next
+ * second falls at a tick count kept here, and main arms one wheel timer at the
+ * earliest of them (channels_next_due); Channels_Due() then advances the
+ * channels that are due, from main.
+ */
+#define CHANNEL_COUNT               8
+#define CHANNEL_TICKS_PER_SECOND    1000    // The caller's tick is 1 ms
+#define DEBOUNCE_SAMPLES            4       // Fixed by the 2-bit counters
+
+typedef struct {
+    unsigned char state;            // Debounced levels
+    unsigned char cnt0;             // Vertical counter, low bit of each switch's count
+    unsigned char cnt1;             // ...and the high bit
+} Debounce8;
+
+// One sample of all eight inputs; returns the bits whose debounced level changed
+unsigned char Debounce8_Sample(Debounce8 *d, unsigned char sample);
+#define Debounce8_Pending(d)    ((d)->cnt0 | (d)->cnt1)     // Bits part-way to a change
+
+typedef struct {
+    unsigned long elapsed;          // hh:mm:ss packed BCD: this run, or the last one
+    unsigned long due;              // Tick count of the next second while running
+    unsigned int  threshold;        // mm:ss packed BCD
+} Channel;
+
+extern Channel channels[CHANNEL_COUNT];
+extern volatile unsigned char channels_running;     // Bit n: channel n is timing
+extern volatile unsigned char channels_alarm;       // Bit n: channel n reached its threshold
+extern volatile unsigned long channels_next_due;    // Earliest due of the running channels
+
+// Every channel starts from this threshold (they start stopped at 00:00)
+void Channels_Init(unsigned int threshold);
+
+// Main only. now is the tick count the change was accepted at.
+void Channels_Start(unsigned char mask, unsigned long now);
+void Channels_Stop(unsigned char mask);
+
+// Main only: advance every running channel that is due by now (several seconds
+// if main was held off) and set the alarms. Returns the channels that ticked.
+unsigned char Channels_Due(unsigned long now);
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+/* ========================= Clock Profiles =========================
+ * One compile-time choice sets MCLK = SMCLK = ACLK (the DCO, locked by the FLL)
+ * and every timing constant below is derived from it. Select with -DCLOCK_MHZ=n:
+ *
+ *   CLOCK_MHZ   PMMCOREV   DCORSEL   Use
+ *   1           0          2         Battery: slowest, lowest core voltage
+ *   8           0          4         Battery with headroom for the LCD and bus
+ *   16          2          5         Middle ground
+ *   25          3          6         Lowest latency (the original setup)
+ *
+ * CLOCK_XT1=1 locks the FLL to a 32768 Hz crystal on XT1 instead of REFO.
+ * This header is shared by the C files and the assembly sources, so outside
+ * the C-only block it holds plain integer #defines (no suffixes or casts).
+ */
+#ifndef CLOCK_MHZ
+#define CLOCK_MHZ       25
+#endif
+#ifndef CLOCK_XT1
+#define CLOCK_XT1       0
+#endif
+
+#if CLOCK_MHZ == 1
+#define CLOCK_PMMCOREV  0           // Level 0 runs up to 8 MHz
+#define CLOCK_DCORSEL   DCORSEL_2
+#elif CLOCK_MHZ == 8
+#define CLOCK_PMMCOREV  0
+#define CLOCK_DCORSEL   DCORSEL_4
+#elif CLOCK_MHZ == 16
+#define CLOCK_PMMCOREV  2           // Level 1 stops at 12 MHz, level 2 at 20 MHz
+#define CLOCK_DCORSEL   DCORSEL_5
+#elif CLOCK_MHZ == 25
+#define CLOCK_PMMCOREV  3
+#define CLOCK_DCORSEL   DCORSEL_6   // What BIS #DCORSEL_4 onto the reset DCORSEL_2 gave
+#else
+#error "CLOCK_MHZ must be 1, 8, 16 or 25"
+#endif
+
+#define CLOCK_KHZ       (CLOCK_MHZ * 1000)
+#define CLOCK_FLLN      ((CLOCK_MHZ * 1000000 + 16384) / 32768 - 1)    // DCOCLK = (N + 1) * 32768 Hz
+
+// What the FLL actually locks to: 1015808 Hz for the 1 MHz profile (+1.6%),
+// 7995392, 15990784 and 25001984 Hz. Everything that counts time uses this;
+// CLOCK_MHZ only names the profile and sizes the busy-wait loops.
+#define CLOCK_HZ_ACTUAL ((CLOCK_FLLN + 1) * 32768)
+
+/* ========================= Derived Constants ========================= */
+// TA0 1 ms tick and the TA1 500 Hz reference on P1.7 (cycles per period).
+// A millisecond is not a whole number of cycles: the tick ISR makes
+// CLOCK_TICK_FRAC of every 1000 ticks one cycle longer, so a second is exact.
+#define CLOCK_TICK_CYCLES   (CLOCK_HZ_ACTUAL / 1000)
+#define CLOCK_TICK_FRAC     (CLOCK_HZ_ACTUAL % 1000)
+
+// I2C bit rate divider for the LCD (SMCLK): as close to the mode's rate as
+// possible without going over, and never below 4 (250 kHz at 1 MHz).
+// I2C_FAST=0 selects standard mode.
+#ifndef I2C_FAST
+#define I2C_FAST            1       // 1 = fast mode (400 kHz), 0 = standard mode (100 kHz)
+#endif
+#if I2C_FAST
+#define CLOCK_I2C_HZ        400000
+#else
+#define CLOCK_I2C_HZ        100000
+#endif
+#if CLOCK_MHZ < 2 && I2C_FAST
+#define CLOCK_I2C_DIV       4
+#else
+#define CLOCK_I2C_DIV       ((CLOCK_HZ_ACTUAL + CLOCK_I2C_HZ - 1) / CLOCK_I2C_HZ)
+#endif
+#define CLOCK_I2C_HALF_US   (500000 / CLOCK_I2C_HZ + 1)     // Half a bit, for the bit-banged recovery
+
+// Busy-wait lengths
+#define CLOCK_LOOP3_US(us)  ((us) * CLOCK_MHZ / 3 + 1)          // DEC/JNZ passes (3 cycles each)
+#ifndef __IAR_SYSTEMS_ASM__
+#define CLOCK_CYCLES_US(us) ((unsigned long)(us) * CLOCK_MHZ)   // For __delay_cycles
+#endif
+
+#endif
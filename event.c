@@ -0,0 +1,46 @@
+#include "intrinsics.h"
+#include "event.h"
+
+volatile unsigned char event_pending;
+volatile unsigned long event_latency_max[EVENT_COUNT];
+static unsigned long event_posted[EVENT_COUNT];     // Event_Now() when each went pending
+
+// Lowest set bit of a nibble (0 has none)
+static const unsigned char EventLowBit[16] = {
+    EVENT_NONE, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0
+};
+
+void Event_Post(unsigned char event) {
+    unsigned char bit = 1 << event;
+    __istate_t state = __get_interrupt_state();
+
+    __disable_interrupt();
+    if(!(event_pending & bit)) event_posted[event] = Event_Now();   // The first post is the one waiting
+    event_pending |= bit;
+    __set_interrupt_state(state);
+}
+
+unsigned char Event_Take(void) {
+    unsigned char pending, event;
+    unsigned long latency;
+    __istate_t state = __get_interrupt_state();
+
+    __disable_interrupt();
+    pending = event_pending;
+    if(!pending) {
+        __set_interrupt_state(state);
+        return EVENT_NONE;
+    }
+    if(pending & 0x0F) event = EventLowBit[pending & 0x0F];
+    else event = 4 + EventLowBit[pending >> 4];
+    event_pending = pending & (pending - 1);        // Clear the lowest bit
+    latency = Event_Now() - event_posted[event];
+    __set_interrupt_state(state);
+
+    if(latency > event_latency_max[event]) event_latency_max[event] = latency;
+    return event;
+}
+
+void Event_Clear(unsigned char event) {
+    event_pending &= ~(1 << event);
+}
@@ -0,0 +1,39 @@
+#ifndef EVENT_H
+#define EVENT_H
+
+/* ========================= Event Core =========================
+ * ISRs (the top halves) do only what cannot wait: sample, count, stamp. What
+ * follows from it is posted as an event and run by main (the bottom half).
+ * Pending events are bits of one byte, so a second post of a pending event
+ * merges into the first. Posting holds interrupts off only for the stamp and
+ * one BIS.B.
+ * Data that goes with an event stays where the ISR left it (the keypad FIFO,
+ * the debounced switch state).
+ *
+ * Bit order is priority: Event_Take() returns the lowest pending bit, found
+ * with two nibble-table reads, so main always runs the most urgent event
+ * next, whichever were posted while it was busy.
+ *
+ * Each event is stamped when it goes pending, from Event_Now() (provided by
+ * the application), and Event_Take() keeps the worst post-to-take latency per
+ * event in event_latency_max[].
+ */
+#define EVENT_COUNT     8
+#define EVENT_NONE      0xFF
+
+extern volatile unsigned char event_pending;            // Bit n: event n is waiting
+extern volatile unsigned long event_latency_max[EVENT_COUNT];   // In Event_Now() units
+
+// Application clock for the stamps, any units, called with interrupts off
+unsigned long Event_Now(void);
+
+// ISR or main
+void Event_Post(unsigned char event);
+
+// Main only: the highest-priority pending event (cleared), or EVENT_NONE
+unsigned char Event_Take(void);
+
+// Main only: drop a pending event that no longer applies (one BIC.B)
+void Event_Clear(unsigned char event);
+
+#endif
@@ -0,0 +1,893 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+
+/* ========================= IAR-Syntax Assembler =========================
+ * Enough of the IAR MSP430 assembler for the CLIC3 sources, after the C
+ * preprocessor has dealt with #include and #define:
+ *   labels in column 1 (colon optional), NAME EQU expr
+ *   PUBLIC, EXTERN, RSEG, EVEN, ORG, DB/DC8, DW/DC16, DS8/DS16, END
+ *   every MSP430 instruction and the emulated ones, CALLA #imm and RETA
+ * All sources of one image are assembled together: pass 1 sizes everything
+ * and places labels, pass 2 emits. Labels are local to their file unless
+ * PUBLIC; an EXTERN resolves to another file's PUBLIC or to a symbol the
+ * harness defined with Asm_Define().
+ */
+enum { SEG_CODE, SEG_DATA16_I, SEG_DATA16_Z, SEG_DATA16_N, SEG_DATA16_C, SEG_INTVEC, SEG_COUNT };
+
+static const struct {
+    const char *name;
+    uint32_t base, limit;
+} asm_segments[SEG_COUNT] = {
+    { "CODE",     SEG_CODE_BASE,     SEG_INTVEC_BASE },
+    { "DATA16_I", SEG_DATA16_I_BASE, SEG_DATA16_Z_BASE },
+    { "DATA16_Z", SEG_DATA16_Z_BASE, SEG_DATA16_N_BASE },
+    { "DATA16_N", SEG_DATA16_N_BASE, STACK_TOP - 0x200 },
+    { "DATA16_C", SEG_DATA16_C_BASE, SEG_CODE_BASE },
+    { "INTVEC",   SEG_INTVEC_BASE,   MEM_SIZE },
+};
+
+#define ASM_LINE_MAX    512
+#define ASM_OPERANDS    16
+
+typedef struct {
+    Image *image;
+    const char *path;
+    unsigned int line;
+    unsigned char file;
+    unsigned char pass;                 // 1 or 2
+    unsigned char seg;
+    uint32_t loc[SEG_COUNT];
+    unsigned char done;                 // END seen
+    int errors;
+    unsigned char *short_imm;           // Pass 1 decisions: immediate fits the constant generator
+    unsigned int short_count, short_cap, short_next;
+    AsmSymbol *publics;                 // PUBLIC names seen in pass 1, exported before pass 2
+    unsigned int public_count, public_cap;
+} Asm;
+
+static void Asm_Error(Asm *as, const char *message, const char *detail) {
+    if(as->errors++ < 20) fprintf(stderr, "%s:%u: %s%s%s\n", as->path, as->line, message, detail ? ": " : "", detail ? detail : "");
+}
+
+/* ========================= Symbols ========================= */
+static AsmSymbol *Sym_Find(const Image *image, const char *name, unsigned char file) {
+    unsigned int i;
+
+    for(i = 0; i < image->symbol_count; i++) {
+        if(image->symbols[i].file == file && !strcmp(image->symbols[i].name, name)) return &image->symbols[i];
+    }
+    return 0;
+}
+
+static AsmSymbol *Sym_Add(Image *image, const char *name, uint32_t value, unsigned char file) {
+    AsmSymbol *symbol;
+
+    if(image->symbol_count == image->symbol_cap) {
+        image->symbol_cap = image->symbol_cap ? 2 * image->symbol_cap : 256;
+        image->symbols = realloc(image->symbols, image->symbol_cap * sizeof *image->symbols);
+        if(!image->symbols) {
+            fprintf(stderr, "asm430: out of memory\n");
+            exit(2);
+        }
+    }
+    symbol = &image->symbols[image->symbol_count++];
+    memset(symbol, 0, sizeof *symbol);
+    snprintf(symbol->name, sizeof symbol->name, "%s", name);
+    symbol->value = value;
+    symbol->file = file;
+    return symbol;
+}
+
+void Asm_Define(Image *image, const char *name, uint32_t value) {
+    AsmSymbol *symbol = Sym_Find(image, name, ASM_HARNESS);
+
+    if(symbol) symbol->value = value;
+    else Sym_Add(image, name, value, ASM_HARNESS);
+}
+
+// File-local first, then another file's PUBLIC, then the harness
+static AsmSymbol *Sym_Resolve(const Image *image, const char *name, unsigned char file) {
+    AsmSymbol *symbol = Sym_Find(image, name, file);
+    unsigned int i;
+
+    if(symbol) return symbol;
+    for(i = 0; i < image->symbol_count; i++) {
+        if(image->symbols[i].exported && !strcmp(image->symbols[i].name, name)) return &image->symbols[i];
+    }
+    return Sym_Find(image, name, ASM_HARNESS);
+}
+
+long Asm_Lookup(const Image *image, const char *name) {
+    unsigned int i;
+
+    for(i = 0; i < image->symbol_count; i++) {
+        if(!strcmp(image->symbols[i].name, name)) return (long)image->symbols[i].value;
+    }
+    return -1;
+}
+
+void Asm_Free(Image *image) {
+    free(image->symbols);
+    image->symbols = 0;
+    image->symbol_count = image->symbol_cap = 0;
+}
+
+/* ========================= Expressions ========================= */
+// Recursive descent over C operator precedence. *defined drops to 0 when a
+// symbol is not known yet (pass 1 forward reference).
+typedef struct {
+    Asm *as;
+    const char *p;
+    int defined;
+    int bad;
+} Expr;
+
+static long Expr_Or(Expr *e);
+
+static void Expr_Space(Expr *e) {
+    while(*e->p == ' ' || *e->p == '\t') e->p++;
+}
+
+static long Expr_Number(Expr *e) {
+    char token[64];
+    unsigned int n = 0;
+    char *end;
+    long value;
+
+    while((isalnum((unsigned char)*e->p) || *e->p == '_') && n < sizeof token - 1) token[n++] = *e->p++;
+    token[n] = 0;
+
+    if(n > 2 && token[0] == '0' && (token[1] == 'x' || token[1] == 'X')) {
+        value = strtol(token + 2, &end, 16);
+        while(*end == 'u' || *end == 'U' || *end == 'l' || *end == 'L') end++;
+    } else {
+        while(n && strchr("uUlL", token[n - 1])) token[--n] = 0;
+        if(n && (token[n - 1] == 'h' || token[n - 1] == 'H')) {
+            token[--n] = 0;
+            value = strtol(token, &end, 16);
+        } else {
+            value = strtol(token, &end, 10);
+        }
+    }
+    if(*end) e->bad = 1;
+    return value;
+}
+
+static long Expr_Primary(Expr *e) {
+    char name[ASM_NAME_MAX];
+    unsigned int n = 0;
+    AsmSymbol *symbol;
+    long value;
+
+    Expr_Space(e);
+    if(*e->p == '(') {
+        e->p++;
+        value = Expr_Or(e);
+        Expr_Space(e);
+        if(*e->p == ')') e->p++;
+        else e->bad = 1;
+        return value;
+    }
+    if(isdigit((unsigned char)*e->p)) return Expr_Number(e);
+    if(*e->p == '\'' && e->p[1] && e->p[2] == '\'') {
+        value = (unsigned char)e->p[1];
+        e->p += 3;
+        return value;
+    }
+    if(*e->p == '$') {
+        e->p++;
+        return (long)(asm_segments[e->as->seg].base + e->as->loc[e->as->seg]);
+    }
+    if(isalpha((unsigned char)*e->p) || *e->p == '_' || *e->p == '?') {
+        while((isalnum((unsigned char)*e->p) || *e->p == '_' || *e->p == '?') && n < sizeof name - 1) name[n++] = *e->p++;
+        name[n] = 0;
+        symbol = Sym_Resolve(e->as->image, name, e->as->file);
+        if(symbol) return (long)symbol->value;
+        if(e->as->pass == 2) Asm_Error(e->as, "undefined symbol", name);
+        e->defined = 0;
+        return 0;
+    }
+    e->bad = 1;
+    return 0;
+}
+
+static long Expr_Unary(Expr *e) {
+    Expr_Space(e);
+    if(*e->p == '-') { e->p++; return -Expr_Unary(e); }
+    if(*e->p == '+') { e->p++; return Expr_Unary(e); }
+    if(*e->p == '~') { e->p++; return ~Expr_Unary(e); }
+    if(*e->p == '!') { e->p++; return !Expr_Unary(e); }
+    return Expr_Primary(e);
+}
+
+static long Expr_Mul(Expr *e) {
+    long value = Expr_Unary(e), rhs;
+
+    for(;;) {
+        Expr_Space(e);
+        if(*e->p == '*') { e->p++; value *= Expr_Unary(e); }
+        else if(*e->p == '/' || *e->p == '%') {
+            char op = *e->p++;
+            rhs = Expr_Unary(e);
+            if(!rhs) { if(e->defined) e->bad = 1; rhs = 1; }
+            value = (op == '/') ? value / rhs : value % rhs;
+        }
+        else return value;
+    }
+}
+
+static long Expr_Add(Expr *e) {
+    long value = Expr_Mul(e);
+
+    for(;;) {
+        Expr_Space(e);
+        if(*e->p == '+') { e->p++; value += Expr_Mul(e); }
+        else if(*e->p == '-') { e->p++; value -= Expr_Mul(e); }
+        else return value;
+    }
+}
+
+static long Expr_Shift(Expr *e) {
+    long value = Expr_Add(e);
+
+    for(;;) {
+        Expr_Space(e);
+        if(e->p[0] == '<' && e->p[1] == '<') { e->p += 2; value <<= Expr_Add(e); }
+        else if(e->p[0] == '>' && e->p[1] == '>') { e->p += 2; value >>= Expr_Add(e); }
+        else return value;
+    }
+}
+
+static long Expr_And(Expr *e) {
+    long value = Expr_Shift(e);
+
+    for(;;) {
+        Expr_Space(e);
+        if(*e->p == '&' && e->p[1] != '&') { e->p++; value &= Expr_Shift(e); }
+        else return value;
+    }
+}
+
+static long Expr_Xor(Expr *e) {
+    long value = Expr_And(e);
+
+    for(;;) {
+        Expr_Space(e);
+        if(*e->p == '^') { e->p++; value ^= Expr_And(e); }
+        else return value;
+    }
+}
+
+static long Expr_Or(Expr *e) {
+    long value = Expr_Xor(e);
+
+    for(;;) {
+        Expr_Space(e);
+        if(*e->p == '|' && e->p[1] != '|') { e->p++; value |= Expr_Xor(e); }
+        else return value;
+    }
+}
+
+// Whole string as one expression. Returns 0 if it is malformed.
+static int Asm_Eval(Asm *as, const char *text, long *value, int *defined) {
+    Expr e;
+
+    e.as = as;
+    e.p = text;
+    e.defined = 1;
+    e.bad = 0;
+    *value = Expr_Or(&e);
+    Expr_Space(&e);
+    if(*e.p) e.bad = 1;
+    if(e.bad) Asm_Error(as, "bad expression", text);
+    *defined = e.defined;
+    return !e.bad;
+}
+
+/* ========================= Output ========================= */
+static uint32_t Asm_Here(const Asm *as) {
+    return asm_segments[as->seg].base + as->loc[as->seg];
+}
+
+static void Emit8(Asm *as, uint8_t value) {
+    uint32_t at = Asm_Here(as);
+
+    if(at >= asm_segments[as->seg].limit) {
+        if(as->pass == 2) Asm_Error(as, "segment overflow", asm_segments[as->seg].name);
+    } else if(as->pass == 2) {
+        as->image->mem[at] = value;
+    }
+    as->loc[as->seg]++;
+}
+
+static void Emit16(Asm *as, uint16_t value) {
+    Emit8(as, (uint8_t)value);
+    Emit8(as, (uint8_t)(value >> 8));
+}
+
+/* ========================= Text Helpers ========================= */
+static char *Trim(char *s) {
+    char *end;
+
+    while(*s == ' ' || *s == '\t') s++;
+    end = s + strlen(s);
+    while(end > s && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r' || end[-1] == '\n')) *--end = 0;
+    return s;
+}
+
+// Split at commas outside quotes and parentheses
+static unsigned int Split_Operands(char *text, char **items, unsigned int max) {
+    unsigned int count = 0, depth = 0;
+    char quote = 0;
+    char *start = text, *p;
+
+    if(!*Trim(text)) return 0;
+    for(p = text; ; p++) {
+        if(quote) {
+            if(*p == quote) quote = 0;
+            else if(!*p) break;
+            continue;
+        }
+        if(*p == '\'' || *p == '"') quote = *p;
+        else if(*p == '(') depth++;
+        else if(*p == ')' && depth) depth--;
+        else if((*p == ',' && !depth) || !*p) {
+            char last = *p;
+            *p = 0;
+            if(count < max) items[count++] = Trim(start);
+            start = p + 1;
+            if(!last) break;
+        }
+    }
+    return count;
+}
+
+static int Upper_Equal(const char *a, const char *b) {
+    while(*a && *b) {
+        if(toupper((unsigned char)*a) != toupper((unsigned char)*b)) return 0;
+        a++;
+        b++;
+    }
+    return !*a && !*b;
+}
+
+static int Register_Number(const char *text) {
+    char *end;
+    long n;
+
+    if(Upper_Equal(text, "PC")) return 0;
+    if(Upper_Equal(text, "SP")) return 1;
+    if(Upper_Equal(text, "SR")) return 2;
+    if(toupper((unsigned char)text[0]) != 'R' || !isdigit((unsigned char)text[1])) return -1;
+    n = strtol(text + 1, &end, 10);
+    return (*end || n > 15) ? -1 : (int)n;
+}
+
+/* ========================= Operands ========================= */
+enum { OP_REG, OP_INDEXED, OP_SYMBOLIC, OP_ABSOLUTE, OP_INDIRECT, OP_AUTOINC, OP_IMMEDIATE };
+
+typedef struct {
+    unsigned char mode;
+    unsigned char reg;
+    long value;
+    int defined;
+} Operand;
+
+static int Parse_Operand(Asm *as, const char *text, Operand *op) {
+    char buffer[ASM_LINE_MAX], *open;
+    size_t len;
+    int reg;
+
+    snprintf(buffer, sizeof buffer, "%s", text);
+    memset(op, 0, sizeof *op);
+    op->defined = 1;
+    len = strlen(buffer);
+
+    if(buffer[0] == '#') {
+        op->mode = OP_IMMEDIATE;
+        return Asm_Eval(as, buffer + 1, &op->value, &op->defined);
+    }
+    if(buffer[0] == '&') {
+        op->mode = OP_ABSOLUTE;
+        return Asm_Eval(as, buffer + 1, &op->value, &op->defined);
+    }
+    if(buffer[0] == '@') {
+        if(len > 1 && buffer[len - 1] == '+') {
+            buffer[len - 1] = 0;
+            op->mode = OP_AUTOINC;
+        } else {
+            op->mode = OP_INDIRECT;
+        }
+        reg = Register_Number(Trim(buffer + 1));
+        if(reg < 0) {
+            Asm_Error(as, "register expected", text);
+            return 0;
+        }
+        op->reg = (unsigned char)reg;
+        return 1;
+    }
+    if((reg = Register_Number(buffer)) >= 0) {
+        op->mode = OP_REG;
+        op->reg = (unsigned char)reg;
+        return 1;
+    }
+    // x(Rn): the last parenthesis holds a register
+    if(len && buffer[len - 1] == ')' && (open = strrchr(buffer, '(')) != 0) {
+        buffer[len - 1] = 0;
+        reg = Register_Number(Trim(open + 1));
+        if(reg >= 0) {
+            *open = 0;
+            op->mode = OP_INDEXED;
+            op->reg = (unsigned char)reg;
+            if(!*Trim(buffer)) {
+                op->value = 0;
+                return 1;
+            }
+            return Asm_Eval(as, buffer, &op->value, &op->defined);
+        }
+        buffer[len - 1] = ')';
+    }
+    op->mode = OP_SYMBOLIC;
+    return Asm_Eval(as, buffer, &op->value, &op->defined);
+}
+
+// Pass 1 decides whether an immediate uses the constant generator; pass 2
+// replays the decision so every label stays where pass 1 put it
+static int Short_Immediate(Asm *as, const Operand *op, int byte) {
+    long v = op->value;
+    int fits;
+
+    if(as->pass == 1) {
+        if(op->defined) {
+            if(byte) v &= 0xFF;
+            else v &= 0xFFFF;
+            fits = (v == 0 || v == 1 || v == 2 || v == 4 || v == 8 || v == (byte ? 0xFF : 0xFFFF));
+        } else {
+            fits = 0;
+        }
+        if(as->short_count == as->short_cap) {
+            as->short_cap = as->short_cap ? 2 * as->short_cap : 1024;
+            as->short_imm = realloc(as->short_imm, as->short_cap);
+            if(!as->short_imm) {
+                fprintf(stderr, "asm430: out of memory\n");
+                exit(2);
+            }
+        }
+        as->short_imm[as->short_count++] = (unsigned char)fits;
+        return fits;
+    }
+    if(as->short_next >= as->short_count) return 0;
+    return as->short_imm[as->short_next++];
+}
+
+// Source field: As bits, register and extension word (has_ext = 0 if none)
+static void Encode_Source(Asm *as, const Operand *op, int byte, unsigned int *as_bits, unsigned int *reg,
+                          int *has_ext, long *ext) {
+    long v;
+
+    *has_ext = 0;
+    switch(op->mode) {
+    case OP_REG:      *as_bits = 0; *reg = op->reg; break;
+    case OP_INDEXED:  *as_bits = 1; *reg = op->reg; *has_ext = 1; *ext = op->value; break;
+    case OP_SYMBOLIC: *as_bits = 1; *reg = 0; *has_ext = 2; *ext = op->value; break;   // PC-relative
+    case OP_ABSOLUTE: *as_bits = 1; *reg = 2; *has_ext = 1; *ext = op->value; break;
+    case OP_INDIRECT: *as_bits = 2; *reg = op->reg; break;
+    case OP_AUTOINC:  *as_bits = 3; *reg = op->reg; break;
+    case OP_IMMEDIATE:
+        if(Short_Immediate(as, op, byte)) {
+            v = op->value & (byte ? 0xFF : 0xFFFF);
+            if(v == 0)      { *as_bits = 0; *reg = 3; }
+            else if(v == 1) { *as_bits = 1; *reg = 3; }
+            else if(v == 2) { *as_bits = 2; *reg = 3; }
+            else if(v == 4) { *as_bits = 2; *reg = 2; }
+            else if(v == 8) { *as_bits = 3; *reg = 2; }
+            else            { *as_bits = 3; *reg = 3; }
+        } else {
+            *as_bits = 3;
+            *reg = 0;
+            *has_ext = 1;
+            *ext = op->value;
+        }
+        break;
+    }
+}
+
+static void Emit_Ext(Asm *as, int has_ext, long ext) {
+    if(has_ext == 2) ext -= (long)Asm_Here(as);     // Symbolic: relative to the extension word
+    Emit16(as, (uint16_t)ext);
+}
+
+/* ========================= Instructions ========================= */
+enum { K_DOUBLE, K_SINGLE, K_JUMP, K_EMU_DST, K_EMU_SRC, K_FIXED, K_CALLA };
+
+typedef struct {
+    const char *name;
+    unsigned char kind;
+    uint16_t code;
+    const char *fixed;                  // K_EMU_DST: source operand ("=" = the destination)
+} Mnemonic;
+
+static const Mnemonic asm_mnemonics[] = {
+    { "MOV",  K_DOUBLE, 0x4000, 0 }, { "ADD",  K_DOUBLE, 0x5000, 0 }, { "ADDC", K_DOUBLE, 0x6000, 0 },
+    { "SUBC", K_DOUBLE, 0x7000, 0 }, { "SUB",  K_DOUBLE, 0x8000, 0 }, { "CMP",  K_DOUBLE, 0x9000, 0 },
+    { "DADD", K_DOUBLE, 0xA000, 0 }, { "BIT",  K_DOUBLE, 0xB000, 0 }, { "BIC",  K_DOUBLE, 0xC000, 0 },
+    { "BIS",  K_DOUBLE, 0xD000, 0 }, { "XOR",  K_DOUBLE, 0xE000, 0 }, { "AND",  K_DOUBLE, 0xF000, 0 },
+
+    { "RRC",  K_SINGLE, 0x1000, 0 }, { "SWPB", K_SINGLE, 0x1080, 0 }, { "RRA",  K_SINGLE, 0x1100, 0 },
+    { "SXT",  K_SINGLE, 0x1180, 0 }, { "PUSH", K_SINGLE, 0x1200, 0 }, { "CALL", K_SINGLE, 0x1280, 0 },
+
+    { "JNE", K_JUMP, 0x2000, 0 }, { "JNZ", K_JUMP, 0x2000, 0 }, { "JEQ", K_JUMP, 0x2400, 0 },
+    { "JZ",  K_JUMP, 0x2400, 0 }, { "JNC", K_JUMP, 0x2800, 0 }, { "JLO", K_JUMP, 0x2800, 0 },
+    { "JC",  K_JUMP, 0x2C00, 0 }, { "JHS", K_JUMP, 0x2C00, 0 }, { "JN",  K_JUMP, 0x3000, 0 },
+    { "JGE", K_JUMP, 0x3400, 0 }, { "JL",  K_JUMP, 0x3800, 0 }, { "JMP", K_JUMP, 0x3C00, 0 },
+
+    { "INC",  K_EMU_DST, 0x5000, "#1" }, { "INCD", K_EMU_DST, 0x5000, "#2" },
+    { "DEC",  K_EMU_DST, 0x8000, "#1" }, { "DECD", K_EMU_DST, 0x8000, "#2" },
+    { "CLR",  K_EMU_DST, 0x4000, "#0" }, { "TST",  K_EMU_DST, 0x9000, "#0" },
+    { "INV",  K_EMU_DST, 0xE000, "#-1" }, { "ADC", K_EMU_DST, 0x6000, "#0" },
+    { "SBC",  K_EMU_DST, 0x7000, "#0" }, { "DADC", K_EMU_DST, 0xA000, "#0" },
+    { "POP",  K_EMU_DST, 0x4000, "@SP+" }, { "RLA", K_EMU_DST, 0x5000, "=" },
+    { "RLC",  K_EMU_DST, 0x6000, "=" },
+    { "BR",   K_EMU_SRC, 0x4000, "PC" },
+
+    { "NOP",  K_FIXED, 0x4303, 0 }, { "RET",  K_FIXED, 0x4130, 0 }, { "RETI", K_FIXED, 0x1300, 0 },
+    { "DINT", K_FIXED, 0xC232, 0 }, { "EINT", K_FIXED, 0xD232, 0 }, { "CLRC", K_FIXED, 0xC312, 0 },
+    { "SETC", K_FIXED, 0xD312, 0 }, { "CLRZ", K_FIXED, 0xC322, 0 }, { "SETZ", K_FIXED, 0xD322, 0 },
+    { "CLRN", K_FIXED, 0xC222, 0 }, { "SETN", K_FIXED, 0xD222, 0 }, { "RETA", K_FIXED, 0x0110, 0 },
+    { "CALLA", K_CALLA, 0x1300, 0 },
+};
+
+static const Mnemonic *Find_Mnemonic(const char *name) {
+    unsigned int i;
+
+    for(i = 0; i < sizeof asm_mnemonics / sizeof asm_mnemonics[0]; i++) {
+        if(Upper_Equal(name, asm_mnemonics[i].name)) return &asm_mnemonics[i];
+    }
+    return 0;
+}
+
+static void Asm_Double(Asm *as, uint16_t code, int byte, const char *src_text, const char *dst_text) {
+    Operand src, dst;
+    unsigned int as_bits, src_reg, ad = 0, dst_reg = 0;
+    int src_ext, dst_ext = 0;
+    long src_value = 0, dst_value = 0;
+
+    if(!Parse_Operand(as, src_text, &src) || !Parse_Operand(as, dst_text, &dst)) return;
+    Encode_Source(as, &src, byte, &as_bits, &src_reg, &src_ext, &src_value);
+
+    switch(dst.mode) {
+    case OP_REG:      ad = 0; dst_reg = dst.reg; break;
+    case OP_INDEXED:  ad = 1; dst_reg = dst.reg; dst_ext = 1; dst_value = dst.value; break;
+    case OP_SYMBOLIC: ad = 1; dst_reg = 0; dst_ext = 2; dst_value = dst.value; break;
+    case OP_ABSOLUTE: ad = 1; dst_reg = 2; dst_ext = 1; dst_value = dst.value; break;
+    default:
+        Asm_Error(as, "destination cannot be indirect or immediate", dst_text);
+        return;
+    }
+
+    Emit16(as, (uint16_t)(code | (src_reg << 8) | (ad << 7) | (byte << 6) | (as_bits << 4) | dst_reg));
+    if(src_ext) Emit_Ext(as, src_ext, src_value);
+    if(dst_ext) Emit_Ext(as, dst_ext, dst_value);
+}
+
+static void Asm_Single(Asm *as, uint16_t code, int byte, const char *text) {
+    Operand op;
+    unsigned int as_bits, reg;
+    int ext;
+    long value = 0;
+
+    if(!Parse_Operand(as, text, &op)) return;
+    Encode_Source(as, &op, byte, &as_bits, &reg, &ext, &value);
+    Emit16(as, (uint16_t)(code | (byte << 6) | (as_bits << 4) | reg));
+    if(ext) Emit_Ext(as, ext, value);
+}
+
+static void Asm_Jump(Asm *as, uint16_t code, const char *text) {
+    long target, offset;
+    int defined;
+
+    if(!Asm_Eval(as, text, &target, &defined)) return;
+    offset = 0;
+    if(as->pass == 2) {
+        offset = (target - (long)(Asm_Here(as) + 2)) / 2;
+        if(offset < -512 || offset > 511) Asm_Error(as, "jump out of range", text);
+    }
+    Emit16(as, (uint16_t)(code | (offset & 0x3FF)));
+}
+
+static void Asm_Calla(Asm *as, const char *text) {
+    Operand op;
+
+    if(!Parse_Operand(as, text, &op)) return;
+    switch(op.mode) {
+    case OP_REG:      Emit16(as, (uint16_t)(0x1340 | op.reg)); break;
+    case OP_INDIRECT: Emit16(as, (uint16_t)(0x1360 | op.reg)); break;
+    case OP_AUTOINC:  Emit16(as, (uint16_t)(0x1370 | op.reg)); break;
+    case OP_INDEXED:
+        Emit16(as, (uint16_t)(0x1350 | op.reg));
+        Emit16(as, (uint16_t)op.value);
+        break;
+    case OP_ABSOLUTE:
+        Emit16(as, (uint16_t)(0x1380 | ((op.value >> 16) & 0xF)));
+        Emit16(as, (uint16_t)op.value);
+        break;
+    case OP_SYMBOLIC:
+        Emit16(as, (uint16_t)(0x1390 | (((op.value - (long)Asm_Here(as) - 2) >> 16) & 0xF)));
+        Emit16(as, (uint16_t)(op.value - (long)Asm_Here(as)));
+        break;
+    case OP_IMMEDIATE:
+        Emit16(as, (uint16_t)(0x13B0 | ((op.value >> 16) & 0xF)));
+        Emit16(as, (uint16_t)op.value);
+        break;
+    }
+}
+
+static void Asm_Instruction(Asm *as, const Mnemonic *m, int byte, char **ops, unsigned int count) {
+    if(as->loc[as->seg] & 1) Asm_Error(as, "instruction at an odd address", m->name);
+
+    switch(m->kind) {
+    case K_DOUBLE:
+        if(count != 2) Asm_Error(as, "two operands expected", m->name);
+        else Asm_Double(as, m->code, byte, ops[0], ops[1]);
+        break;
+    case K_SINGLE:
+        if(count != 1) Asm_Error(as, "one operand expected", m->name);
+        else Asm_Single(as, m->code, byte, ops[0]);
+        break;
+    case K_JUMP:
+        if(count != 1) Asm_Error(as, "jump target expected", m->name);
+        else Asm_Jump(as, m->code, ops[0]);
+        break;
+    case K_EMU_DST:
+        if(count != 1) Asm_Error(as, "one operand expected", m->name);
+        else Asm_Double(as, m->code, byte, strcmp(m->fixed, "=") ? m->fixed : ops[0], ops[0]);
+        break;
+    case K_EMU_SRC:
+        if(count != 1) Asm_Error(as, "one operand expected", m->name);
+        else Asm_Double(as, m->code, 0, ops[0], m->fixed);
+        break;
+    case K_FIXED:
+        if(count) Asm_Error(as, "no operands expected", m->name);
+        Emit16(as, m->code);
+        break;
+    case K_CALLA:
+        if(count != 1) Asm_Error(as, "one operand expected", m->name);
+        else Asm_Calla(as, ops[0]);
+        break;
+    }
+}
+
+/* ========================= Directives ========================= */
+static void Asm_Data(Asm *as, int width, char **items, unsigned int count) {
+    unsigned int i;
+    size_t len;
+    long value;
+    int defined;
+    const char *s;
+
+    for(i = 0; i < count; i++) {
+        s = items[i];
+        len = strlen(s);
+        if(width == 1 && len >= 2 && (s[0] == '\'' || s[0] == '"') && s[len - 1] == s[0]) {
+            for(s++; s < items[i] + len - 1; s++) Emit8(as, (uint8_t)*s);
+            continue;
+        }
+        if(!Asm_Eval(as, s, &value, &defined)) continue;
+        if(width == 1) Emit8(as, (uint8_t)value);
+        else Emit16(as, (uint16_t)value);
+    }
+}
+
+static int Asm_Directive(Asm *as, const char *name, char *rest) {
+    char *items[ASM_OPERANDS];
+    unsigned int count, i, seg;
+    long value;
+    int defined;
+    AsmSymbol *symbol;
+
+    if(Upper_Equal(name, "PUBLIC")) {
+        if(as->pass == 1) {
+            count = Split_Operands(rest, items, ASM_OPERANDS);
+            for(i = 0; i < count; i++) {
+                if(as->public_count == as->public_cap) {
+                    as->public_cap = as->public_cap ? 2 * as->public_cap : 64;
+                    as->publics = realloc(as->publics, as->public_cap * sizeof *as->publics);
+                    if(!as->publics) {
+                        fprintf(stderr, "asm430: out of memory\n");
+                        exit(2);
+                    }
+                }
+                symbol = &as->publics[as->public_count++];
+                snprintf(symbol->name, sizeof symbol->name, "%s", items[i]);
+                symbol->file = as->file;
+            }
+        }
+    } else if(Upper_Equal(name, "EXTERN") || Upper_Equal(name, "MODULE") || Upper_Equal(name, "NAME")) {
+        // Resolved at use
+    } else if(Upper_Equal(name, "RSEG")) {
+        char *colon = strchr(rest, ':');
+        if(colon) *colon = 0;
+        rest = Trim(rest);
+        for(seg = 0; seg < SEG_COUNT && !Upper_Equal(rest, asm_segments[seg].name); seg++) {}
+        if(seg == SEG_COUNT) Asm_Error(as, "unknown segment", rest);
+        else as->seg = (unsigned char)seg;
+    } else if(Upper_Equal(name, "EVEN")) {
+        if(as->loc[as->seg] & 1) Emit8(as, 0);
+    } else if(Upper_Equal(name, "ORG")) {
+        if(Asm_Eval(as, rest, &value, &defined)) as->loc[as->seg] = (uint32_t)value;
+    } else if(Upper_Equal(name, "DB") || Upper_Equal(name, "DC8")) {
+        count = Split_Operands(rest, items, ASM_OPERANDS);
+        Asm_Data(as, 1, items, count);
+    } else if(Upper_Equal(name, "DW") || Upper_Equal(name, "DC16")) {
+        count = Split_Operands(rest, items, ASM_OPERANDS);
+        Asm_Data(as, 2, items, count);
+    } else if(Upper_Equal(name, "DS8") || Upper_Equal(name, "DS") || Upper_Equal(name, "DS16")) {
+        if(Asm_Eval(as, rest, &value, &defined)) {
+            value *= Upper_Equal(name, "DS16") ? 2 : 1;
+            while(value-- > 0) Emit8(as, 0);
+        }
+    } else if(Upper_Equal(name, "END")) {
+        as->done = 1;
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+static int Is_Keyword(const char *name) {
+    static const char *const directives[] = {
+        "PUBLIC", "EXTERN", "MODULE", "NAME", "RSEG", "EVEN", "ORG", "DB", "DC8", "DW", "DC16",
+        "DS", "DS8", "DS16", "END", "EQU"
+    };
+    char base[16];
+    unsigned int i;
+
+    for(i = 0; i < sizeof base - 1 && name[i] && name[i] != '.'; i++) base[i] = name[i];
+    base[i] = 0;
+    for(i = 0; i < sizeof directives / sizeof directives[0]; i++) {
+        if(Upper_Equal(base, directives[i])) return 1;
+    }
+    return Find_Mnemonic(base) != 0;
+}
+
+/* ========================= Lines ========================= */
+static void Define_Label(Asm *as, const char *name, uint32_t value) {
+    AsmSymbol *symbol = Sym_Find(as->image, name, as->file);
+
+    if(as->pass == 1) {
+        if(symbol) Asm_Error(as, "label defined twice", name);
+        else Sym_Add(as->image, name, value, as->file);
+    } else if(symbol && symbol->value != value) {
+        Asm_Error(as, "label moved between passes", name);
+    }
+}
+
+static void Asm_Line(Asm *as, char *text) {
+    char *p, *label = 0, *op, *rest, *items[ASM_OPERANDS], *dot;
+    char quote = 0;
+    const Mnemonic *m;
+    unsigned int count;
+    int byte = 0, defined;
+    long value;
+
+    // Comment: ';' outside quotes
+    for(p = text; *p; p++) {
+        if(quote) { if(*p == quote) quote = 0; }
+        else if(*p == '\'' || *p == '"') quote = *p;
+        else if(*p == ';') { *p = 0; break; }
+    }
+    if(!*Trim(text)) return;
+
+    // Label in column 1, unless it is really a directive written there
+    p = text;
+    if(*p != ' ' && *p != '\t') {
+        while(*p && *p != ' ' && *p != '\t' && *p != ':') p++;
+        if(*p == ':') *p++ = 0;
+        else if(*p) *p++ = 0;
+        if(Is_Keyword(text)) {
+            if(*p) p[-1] = ' ';
+            p = text;
+        } else {
+            label = text;
+        }
+    }
+    p = Trim(p);
+
+    op = p;
+    while(*p && *p != ' ' && *p != '\t') p++;
+    if(*p) *p++ = 0;
+    rest = Trim(p);
+
+    if(*op && Upper_Equal(op, "EQU")) {
+        if(!label) {
+            Asm_Error(as, "EQU without a name", 0);
+        } else if(Asm_Eval(as, rest, &value, &defined)) {
+            if(!defined && as->pass == 1) Asm_Error(as, "EQU needs symbols defined earlier", rest);
+            Define_Label(as, label, (uint32_t)value);
+        }
+        return;
+    }
+    if(label) Define_Label(as, label, Asm_Here(as));
+    if(!*op) return;
+
+    if(Asm_Directive(as, op, rest)) return;
+
+    dot = strchr(op, '.');
+    if(dot) {
+        *dot++ = 0;
+        if(Upper_Equal(dot, "B")) byte = 1;
+        else if(!Upper_Equal(dot, "W")) Asm_Error(as, "only .B and .W are supported", dot);
+    }
+    m = Find_Mnemonic(op);
+    if(!m) {
+        Asm_Error(as, "unknown instruction", op);
+        return;
+    }
+    count = Split_Operands(rest, items, ASM_OPERANDS);
+    Asm_Instruction(as, m, byte, items, count);
+}
+
+static int Asm_File(Asm *as, const char *path) {
+    char line[ASM_LINE_MAX];
+    FILE *f = fopen(path, "r");
+
+    if(!f) {
+        fprintf(stderr, "asm430: cannot open %s\n", path);
+        return 0;
+    }
+    as->path = path;
+    as->line = 0;
+    as->done = 0;
+    as->seg = SEG_CODE;
+    while(!as->done && fgets(line, sizeof line, f)) {
+        as->line++;
+        Asm_Line(as, line);
+    }
+    fclose(f);
+    return 1;
+}
+
+/* ========================= Public Interface ========================= */
+// Between the passes: a PUBLIC makes its label visible to every file
+static void Asm_Export(Asm *as) {
+    AsmSymbol *symbol;
+    unsigned int i;
+
+    for(i = 0; i < as->public_count; i++) {
+        symbol = Sym_Find(as->image, as->publics[i].name, as->publics[i].file);
+        if(symbol) symbol->exported = 1;
+        else {
+            as->path = "PUBLIC";
+            as->line = 0;
+            Asm_Error(as, "symbol not defined", as->publics[i].name);
+        }
+    }
+}
+
+int Asm_Build(Image *image, const char *const *files, unsigned int count) {
+    Asm as;
+    unsigned int i;
+
+    memset(&as, 0, sizeof as);
+    as.image = image;
+    memset(image->mem, 0xFF, sizeof image->mem);     // Erased flash
+    memset(image->mem + SEG_DATA16_I_BASE, 0, STACK_TOP - SEG_DATA16_I_BASE);
+
+    for(as.pass = 1; as.pass <= 2 && !as.errors; as.pass++) {
+        memset(as.loc, 0, sizeof as.loc);
+        as.short_next = 0;
+        for(i = 0; i < count && !as.errors; i++) {
+            as.file = (unsigned char)i;
+            if(!Asm_File(&as, files[i])) as.errors++;
+        }
+        if(as.pass == 1 && !as.errors) Asm_Export(&as);
+    }
+    image->flash_bytes = as.loc[SEG_CODE] + as.loc[SEG_DATA16_C] + as.loc[SEG_DATA16_I];
+    image->ram_bytes = as.loc[SEG_DATA16_I] + as.loc[SEG_DATA16_Z] + as.loc[SEG_DATA16_N];
+    free(as.short_imm);
+    free(as.publics);
+    return as.errors ? -1 : 0;
+}
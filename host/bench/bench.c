@@ -0,0 +1,567 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "msp430f5308.h"
+
+/* ========================= Benchmark Harness =========================
+ *   asmbench [--update] OBJDIR BASELINE
+ *
+ * OBJDIR holds the preprocessed sources: Main.s43 and Main_poll.s43 (Main.asm
+ * built with KEYPAD_POLL=1), BusRead.s43 and BusWrite.s43. Every case starts
+ * from a fresh copy of the
+ * assembled image, sets its inputs, enters the routine the way the firmware
+ * does (CALL, CALLA or an interrupt) and runs it until it returns. The
+ * outputs are checked, then the cycle count is compared with BASELINE.
+ * A case that gives the wrong answer, takes more cycles than its baseline or
+ * has no baseline fails the run; --update rewrites BASELINE from this run.
+ * Last comes the variant comparison: flash and RAM per image, and the cycles
+ * of every case next to each other.
+ */
+#define STUB_ADDR       0xF000          // RETA for the C routines main would call
+#define WATCHDOG_ADDR   0xF010          // RETA for I2C_Watchdog, run by its model first
+#define SENTINEL_ADDR   0xF100          // Return address: the run stops here
+#define LCD_DONE_ADDR   0x3000          // lcd_done (lcd.c)
+#define FIELD_ADDR      0x3010          // Where lcd.c would have ScreenField render
+#define STEP_LIMIT      200000UL
+
+#define BASELINE_MAX    128
+#define IMAGE_COUNT     2
+
+enum { ENTRY_CALL, ENTRY_CALLA, ENTRY_INTERRUPT };
+
+typedef struct {
+    const char *name;
+    Image *image;
+    Cpu cpu;
+    uint8_t mem[MEM_SIZE];
+} Bench;
+
+typedef struct {
+    const char *image;                  // 0 = every image
+    const char *routine;
+    const char *name;
+    unsigned char entry;
+    void (*setup)(Bench *b);
+    int (*check)(Bench *b);             // 1 = right answer
+} BenchCase;
+
+typedef struct {
+    char image[24], routine[ASM_NAME_MAX], name[24];
+    unsigned long cycles;
+    unsigned char seen;
+} Baseline;
+
+static Baseline baselines[BASELINE_MAX];
+static unsigned int baseline_count;
+
+/* ========================= Memory Helpers ========================= */
+static uint32_t Addr(Bench *b, const char *symbol) {
+    long value = Asm_Lookup(b->image, symbol);
+
+    if(value < 0) {
+        fprintf(stderr, "asmbench: %s has no symbol %s\n", b->name, symbol);
+        exit(2);
+    }
+    return (uint32_t)value;
+}
+
+static unsigned int Get8(Bench *b, const char *symbol)  { return b->mem[Addr(b, symbol)]; }
+static unsigned int Get16(Bench *b, const char *symbol) { return Cpu_Read16(&b->cpu, Addr(b, symbol)); }
+static void Set8(Bench *b, const char *symbol, unsigned int value)  { b->mem[Addr(b, symbol)] = (uint8_t)value; }
+static void Set16(Bench *b, const char *symbol, unsigned int value) {
+    uint32_t at = Addr(b, symbol);
+
+    b->mem[at] = (uint8_t)value;
+    b->mem[at + 1] = (uint8_t)(value >> 8);
+}
+
+/* ========================= I2C_Watchdog Model =========================
+ * i2c.c is C, so the harness stands in for the part the tick relies on: the
+ * rest after an error counts down by the ms passed in R12, and the call that
+ * ends it runs the done callback (lcd_done) and returns 1.
+ */
+static unsigned int watchdog_rest_ms;   // Rest left, as I2C_Error() sets it
+static unsigned int watchdog_calls;
+static unsigned int watchdog_ms;        // R12 of the last call
+
+static void Watchdog_Model(Cpu *cpu) {
+    unsigned int rested = 0;
+
+    watchdog_calls++;
+    watchdog_ms = cpu->r[12] & 0xFF;
+    if(watchdog_rest_ms) {
+        watchdog_rest_ms = (watchdog_rest_ms > watchdog_ms) ? watchdog_rest_ms - watchdog_ms : 0;
+        rested = !watchdog_rest_ms;
+        if(rested) cpu->mem[LCD_DONE_ADDR] = 1;
+    }
+    cpu->r[12] = rested;
+}
+
+/* ========================= TIMER0_A0_ISR ========================= */
+static void Isr_Idle(Bench *b)      { (void)b; }
+static int Isr_IdleCheck(Bench *b) {
+    return Get8(b, "leds") == 0xFF && b->cpu.bus.leds == 0xFF && b->cpu.bus.reads == 1
+        && Get8(b, "flag_switch") == 0 && (b->cpu.r[CPU_SR] & SR_CPUOFF)
+        && watchdog_calls == 1 && watchdog_ms == 1;
+}
+
+// The last ms of the rest after a NACK: the tick must wake main to resend
+static void Isr_I2cRest(Bench *b)   { (void)b; watchdog_rest_ms = 1; }
+static int Isr_I2cRestCheck(Bench *b) {
+    return watchdog_rest_ms == 0 && b->mem[LCD_DONE_ADDR] == 1 && !(b->cpu.r[CPU_SR] & SR_CPUOFF);
+}
+
+static void Isr_S3Edge(Bench *b)    { b->cpu.bus.switches = 0x80; Set16(b, "debounce_cnt", 7); }
+static int Isr_S3EdgeCheck(Bench *b) {
+    return Get8(b, "s3_raw") == 1 && Get16(b, "debounce_cnt") == 0 && Get8(b, "s3_debounced") == 0;
+}
+
+static void Isr_Debounce(Bench *b) {
+    b->cpu.bus.switches = 0x80;
+    Set8(b, "s3_raw", 1);
+    Set16(b, "debounce_cnt", 5);
+}
+static int Isr_DebounceCheck(Bench *b) {
+    return Get16(b, "debounce_cnt") == 6 && Get8(b, "s3_debounced") == 0 && (b->cpu.r[CPU_SR] & SR_CPUOFF);
+}
+
+static void Isr_S3Accept(Bench *b) {
+    b->cpu.bus.switches = 0x80;
+    Set8(b, "s3_raw", 1);
+    Set16(b, "debounce_cnt", 20);
+}
+static int Isr_S3AcceptCheck(Bench *b) {
+    return Get8(b, "s3_debounced") == 1 && Get8(b, "flag_switch") == 1 && !(Get8(b, "leds") & 0x80)
+        && !(b->cpu.bus.leds & 0x80) && !(b->cpu.r[CPU_SR] & SR_CPUOFF);
+}
+
+static void Isr_Tick(Bench *b) {
+    Set8(b, "timing", 1);
+    Set16(b, "ms_count", 500);
+}
+static int Isr_TickCheck(Bench *b) {
+    return Get16(b, "ms_count") == 501 && Get8(b, "flag_second") == 0;
+}
+
+static void Isr_Second(Bench *b) {
+    Set8(b, "timing", 1);
+    Set16(b, "ms_count", 999);
+    Set16(b, "seconds", 5);
+}
+static int Isr_SecondCheck(Bench *b) {
+    return Get16(b, "ms_count") == 0 && Get16(b, "seconds") == 6 && Get8(b, "flag_second") == 1
+        && !(b->cpu.r[CPU_SR] & SR_CPUOFF);
+}
+
+// Main.asm keeps packed-BCD mm:ss plus an hours byte
+static void Isr_Minute(Bench *b) {
+    Set8(b, "timing", 1);
+    Set16(b, "ms_count", 999);
+    Set16(b, "seconds", 0x0959);
+}
+static int Isr_MinuteCheck(Bench *b) {
+    return Get16(b, "seconds") == 0x1000 && Get8(b, "hours") == 0 && Get8(b, "flag_second") == 1;
+}
+
+static void Isr_Hour(Bench *b) {
+    Set8(b, "timing", 1);
+    Set16(b, "ms_count", 999);
+    Set16(b, "seconds", 0x5959);
+    Set8(b, "hours", 0x09);
+}
+static int Isr_HourCheck(Bench *b) {
+    return Get16(b, "seconds") == 0 && Get8(b, "hours") == 0x10 && Get8(b, "flag_second") == 1;
+}
+
+static void Isr_Blink(Bench *b) {
+    Set8(b, "alarm_on", 1);
+    Set16(b, "blink_count", 249);
+}
+static int Isr_BlinkCheck(Bench *b) {
+    return Get16(b, "blink_count") == 0 && Get8(b, "leds") == 0xFE && b->cpu.bus.leds == 0xFE
+        && Get8(b, "flag_blink") == 1;
+}
+
+// KEYPAD_POLL: the twentieth tick samples the keypad, P2.0 high
+static void Isr_KeyPoll(Bench *b) {
+    b->mem[P2IN] |= 0x01;
+    b->cpu.bus.keypad = 0x82;
+    Set16(b, "key_poll_ms", 19);
+}
+static int Isr_KeyPollCheck(Bench *b) {
+    return Get8(b, "digit_count") == 1 && Get8(b, "digit_buffer") == 0 && Get8(b, "g_key_last") == 0x82
+        && !(b->cpu.r[CPU_SR] & SR_CPUOFF);
+}
+
+// Keypad deadline (Main.asm): the press settled with P2.0 still high
+static void Isr_KeyPress(Bench *b) {
+    b->mem[P2IN] |= 0x01;
+    b->mem[P2IES] &= ~0x01;
+    b->mem[P2IE] &= ~0x01;
+    b->cpu.bus.keypad = 0x82;
+    Set8(b, "key_state", 1);            // KEY_PRESS_WAIT
+    Set8(b, "key_deadline", 1);
+}
+static int Isr_KeyPressCheck(Bench *b) {
+    return Get8(b, "digit_count") == 1 && Get8(b, "key_held") == 0x82 && Get8(b, "key_state") == 2
+        && (b->mem[P2IES] & 0x01) && (b->mem[P2IE] & 0x01) && !(b->cpu.r[CPU_SR] & SR_CPUOFF);
+}
+
+// ...and the release, P2.0 still low: back to waiting for a press
+static void Isr_KeyRelease(Bench *b) {
+    b->mem[P2IN] &= ~0x01;
+    b->mem[P2IES] |= 0x01;
+    b->mem[P2IE] &= ~0x01;
+    Set8(b, "key_state", 3);            // KEY_RELEASE_WAIT
+    Set8(b, "key_deadline", 1);
+}
+static int Isr_KeyReleaseCheck(Bench *b) {
+    return Get8(b, "key_state") == 0 && !(b->mem[P2IES] & 0x01) && (b->mem[P2IE] & 0x01)
+        && b->cpu.bus.reads == 1 && (b->cpu.r[CPU_SR] & SR_CPUOFF);
+}
+
+/* ========================= PORT2_ISR ========================= */
+// A keypad edge only arms the deadline, with P2.0 masked until it expires
+static void Port2_Press(Bench *b) {
+    b->mem[P2IE] |= 0x01;
+    b->mem[P2IFG] |= 0x01;
+}
+static int Port2_PressCheck(Bench *b) {
+    return Get8(b, "key_state") == 1 && Get8(b, "key_deadline") == 5 && !(b->mem[P2IE] & 0x01)
+        && !(b->mem[P2IFG] & 0x01) && b->cpu.bus.reads == 0 && (b->cpu.r[CPU_SR] & SR_CPUOFF);
+}
+
+static void Port2_Release(Bench *b) {
+    b->mem[P2IE] |= 0x01;
+    Set8(b, "key_state", 2);            // KEY_DOWN
+}
+static int Port2_ReleaseCheck(Bench *b) {
+    return Get8(b, "key_state") == 3 && Get8(b, "key_deadline") == 10 && !(b->mem[P2IE] & 0x01);
+}
+
+/* ========================= Keypad_HandleRaw ========================= */
+static void Key_First(Bench *b)     { b->cpu.r[12] = 0x82; Set8(b, "digit_count", 0); }
+static int Key_FirstCheck(Bench *b) {
+    return Get8(b, "digit_count") == 1 && Get8(b, "digit_buffer") == 0 && Get8(b, "lcd_refresh") == 1;
+}
+
+static void Key_Second(Bench *b) {
+    b->cpu.r[12] = 0x44;
+    Set8(b, "digit_count", 1);
+    Set8(b, "digit_buffer", 5);
+}
+static int Key_SecondBcdCheck(Bench *b) {
+    return Get16(b, "threshold") == 0x0059 && Get8(b, "digit_count") == 2;
+}
+
+static void Key_Carry(Bench *b) {
+    b->cpu.r[12] = 0x12;
+    Set8(b, "digit_count", 1);
+    Set8(b, "digit_buffer", 7);
+}
+static int Key_CarryCheck(Bench *b) {
+    return Get16(b, "threshold") == 0x0112;     // 72 s
+}
+
+static void Key_Other(Bench *b)     { b->cpu.r[12] = 0x88; Set8(b, "threshold", 42); }
+static int Key_OtherCheck(Bench *b) {
+    return Get8(b, "threshold") == 42 && Get8(b, "digit_count") == 0 && Get8(b, "lcd_refresh") == 0;
+}
+
+/* ========================= ScreenField ========================= */
+static void Field_MinSec(Bench *b) {
+    b->cpu.r[12] = 0;                   // FIELD_ELAPSED
+    b->cpu.r[13] = FIELD_ADDR;
+    b->cpu.r[14] = 5;
+    Set16(b, "seconds", 0x5907);
+    Set8(b, "hours", 0);
+}
+static int Field_MinSecCheck(Bench *b) {
+    return !memcmp(b->mem + FIELD_ADDR, "59:07", 5);
+}
+
+static void Field_Hours(Bench *b) {
+    b->cpu.r[12] = 0;                   // FIELD_ELAPSED
+    b->cpu.r[13] = FIELD_ADDR;
+    b->cpu.r[14] = 8;
+    Set16(b, "seconds", 0x0230);
+    Set8(b, "hours", 0x12);
+}
+static int Field_HoursCheck(Bench *b) {
+    return !memcmp(b->mem + FIELD_ADDR, "12:02:30", 8);
+}
+
+static void Field_Threshold(Bench *b) {
+    b->cpu.r[12] = 1;                   // FIELD_THRESHOLD
+    b->cpu.r[13] = FIELD_ADDR;
+    b->cpu.r[14] = 5;
+    Set16(b, "threshold", 0x0139);
+}
+static int Field_ThresholdCheck(Bench *b) {
+    return !memcmp(b->mem + FIELD_ADDR, "01:39", 5);
+}
+
+/* ========================= Bus Output ========================= */
+static void Display_Bcd42(Bench *b) { b->cpu.r[12] = 0x42; }
+static int Display_Bcd42Check(Bench *b) {
+    return b->cpu.bus.seg[0] == 0x24 && b->cpu.bus.seg[1] == 0x19 && b->cpu.r[12] == 0x42;
+}
+
+static void Leds_Write(Bench *b)    { Set8(b, "leds", 0x7E); }
+static int Leds_WriteCheck(Bench *b) { return b->cpu.bus.leds == 0x7E && b->cpu.bus.writes == 1; }
+
+static void Read_Keypad(Bench *b)   { b->cpu.r[12] = 0x4008; b->cpu.bus.keypad = 0x5A; }
+static int Read_KeypadCheck(Bench *b) { return b->cpu.r[12] == 0x5A && b->cpu.bus.reads == 1; }
+
+static void Write_Leds(Bench *b)    { b->cpu.r[12] = 0x4002; b->cpu.r[13] = 0x3C; }
+static int Write_LedsCheck(Bench *b) { return b->cpu.bus.leds == 0x3C && b->cpu.bus.writes == 1; }
+
+static void Burst_Seg(Bench *b) {
+    uint32_t items = Addr(b, "seg_burst");
+
+    b->mem[items + 2] = 0x12;
+    b->mem[items + 6] = 0x34;
+    b->cpu.r[12] = items;
+    b->cpu.r[13] = 2;
+}
+static int Burst_SegCheck(Bench *b) {
+    return b->cpu.bus.seg[0] == 0x12 && b->cpu.bus.seg[1] == 0x34 && b->cpu.bus.writes == 2;
+}
+
+static void Legacy_Read(Bench *b)   { Set16(b, "BusAddress", 0x4000); b->cpu.bus.switches = 0x81; }
+static int Legacy_ReadCheck(Bench *b) { return Get16(b, "BusData") == 0x81; }
+
+static void Legacy_Write(Bench *b)  { Set16(b, "BusAddress", 0x4004); Set16(b, "BusData", 0x79); }
+static int Legacy_WriteCheck(Bench *b) { return b->cpu.bus.seg[0] == 0x79; }
+
+/* ========================= Case Table ========================= */
+static const BenchCase bench_cases[] = {
+    { 0, "TIMER0_A0_ISR", "idle",      ENTRY_INTERRUPT, Isr_Idle,      Isr_IdleCheck },
+    { 0, "TIMER0_A0_ISR", "s3_edge",   ENTRY_INTERRUPT, Isr_S3Edge,    Isr_S3EdgeCheck },
+    { 0, "TIMER0_A0_ISR", "debounce",  ENTRY_INTERRUPT, Isr_Debounce,  Isr_DebounceCheck },
+    { 0, "TIMER0_A0_ISR", "s3_accept", ENTRY_INTERRUPT, Isr_S3Accept,  Isr_S3AcceptCheck },
+    { 0, "TIMER0_A0_ISR", "tick",      ENTRY_INTERRUPT, Isr_Tick,      Isr_TickCheck },
+    { 0, "TIMER0_A0_ISR", "second",    ENTRY_INTERRUPT, Isr_Second,    Isr_SecondCheck },
+    { 0, "TIMER0_A0_ISR", "minute",    ENTRY_INTERRUPT, Isr_Minute,    Isr_MinuteCheck },
+    { 0, "TIMER0_A0_ISR", "hour",      ENTRY_INTERRUPT, Isr_Hour,      Isr_HourCheck },
+    { 0, "TIMER0_A0_ISR", "blink",     ENTRY_INTERRUPT, Isr_Blink,     Isr_BlinkCheck },
+    { 0, "TIMER0_A0_ISR", "i2c_rest",  ENTRY_INTERRUPT, Isr_I2cRest,   Isr_I2cRestCheck },
+    { "Main_poll", "TIMER0_A0_ISR", "key_poll", ENTRY_INTERRUPT, Isr_KeyPoll, Isr_KeyPollCheck },
+    { "Main.asm", "TIMER0_A0_ISR", "key_press",   ENTRY_INTERRUPT, Isr_KeyPress,   Isr_KeyPressCheck },
+    { "Main.asm", "TIMER0_A0_ISR", "key_release", ENTRY_INTERRUPT, Isr_KeyRelease, Isr_KeyReleaseCheck },
+    { "Main.asm", "PORT2_ISR",     "press",       ENTRY_INTERRUPT, Port2_Press,    Port2_PressCheck },
+    { "Main.asm", "PORT2_ISR",     "release",     ENTRY_INTERRUPT, Port2_Release,  Port2_ReleaseCheck },
+
+    { 0, "Keypad_HandleRaw", "first",  ENTRY_CALL, Key_First,  Key_FirstCheck },
+    { 0, "Keypad_HandleRaw", "second", ENTRY_CALL, Key_Second, Key_SecondBcdCheck },
+    { 0, "Keypad_HandleRaw", "carry",  ENTRY_CALL, Key_Carry,  Key_CarryCheck },
+    { 0, "Keypad_HandleRaw", "other",  ENTRY_CALL, Key_Other,  Key_OtherCheck },
+
+    { 0, "ScreenField",      "mmss",   ENTRY_CALLA, Field_MinSec, Field_MinSecCheck },
+    { 0, "ScreenField",      "hhmmss", ENTRY_CALLA, Field_Hours, Field_HoursCheck },
+    { 0, "ScreenField",      "limit",  ENTRY_CALLA, Field_Threshold, Field_ThresholdCheck },
+    { 0, "UpdateDisplay",    "42",     ENTRY_CALL, Display_Bcd42, Display_Bcd42Check },
+    { 0, "UpdateLEDs",       "write",  ENTRY_CALL, Leds_Write,  Leds_WriteCheck },
+
+    { "Main.asm", "BusReadAt",     "keypad",  ENTRY_CALLA, Read_Keypad,  Read_KeypadCheck },
+    { "Main.asm", "BusWriteAt",    "leds",    ENTRY_CALLA, Write_Leds,   Write_LedsCheck },
+    { "Main.asm", "BusWriteBurst", "seg2",    ENTRY_CALLA, Burst_Seg,    Burst_SegCheck },
+    { "Main.asm", "BusRead",       "legacy",  ENTRY_CALLA, Legacy_Read,  Legacy_ReadCheck },
+    { "Main.asm", "BusWrite",      "legacy",  ENTRY_CALLA, Legacy_Write, Legacy_WriteCheck },
+};
+#define CASE_COUNT      (sizeof bench_cases / sizeof bench_cases[0])
+
+/* ========================= Baselines ========================= */
+static void Baseline_Load(const char *path) {
+    char line[160];
+    FILE *f = fopen(path, "r");
+    Baseline *entry;
+
+    if(!f) return;                      // First run: everything is NEW
+    while(fgets(line, sizeof line, f) && baseline_count < BASELINE_MAX) {
+        if(line[0] == '#' || line[0] == '\n') continue;
+        entry = &baselines[baseline_count];
+        memset(entry, 0, sizeof *entry);
+        if(sscanf(line, "%23s %39s %23s %lu", entry->image, entry->routine, entry->name, &entry->cycles) == 4) {
+            baseline_count++;
+        }
+    }
+    fclose(f);
+}
+
+static Baseline *Baseline_Find(const char *image, const char *routine, const char *name) {
+    unsigned int i;
+
+    for(i = 0; i < baseline_count; i++) {
+        if(!strcmp(baselines[i].image, image) && !strcmp(baselines[i].routine, routine)
+           && !strcmp(baselines[i].name, name)) return &baselines[i];
+    }
+    return 0;
+}
+
+/* ========================= Running a Case ========================= */
+static int Bench_Run(Bench *b, const BenchCase *c, unsigned long *cycles, unsigned long *instructions) {
+    Cpu *cpu = &b->cpu;
+    uint32_t entry = Addr(b, c->routine);
+
+    memcpy(b->mem, b->image->mem, sizeof b->mem);
+    Cpu_Reset(cpu, b->mem);
+    cpu->r[CPU_SR] = SR_GIE;
+    cpu->hook_pc = WATCHDOG_ADDR;
+    cpu->hook = Watchdog_Model;
+    watchdog_rest_ms = 0;
+    watchdog_calls = 0;
+    watchdog_ms = 0;
+    c->setup(b);
+
+    switch(c->entry) {
+    case ENTRY_CALL:
+        Cpu_Push16(cpu, SENTINEL_ADDR);
+        cpu->cycles = CYCLES_CALL;
+        break;
+    case ENTRY_CALLA:
+        Cpu_Push16(cpu, 0);
+        Cpu_Push16(cpu, SENTINEL_ADDR);
+        cpu->cycles = CYCLES_CALLA;
+        break;
+    case ENTRY_INTERRUPT:               // Taken from LPM0 in the main loop
+        Cpu_Push16(cpu, SENTINEL_ADDR);
+        Cpu_Push16(cpu, SR_GIE | SR_CPUOFF);
+        cpu->r[CPU_SR] = 0;
+        cpu->cycles = CYCLES_INTERRUPT;
+        break;
+    }
+    cpu->r[CPU_PC] = entry;
+
+    if(Cpu_Run(cpu, SENTINEL_ADDR, STEP_LIMIT)) {
+        printf("%-16s %-17s %-10s error: %s\n", b->name, c->routine, c->name, cpu->error);
+        return 0;
+    }
+    *cycles = (unsigned long)cpu->cycles;
+    *instructions = cpu->instructions;
+    return cpu->r[CPU_SP] == STACK_TOP && c->check(b);
+}
+
+static int Bench_Image(Bench *b, const char *obj, const char *main_source) {
+    static const char *const bus_sources[] = { "BusRead", "BusWrite" };
+    char paths[3][256];
+    const char *files[3];
+    unsigned int i;
+
+    snprintf(paths[0], sizeof paths[0], "%s/%s.s43", obj, main_source);
+    for(i = 0; i < 2; i++) snprintf(paths[i + 1], sizeof paths[i + 1], "%s/%s.s43", obj, bus_sources[i]);
+    for(i = 0; i < 3; i++) files[i] = paths[i];
+
+    Asm_Define(b->image, "Initial", STUB_ADDR);
+    Asm_Define(b->image, "LCD_Init", STUB_ADDR);
+    Asm_Define(b->image, "LCD_Frame", STUB_ADDR);
+    Asm_Define(b->image, "LCD_Screen", STUB_ADDR);
+    Asm_Define(b->image, "LCD_Service", STUB_ADDR);
+    Asm_Define(b->image, "lcd_done", LCD_DONE_ADDR);
+    Asm_Define(b->image, "I2C_Watchdog", WATCHDOG_ADDR);
+    if(Asm_Build(b->image, files, 3)) return 0;
+
+    b->image->mem[STUB_ADDR] = 0x10;    // RETA
+    b->image->mem[STUB_ADDR + 1] = 0x01;
+    b->image->mem[WATCHDOG_ADDR] = 0x10;
+    b->image->mem[WATCHDOG_ADDR + 1] = 0x01;
+    return 1;
+}
+
+/* ========================= Main ========================= */
+int main(int argc, char **argv) {
+    static const char *const images[IMAGE_COUNT][2] = { { "Main.asm", "Main" }, { "Main_poll", "Main_poll" } };
+    static Image image;
+    static Bench bench;
+    static unsigned long case_cycles[IMAGE_COUNT][CASE_COUNT];  // 0 = not run on that image
+    uint32_t flash_bytes[IMAGE_COUNT], ram_bytes[IMAGE_COUNT];
+    const char *obj, *baseline_path;
+    unsigned long cycles, instructions;
+    unsigned int i, n;
+    int update = 0, failed = 0, ok;
+    Baseline *base;
+    FILE *out = 0;
+
+    if(argc > 1 && !strcmp(argv[1], "--update")) {
+        update = 1;
+        argv++;
+        argc--;
+    }
+    if(argc != 3) {
+        fprintf(stderr, "usage: asmbench [--update] OBJDIR BASELINE\n");
+        return 2;
+    }
+    obj = argv[1];
+    baseline_path = argv[2];
+
+    Baseline_Load(baseline_path);
+    if(update) {
+        out = fopen(baseline_path, "w");
+        if(!out) {
+            perror(baseline_path);
+            return 2;
+        }
+        fprintf(out, "# CPU cycles per routine and input (make bench-update rewrites this file)\n");
+        fprintf(out, "# image            routine           case       cycles\n");
+    }
+
+    printf("%-16s %-17s %-10s %7s %6s %8s\n", "image", "routine", "case", "cycles", "instr", "baseline");
+    for(n = 0; n < IMAGE_COUNT; n++) {
+        memset(&image, 0, sizeof image);
+        bench.name = images[n][0];
+        bench.image = &image;
+        if(!Bench_Image(&bench, obj, images[n][1])) {
+            Asm_Free(&image);
+            return 2;
+        }
+        flash_bytes[n] = image.flash_bytes;
+        ram_bytes[n] = image.ram_bytes;
+
+        for(i = 0; i < CASE_COUNT; i++) {
+            const BenchCase *c = &bench_cases[i];
+            const char *status = "";
+
+            if(c->image && strcmp(c->image, bench.name)) continue;
+            cycles = instructions = 0;
+            ok = Bench_Run(&bench, c, &cycles, &instructions);
+            base = Baseline_Find(bench.name, c->routine, c->name);
+
+            if(!ok) status = "FAIL";
+            else if(update) status = "";
+            else if(!base) status = "NEW";
+            else if(cycles > base->cycles) status = "OVER";
+            else if(cycles < base->cycles) status = "faster";
+            if(!update && (!ok || !base || cycles > base->cycles)) failed = 1;
+            if(update && !ok) failed = 1;
+
+            if(base) printf("%-16s %-17s %-10s %7lu %6lu %8lu %s\n", bench.name, c->routine, c->name,
+                            cycles, instructions, base->cycles, status);
+            else printf("%-16s %-17s %-10s %7lu %6lu %8s %s\n", bench.name, c->routine, c->name,
+                        cycles, instructions, "-", status);
+            if(out) fprintf(out, "%-18s %-17s %-10s %lu\n", bench.name, c->routine, c->name, cycles);
+            if(ok) case_cycles[n][i] = cycles;
+        }
+        Asm_Free(&image);
+    }
+
+    // Variant comparison: what each build option costs in flash, RAM and cycles
+    printf("\n%-28s", "variant");
+    for(n = 0; n < IMAGE_COUNT; n++) printf(" %10s", images[n][1]);
+    printf("\n%-28s", "flash bytes");
+    for(n = 0; n < IMAGE_COUNT; n++) printf(" %10lu", (unsigned long)flash_bytes[n]);
+    printf("\n%-28s", "RAM bytes");
+    for(n = 0; n < IMAGE_COUNT; n++) printf(" %10lu", (unsigned long)ram_bytes[n]);
+    printf("\n");
+    for(i = 0; i < CASE_COUNT; i++) {
+        printf("%-17s %-10s", bench_cases[i].routine, bench_cases[i].name);
+        for(n = 0; n < IMAGE_COUNT; n++) {
+            if(case_cycles[n][i]) printf(" %10lu", case_cycles[n][i]);
+            else printf(" %10s", "-");
+        }
+        printf("\n");
+    }
+
+    if(out) fclose(out);
+    return failed;
+}
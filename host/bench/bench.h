@@ -0,0 +1,103 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+/* ========================= Assembly Cycle Benchmark =========================
+ * Runs the hand-written assembly on an MSP430X instruction-set model and
+ * counts CPU cycles per routine and input, so changes to Main.asm (in each
+ * of its build variants), BusRead.asm and BusWrite.asm can be measured on Linux.
+ *
+ * Modules:
+ *   asm430.c   two-pass assembler for the IAR syntax the CLIC3 sources use
+ *              (run through the C preprocessor first, see ../Makefile)
+ *   cpu430.c   MSP430X CPU with the CPUX cycle table from SLAU208, plus the
+ *              CLIC3 bus latches on P5/PJ/P4 so BusRead/BusWrite do real cycles
+ *   bench.c    routines, inputs and expected results; baseline comparison
+ *
+ * Cycle counts are CPU cycles only: flash runs without wait states and the
+ * bus devices answer at once, as on the board at the supported clock rates.
+ */
+#include <stdint.h>
+
+#define MEM_SIZE        0x10000         // The sources stay in the lower 64 KB
+
+// Segment placement (simplified F5308 linker file)
+#define SEG_CODE_BASE       0x8000
+#define SEG_DATA16_I_BASE   0x2400
+#define SEG_DATA16_Z_BASE   0x2A00
+#define SEG_DATA16_N_BASE   0x2C00
+#define SEG_DATA16_C_BASE   0x7000
+#define SEG_INTVEC_BASE     0xFF80
+#define STACK_TOP           0x3C00      // End of the 6 KB of RAM
+
+/* ========================= Assembler (asm430.c) ========================= */
+#define ASM_NAME_MAX    40
+#define ASM_HARNESS     0xFF            // Symbol supplied by bench.c for an EXTERN
+
+typedef struct {
+    char name[ASM_NAME_MAX];
+    uint32_t value;
+    unsigned char file;                 // Defining source, or ASM_HARNESS
+    unsigned char exported;             // PUBLIC
+} AsmSymbol;
+
+typedef struct {
+    uint8_t mem[MEM_SIZE];
+    AsmSymbol *symbols;
+    unsigned int symbol_count, symbol_cap;
+    uint32_t flash_bytes;               // CODE, DATA16_C and the DATA16_I initial values
+    uint32_t ram_bytes;                 // DATA16_I, DATA16_Z and DATA16_N (no stack)
+} Image;
+
+void Asm_Define(Image *image, const char *name, uint32_t value);
+int Asm_Build(Image *image, const char *const *files, unsigned int count);     // 0 = ok
+long Asm_Lookup(const Image *image, const char *name);                          // -1 = none
+void Asm_Free(Image *image);
+
+/* ========================= CPU (cpu430.c) ========================= */
+// CLIC3 bus devices as seen through the nibble latches
+typedef struct {
+    uint8_t control;                    // Last PJOUT value
+    uint8_t address[4], data[4];        // Latched nibbles
+    uint8_t p4out;
+    uint8_t switches, keypad;           // Inputs
+    uint8_t leds, seg[2];               // Output latches
+    unsigned int reads, writes;
+} Clic3Bus;
+
+typedef struct Cpu {
+    uint32_t r[16];
+    uint8_t *mem;
+    uint64_t cycles;
+    unsigned long instructions;
+    Clic3Bus bus;
+    uint32_t hook_pc;                   // Cpu_Run() calls hook before the instruction here
+    void (*hook)(struct Cpu *cpu);      // (a C routine the harness models, 0 = none)
+    char error[80];
+} Cpu;
+
+#define CPU_PC      0
+#define CPU_SP      1
+#define CPU_SR      2
+
+#define SR_C        0x0001
+#define SR_Z        0x0002
+#define SR_N        0x0004
+#define SR_GIE      0x0008
+#define SR_CPUOFF   0x0010
+#define SR_V        0x0100
+
+// Entry costs the harness adds for the instruction that got the routine going
+#define CYCLES_CALL         4           // CALL #label
+#define CYCLES_CALLA        5           // CALLA #label
+#define CYCLES_INTERRUPT    6           // Interrupt acceptance
+
+void Cpu_Reset(Cpu *cpu, uint8_t *mem);
+uint16_t Cpu_Read16(Cpu *cpu, uint32_t address);
+uint8_t Cpu_Read8(Cpu *cpu, uint32_t address);
+void Cpu_Write16(Cpu *cpu, uint32_t address, uint16_t value);
+void Cpu_Write8(Cpu *cpu, uint32_t address, uint8_t value);
+void Cpu_Push16(Cpu *cpu, uint16_t value);
+int Cpu_Step(Cpu *cpu);                                         // 0 = ok
+int Cpu_Run(Cpu *cpu, uint32_t stop_pc, unsigned long limit);   // 0 = reached stop_pc
+
+#endif
@@ -0,0 +1,431 @@
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "msp430f5308.h"
+
+/* ========================= MSP430X Instruction-Set Model =========================
+ * Executes the MSP430 instruction set plus the CALLA/RETA pair the CLIC3
+ * sources use, in the lower 64 KB. Cycle counts follow the CPUX tables in
+ * SLAU208 (MSP430x5xx family user's guide, section 6.6):
+ *
+ *   Format I            destination  Rm   PC   x(Rn)/EDE/&EDE
+ *   source Rn / #CG                   1    3    4
+ *          @Rn                        2    4    5
+ *          @Rn+                       2    4    5
+ *          #N                         2    3    5
+ *          x(Rn)/EDE/&EDE             3    5    6
+ *   MOV, BIT and CMP to memory take one cycle less.
+ *
+ *   Format II           Rn  @Rn  @Rn+  #N  x(Rn)  EDE  &EDE
+ *   RRA/RRC/SWPB/SXT     1   3    3    -    4     4    4
+ *   PUSH                 3   3    3    3    4     4    4
+ *   CALL                 4   4    4    4    5     5    6
+ *
+ *   RETI 5, jumps 2, CALLA 5, RETA 4, interrupt acceptance 6.
+ */
+
+static const unsigned char cycles_format1[5][3] = {
+    { 1, 3, 4 },    // Rn or constant generator
+    { 2, 4, 5 },    // @Rn
+    { 2, 4, 5 },    // @Rn+
+    { 2, 3, 5 },    // #N
+    { 3, 5, 6 },    // x(Rn), EDE, &EDE
+};
+
+/* ========================= Memory and the CLIC3 Bus ========================= */
+// Nibble latches as BusRead.asm/BusWrite.asm drive them: PJOUT selects the
+// gate, P5 carries the nibble, E (P4.6) and /WRITE (P4.7) run the cycle
+static uint16_t Bus_Value(const Clic3Bus *bus, const uint8_t nibbles[4]) {
+    (void)bus;
+    return (uint16_t)(nibbles[0] | (nibbles[1] << 4) | (nibbles[2] << 8) | (nibbles[3] << 12));
+}
+
+static uint8_t Bus_Device(Clic3Bus *bus) {
+    switch(Bus_Value(bus, bus->address)) {
+    case 0x4000: return bus->switches;
+    case 0x4008: return bus->keypad;
+    default:     return 0xFF;
+    }
+}
+
+static void Bus_Strobe(Clic3Bus *bus) {
+    uint8_t data = (uint8_t)Bus_Value(bus, bus->data);
+
+    bus->writes++;
+    switch(Bus_Value(bus, bus->address)) {
+    case 0x4002: bus->leds = data; break;
+    case 0x4004: bus->seg[0] = data; break;
+    case 0x4006: bus->seg[1] = data; break;
+    default:     break;
+    }
+}
+
+uint8_t Cpu_Read8(Cpu *cpu, uint32_t address) {
+    Clic3Bus *bus = &cpu->bus;
+
+    address &= MEM_SIZE - 1;
+    if(address == P5IN && bus->control >= 11 && bus->control <= 14) {
+        if(bus->control == 11) bus->reads++;
+        return (uint8_t)((Bus_Device(bus) >> (4 * (bus->control - 11))) & 0x0F);
+    }
+    return cpu->mem[address];
+}
+
+uint16_t Cpu_Read16(Cpu *cpu, uint32_t address) {
+    address &= (MEM_SIZE - 1) & ~1u;
+    return (uint16_t)(Cpu_Read8(cpu, address) | (Cpu_Read8(cpu, address + 1) << 8));
+}
+
+static void Bus_Port(Cpu *cpu, uint32_t address, uint8_t value) {
+    Clic3Bus *bus = &cpu->bus;
+
+    if(address == PJOUT) {
+        bus->control = value & 0x0F;
+    } else if(address == P5OUT) {
+        if(bus->control >= 1 && bus->control <= 4) bus->address[bus->control - 1] = value & 0x0F;
+        else if(bus->control >= 6 && bus->control <= 9) bus->data[bus->control - 6] = value & 0x0F;
+    } else if(address == P4OUT) {
+        if((bus->p4out & 0x80) && !(value & 0x80) && (value & 0x40)) Bus_Strobe(bus);
+        bus->p4out = value;
+    }
+}
+
+void Cpu_Write8(Cpu *cpu, uint32_t address, uint8_t value) {
+    address &= MEM_SIZE - 1;
+    cpu->mem[address] = value;
+    Bus_Port(cpu, address, value);
+}
+
+void Cpu_Write16(Cpu *cpu, uint32_t address, uint16_t value) {
+    address &= (MEM_SIZE - 1) & ~1u;
+    cpu->mem[address] = (uint8_t)value;
+    cpu->mem[address + 1] = (uint8_t)(value >> 8);
+    Bus_Port(cpu, address, (uint8_t)value);
+}
+
+void Cpu_Push16(Cpu *cpu, uint16_t value) {
+    cpu->r[CPU_SP] = (cpu->r[CPU_SP] - 2) & 0xFFFF;
+    Cpu_Write16(cpu, cpu->r[CPU_SP], value);
+}
+
+static uint16_t Cpu_Pop16(Cpu *cpu) {
+    uint16_t value = Cpu_Read16(cpu, cpu->r[CPU_SP]);
+
+    cpu->r[CPU_SP] = (cpu->r[CPU_SP] + 2) & 0xFFFF;
+    return value;
+}
+
+static uint16_t Cpu_Fetch(Cpu *cpu) {
+    uint16_t word = Cpu_Read16(cpu, cpu->r[CPU_PC]);
+
+    cpu->r[CPU_PC] = (cpu->r[CPU_PC] + 2) & 0xFFFF;
+    return word;
+}
+
+void Cpu_Reset(Cpu *cpu, uint8_t *mem) {
+    memset(cpu, 0, sizeof *cpu);
+    cpu->mem = mem;
+    cpu->r[CPU_SP] = STACK_TOP;
+    cpu->bus.p4out = 0x80;
+}
+
+/* ========================= Operands ========================= */
+typedef struct {
+    unsigned char reg;          // Register mode: which one
+    unsigned char in_reg;       // 1 = register, 0 = memory or constant
+    uint32_t address;           // Memory operand
+    uint16_t value;             // Constant or immediate
+    unsigned char constant;     // 1 = value holds the operand
+} Operand;
+
+// Source operand for As/register; advances PC past an extension word
+static void Cpu_Source(Cpu *cpu, unsigned int as, unsigned int reg, int byte, Operand *op) {
+    uint16_t x;
+
+    memset(op, 0, sizeof *op);
+    if(reg == 3) {                                  // CG2: 0, 1, 2, -1
+        static const uint16_t cg2[4] = { 0, 1, 2, 0xFFFF };
+        op->constant = 1;
+        op->value = cg2[as];
+        if(byte) op->value &= 0xFF;
+        return;
+    }
+    if(reg == 2 && as >= 2) {                       // CG1: 4, 8
+        op->constant = 1;
+        op->value = (as == 2) ? 4 : 8;
+        return;
+    }
+    switch(as) {
+    case 0:
+        op->in_reg = 1;
+        op->reg = (unsigned char)reg;
+        break;
+    case 1:
+        x = Cpu_Fetch(cpu);
+        if(reg == 2) op->address = x;                                   // &EDE
+        else if(reg == 0) op->address = (cpu->r[CPU_PC] - 2 + x) & 0xFFFF; // EDE
+        else op->address = (cpu->r[reg] + x) & 0xFFFF;                  // x(Rn)
+        break;
+    case 2:
+        op->address = cpu->r[reg];
+        break;
+    case 3:
+        if(reg == 0) {                              // #N
+            op->constant = 1;
+            op->value = Cpu_Fetch(cpu);
+            if(byte) op->value &= 0xFF;
+        } else {
+            op->address = cpu->r[reg];
+            cpu->r[reg] = (cpu->r[reg] + ((byte && reg != CPU_SP) ? 1 : 2)) & 0xFFFF;
+        }
+        break;
+    }
+}
+
+static uint16_t Cpu_Get(Cpu *cpu, const Operand *op, int byte) {
+    if(op->constant) return op->value;
+    if(op->in_reg) return (uint16_t)(byte ? cpu->r[op->reg] & 0xFF : cpu->r[op->reg] & 0xFFFF);
+    return byte ? Cpu_Read8(cpu, op->address) : Cpu_Read16(cpu, op->address);
+}
+
+static void Cpu_Put(Cpu *cpu, const Operand *op, int byte, uint16_t value) {
+    if(op->in_reg) {
+        cpu->r[op->reg] = byte ? (value & 0xFF) : value;     // Byte writes clear the high byte
+        if(op->reg == CPU_PC) cpu->r[CPU_PC] &= 0xFFFE;
+    } else if(byte) {
+        Cpu_Write8(cpu, op->address, (uint8_t)value);
+    } else {
+        Cpu_Write16(cpu, op->address, value);
+    }
+}
+
+/* ========================= Flags ========================= */
+static void Cpu_Flags(Cpu *cpu, uint16_t result, int byte, int carry, int overflow) {
+    uint16_t sign = byte ? 0x80 : 0x8000;
+    uint16_t mask = byte ? 0xFF : 0xFFFF;
+    uint32_t sr = cpu->r[CPU_SR] & ~(SR_C | SR_Z | SR_N | SR_V);
+
+    if(!(result & mask)) sr |= SR_Z;
+    if(result & sign) sr |= SR_N;
+    if(carry) sr |= SR_C;
+    if(overflow) sr |= SR_V;
+    cpu->r[CPU_SR] = sr;
+}
+
+// dst + src + carry_in with flags; subtraction passes ~src and carry_in 1
+static uint16_t Cpu_Add(Cpu *cpu, uint16_t dst, uint16_t src, int carry_in, int byte) {
+    uint32_t mask = byte ? 0xFF : 0xFFFF;
+    uint32_t sign = byte ? 0x80 : 0x8000;
+    uint32_t sum;
+
+    dst &= mask;
+    src &= mask;
+    sum = dst + src + (carry_in ? 1 : 0);
+    Cpu_Flags(cpu, (uint16_t)(sum & mask), byte, sum > mask, !((dst ^ src) & sign) && ((dst ^ sum) & sign));
+    return (uint16_t)(sum & mask);
+}
+
+// DADD: dst + src + carry_in, one BCD digit per nibble; V is left as it was
+static uint16_t Cpu_DecimalAdd(Cpu *cpu, uint16_t dst, uint16_t src, int carry_in, int byte) {
+    unsigned int digits = byte ? 2 : 4, carry = carry_in ? 1 : 0, digit, i;
+    uint16_t sum = 0, overflow = (uint16_t)(cpu->r[CPU_SR] & SR_V);
+
+    for(i = 0; i < digits; i++) {
+        digit = ((dst >> (4 * i)) & 0x0F) + ((src >> (4 * i)) & 0x0F) + carry;
+        carry = digit > 9;
+        if(carry) digit -= 10;
+        sum |= (uint16_t)(digit << (4 * i));
+    }
+    Cpu_Flags(cpu, sum, byte, carry, overflow != 0);
+    return sum;
+}
+
+/* ========================= Execution ========================= */
+static int Cpu_Fail(Cpu *cpu, const char *what, uint32_t pc, uint16_t word) {
+    snprintf(cpu->error, sizeof cpu->error, "%s %04X at %04X", what, word, (unsigned int)pc);
+    return -1;
+}
+
+static int Cpu_Format1(Cpu *cpu, uint16_t word) {
+    unsigned int opcode = word >> 12;
+    unsigned int src_reg = (word >> 8) & 0xF, ad = (word >> 7) & 1, byte = (word >> 6) & 1;
+    unsigned int as = (word >> 4) & 3, dst_reg = word & 0xF;
+    unsigned int row, column, carry;
+    Operand src, dst;
+    uint16_t s, d, r = 0;
+    int write = 1;
+
+    Cpu_Source(cpu, as, src_reg, byte, &src);
+    if(ad) Cpu_Source(cpu, 1, dst_reg, byte, &dst);
+    else {
+        memset(&dst, 0, sizeof dst);
+        dst.in_reg = 1;
+        dst.reg = (unsigned char)dst_reg;
+    }
+
+    // Cycles
+    if(src.constant && !(as == 3 && src_reg == 0)) row = 0;
+    else if(as == 0) row = 0;
+    else if(as == 1) row = 4;
+    else if(as == 2) row = 1;
+    else row = (src_reg == 0) ? 3 : 2;
+    column = ad ? 2 : (dst_reg == CPU_PC ? 1 : 0);
+    cpu->cycles += cycles_format1[row][column];
+    if(ad && (opcode == 0x4 || opcode == 0x9 || opcode == 0xB)) cpu->cycles--;
+
+    s = Cpu_Get(cpu, &src, byte);
+    d = (opcode == 0x4) ? 0 : Cpu_Get(cpu, &dst, byte);
+    carry = cpu->r[CPU_SR] & SR_C;
+
+    switch(opcode) {
+    case 0x4: r = s; break;                                         // MOV
+    case 0x5: r = Cpu_Add(cpu, d, s, 0, byte); break;               // ADD
+    case 0x6: r = Cpu_Add(cpu, d, s, carry, byte); break;           // ADDC
+    case 0x7: r = Cpu_Add(cpu, d, (uint16_t)~s, carry, byte); break; // SUBC
+    case 0x8: r = Cpu_Add(cpu, d, (uint16_t)~s, 1, byte); break;    // SUB
+    case 0x9: Cpu_Add(cpu, d, (uint16_t)~s, 1, byte); write = 0; break; // CMP
+    case 0xB:                                                       // BIT
+    case 0xF:                                                       // AND
+        r = s & d;
+        Cpu_Flags(cpu, r, byte, (r & (byte ? 0xFF : 0xFFFF)) != 0, 0);
+        if(opcode == 0xB) write = 0;
+        break;
+    case 0xA: r = Cpu_DecimalAdd(cpu, d, s, carry, byte); break;    // DADD
+    case 0xC: r = d & ~s; break;                                    // BIC
+    case 0xD: r = d | s; break;                                     // BIS
+    case 0xE: {                                                     // XOR
+        uint16_t sign = byte ? 0x80 : 0x8000;
+        r = s ^ d;
+        Cpu_Flags(cpu, r, byte, (r & (byte ? 0xFF : 0xFFFF)) != 0, (s & sign) && (d & sign));
+        break;
+    }
+    default:
+        return Cpu_Fail(cpu, "unsupported instruction", cpu->r[CPU_PC], word);
+    }
+    if(write) Cpu_Put(cpu, &dst, byte, r);
+    return 0;
+}
+
+static int Cpu_Format2(Cpu *cpu, uint32_t pc, uint16_t word) {
+    unsigned int op = (word >> 7) & 7, byte = (word >> 6) & 1, as = (word >> 4) & 3, reg = word & 0xF;
+    Operand opnd;
+    uint16_t v, r, sign = byte ? 0x80 : 0x8000;
+    int carry;
+
+    if(word == 0x1300) {                                            // RETI
+        cpu->r[CPU_SR] = Cpu_Pop16(cpu);
+        cpu->r[CPU_PC] = Cpu_Pop16(cpu);
+        cpu->cycles += 5;
+        return 0;
+    }
+    if(op == 6 || op == 7) {                                        // CALLA
+        uint32_t target;
+        unsigned int mode = (word >> 4) & 0xF;
+        switch(mode) {
+        case 0x4: target = cpu->r[reg]; break;
+        case 0x6: target = Cpu_Read16(cpu, cpu->r[reg]); break;
+        case 0x8: target = ((uint32_t)reg << 16) | Cpu_Fetch(cpu); break;                   // &abs20
+        case 0xB: target = ((uint32_t)reg << 16) | Cpu_Fetch(cpu); break;                   // #imm20
+        default:  return Cpu_Fail(cpu, "unsupported CALLA form", pc, word);
+        }
+        Cpu_Push16(cpu, (uint16_t)((cpu->r[CPU_PC] >> 16) & 0xF));
+        Cpu_Push16(cpu, (uint16_t)cpu->r[CPU_PC]);
+        if(mode == 0x8) target = Cpu_Read16(cpu, target);
+        cpu->r[CPU_PC] = target & 0xFFFF;
+        cpu->cycles += 5;
+        return 0;
+    }
+
+    Cpu_Source(cpu, as, reg, byte, &opnd);
+    switch(op) {
+    case 0: case 1: case 2: case 3:                                 // RRC, SWPB, RRA, SXT
+        if(opnd.constant) return Cpu_Fail(cpu, "bad operand", pc, word);
+        cpu->cycles += (as == 0) ? 1 : (as == 1) ? 4 : 3;
+        v = Cpu_Get(cpu, &opnd, byte);
+        carry = cpu->r[CPU_SR] & SR_C;
+        if(op == 0) {
+            r = (uint16_t)((v >> 1) | (carry ? sign : 0));
+            Cpu_Flags(cpu, r, byte, v & 1, 0);
+        } else if(op == 1) {
+            r = (uint16_t)((v >> 8) | (v << 8));
+        } else if(op == 2) {
+            r = (uint16_t)((v >> 1) | (v & sign));
+            Cpu_Flags(cpu, r, byte, v & 1, 0);
+        } else {
+            r = (uint16_t)(int16_t)(int8_t)(v & 0xFF);
+            Cpu_Flags(cpu, r, 0, r != 0, 0);
+            byte = 0;
+        }
+        Cpu_Put(cpu, &opnd, (int)byte, r);
+        return 0;
+    case 4:                                                         // PUSH
+        cpu->cycles += (as == 1) ? 4 : 3;
+        v = Cpu_Get(cpu, &opnd, byte);
+        Cpu_Push16(cpu, v);
+        return 0;
+    case 5:                                                         // CALL
+        if(as == 1) cpu->cycles += (reg == 2) ? 6 : 5;
+        else cpu->cycles += 4;
+        v = Cpu_Get(cpu, &opnd, 0);
+        Cpu_Push16(cpu, (uint16_t)cpu->r[CPU_PC]);
+        cpu->r[CPU_PC] = v & 0xFFFE;
+        return 0;
+    }
+    return Cpu_Fail(cpu, "unsupported instruction", pc, word);
+}
+
+static int Cpu_Jump(Cpu *cpu, uint16_t word) {
+    uint32_t sr = cpu->r[CPU_SR];
+    int n = !!(sr & SR_N), v = !!(sr & SR_V);
+    int taken;
+    int16_t offset = (int16_t)((word & 0x3FF) << 6) >> 6;
+
+    switch((word >> 10) & 7) {
+    case 0: taken = !(sr & SR_Z); break;
+    case 1: taken = !!(sr & SR_Z); break;
+    case 2: taken = !(sr & SR_C); break;
+    case 3: taken = !!(sr & SR_C); break;
+    case 4: taken = n; break;
+    case 5: taken = (n == v); break;
+    case 6: taken = (n != v); break;
+    default: taken = 1; break;
+    }
+    if(taken) cpu->r[CPU_PC] = (cpu->r[CPU_PC] + 2 * offset) & 0xFFFF;
+    cpu->cycles += 2;
+    return 0;
+}
+
+int Cpu_Step(Cpu *cpu) {
+    uint32_t pc = cpu->r[CPU_PC];
+    uint16_t word = Cpu_Fetch(cpu);
+
+    cpu->instructions++;
+    cpu->r[3] = 0;
+    if(word == 0x0110) {                                            // RETA
+        uint32_t low = Cpu_Pop16(cpu);
+        uint32_t high = Cpu_Pop16(cpu) & 0xF;
+        cpu->r[CPU_PC] = ((high << 16) | low) & 0xFFFF;
+        cpu->cycles += 4;
+        return 0;
+    }
+    if(word >= 0x4000) return Cpu_Format1(cpu, word);
+    if(word >= 0x2000) return Cpu_Jump(cpu, word);
+    if(word >= 0x1000 && word < 0x1400) return Cpu_Format2(cpu, pc, word);
+    return Cpu_Fail(cpu, "unsupported instruction", pc, word);
+}
+
+int Cpu_Run(Cpu *cpu, uint32_t stop_pc, unsigned long limit) {
+    while(cpu->r[CPU_PC] != stop_pc) {
+        if(cpu->r[CPU_SR] & SR_CPUOFF) {
+            snprintf(cpu->error, sizeof cpu->error, "CPU went to sleep at %04X", (unsigned int)cpu->r[CPU_PC]);
+            return -1;
+        }
+        if(limit-- == 0) {
+            snprintf(cpu->error, sizeof cpu->error, "no return after %lu instructions", cpu->instructions);
+            return -1;
+        }
+        if(cpu->hook && cpu->r[CPU_PC] == cpu->hook_pc) cpu->hook(cpu);
+        if(Cpu_Step(cpu)) return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,102 @@
+#ifndef MSP430F5308_ASM_H
+#define MSP430F5308_ASM_H
+
+/* ========================= MSP430F5308 Memory Map (cycle benchmark) =========================
+ * Stands in for the IAR device header when the assembly sources are run
+ * through the C preprocessor for asm430.c. Registers are their real addresses
+ * and vectors are offsets into INTVEC, as in IAR's header for assembly.
+ * Only what the CLIC3 assembly uses is here.
+ */
+
+/* ========================= Status Register ========================= */
+#define GIE             0x0008
+#define CPUOFF          0x0010
+#define OSCOFF          0x0020
+#define SCG0            0x0040
+#define SCG1            0x0080
+#define LPM0            (CPUOFF)
+#define LPM3            (SCG1 + SCG0 + CPUOFF)
+
+/* ========================= Ports ========================= */
+#define P1IN            0x0200
+#define P2IN            0x0201
+#define P1OUT           0x0202
+#define P2OUT           0x0203
+#define P1DIR           0x0204
+#define P2DIR           0x0205
+#define P1REN           0x0206
+#define P2REN           0x0207
+#define P1SEL           0x020A
+#define P2SEL           0x020B
+#define P1IES           0x0218
+#define P2IES           0x0219
+#define P1IE            0x021A
+#define P2IE            0x021B
+#define P1IFG           0x021C
+#define P2IFG           0x021D
+
+#define P3IN            0x0220
+#define P4IN            0x0221
+#define P3OUT           0x0222
+#define P4OUT           0x0223
+#define P3DIR           0x0224
+#define P4DIR           0x0225
+#define P3REN           0x0226
+#define P4REN           0x0227
+#define P3SEL           0x022A
+#define P4SEL           0x022B
+
+#define P5IN            0x0240
+#define P6IN            0x0241
+#define P5OUT           0x0242
+#define P6OUT           0x0243
+#define P5DIR           0x0244
+#define P6DIR           0x0245
+#define P5SEL           0x024A
+
+#define PJIN            0x0320
+#define PJOUT           0x0322
+#define PJDIR           0x0324
+
+/* ========================= Timer_A0 ========================= */
+#define TA0CTL          0x0340
+#define TA0CCTL0        0x0342
+#define TA0R            0x0350
+#define TA0CCR0         0x0352
+
+#define TASSEL_1        0x0100
+#define TASSEL_2        0x0200
+#define MC_1            0x0010
+#define MC_2            0x0020
+#define TACLR           0x0004
+#define CCIE            0x0010
+
+/* ========================= USCI_B1 (I2C) ========================= */
+#define UCB1CTL1        0x0620
+#define UCB1CTL0        0x0621
+#define UCB1BR0         0x0626
+#define UCB1BR1         0x0627
+#define UCB1TXBUF       0x062E
+#define UCB1I2CSA       0x0632
+#define UCB1IE          0x063C
+#define UCB1IFG         0x063D
+
+#define UCMST           0x08
+#define UCMODE_3        0x06
+#define UCSYNC          0x01
+#define UCSSEL_1        0x40
+#define UCSSEL_2        0x80
+#define UCTR            0x10
+#define UCTXSTP         0x04
+#define UCTXSTT         0x02
+#define UCSWRST         0x01
+#define UCTXIFG         0x02
+
+/* ========================= Interrupt Vectors (offsets into INTVEC) ========================= */
+#define PORT2_VECTOR        (42 * 2)
+#define USCI_B1_VECTOR      (45 * 2)
+#define TIMER0_A1_VECTOR    (52 * 2)
+#define TIMER0_A0_VECTOR    (53 * 2)
+#define RESET_VECTOR        (63 * 2)
+
+#endif
@@ -0,0 +1,347 @@
+#include <stdio.h>
+#include <string.h>
+#include "sim.h"
+#include "intrinsics.h"
+#include "bus.h"
+
+/* ========================= Board State ========================= */
+unsigned char board_switches;
+unsigned char board_leds;
+unsigned char board_seg[2];
+unsigned char board_keypad;
+char board_lcd[2][17];
+unsigned char board_lcd_on;
+unsigned long board_lcd_bytes;
+unsigned long board_lcd_early;
+unsigned char board_lcd_connected;
+unsigned char board_sda_held;
+uint64_t board_led_edges[8][2];             // Last two toggle times of each LED
+int board_verbose;
+
+static void Board_Stamp(void) {
+    printf("[%10.3f s] ", (double)sim_now / SIM_MCLK_HZ);
+}
+
+/* ========================= Initial (stands in for Initial.asm) ========================= */
+// Same end state as the assembly: DCO on every clock, TA1 up mode for the P1.7
+// reference, bus control pins idle, then the LCD reset pulse
+void Initial(void) {
+    WDTCTL = WDTPW | WDTHOLD;
+    UCSCTL4 = SELA__DCOCLK | SELS__DCOCLK | SELM__DCOCLK;
+
+    TA1CCR0 = CLOCK_TICK_CYCLES - 1;
+    TA1CTL |= TASSEL_1 | MC_1;
+    TA1CCTL0 |= OUTMOD_4;
+    P1DIR |= 0x80;
+    P1SEL |= 0x80;
+
+    PJDIR = 0x0F;
+    PJOUT = 0x00;
+    P4DIR = 0xC0;
+    P4OUT = (P4OUT & ~0x40) | 0x80;
+    P1REN |= 0x03;
+    P1OUT &= ~0x03;
+
+    __delay_cycles(CLOCK_CYCLES_US(2400));  // LCD reset low, then high (1.2 ms each)
+}
+
+/* ========================= CLIC3 Bus Devices ========================= */
+void Board_LedsChanged(unsigned char old_leds) {
+    unsigned char changed = old_leds ^ board_leds;
+    unsigned char n;
+
+    for(n = 0; n < 8; n++) {
+        if(!(changed & (1 << n))) continue;
+        board_led_edges[n][0] = board_led_edges[n][1];
+        board_led_edges[n][1] = sim_now;
+    }
+    if(board_verbose && changed) {
+        Board_Stamp();
+        printf("LEDS ");
+        for(n = 8; n--; ) putchar((board_leds & (1 << n)) ? '.' : '0' + n);
+        putchar('\n');
+    }
+}
+
+unsigned int BusReadAt(unsigned int address) {
+    Sim_Advance(SIM_BUS_CYCLES);
+    switch(address) {
+    case SWITCHES_ADDR: return board_switches;
+    case KEYPAD_ADDR:   return board_keypad;
+    default:            return 0xFF;    // Output latches read back nothing
+    }
+}
+
+void BusWriteAt(unsigned int address, unsigned int data) {
+    unsigned char old_leds = board_leds;
+
+    Sim_Advance(SIM_BUS_CYCLES);
+    switch(address) {
+    case LED_ADDR:
+        board_leds = (unsigned char)data;
+        if(board_leds != old_leds) Board_LedsChanged(old_leds);
+        break;
+    case SEG_LOW:
+    case SEG_HIGH:
+        if(board_seg[address == SEG_HIGH] == (unsigned char)data) break;
+        board_seg[address == SEG_HIGH] = (unsigned char)data;
+        if(board_verbose) {
+            Board_Stamp();
+            printf("SEG %02X %02X\n", board_seg[1], board_seg[0]);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void BusRead(void) {
+    BusData = BusReadAt(BusAddress);
+}
+
+void BusWrite(void) {
+    BusWriteAt(BusAddress, BusData);
+}
+
+void BusWriteBurst(const BusXfer *items, unsigned int count) {
+    while(count--) {
+        BusWriteAt(items->address, items->data);
+        items++;
+    }
+}
+
+/* ========================= ST7032 (I2C 0x3E) ========================= */
+#define LCD_ADDR            0x3E
+#define LCD_CLEAR_CYCLES    (SIM_MS(108) / 100)     // Clear display and return home: 1.08 ms
+
+static unsigned char lcd_ddram[0x80];
+static unsigned char lcd_ac;                // DDRAM address counter
+static unsigned char lcd_selected;          // This transfer is for us
+static unsigned char lcd_control;           // 0 = control byte next, 1 = one byte, 2 = until STOP
+static unsigned char lcd_rs;                // 1 = data, 0 = instruction
+static unsigned char lcd_changed;
+static uint64_t lcd_busy_until;
+
+static void Lcd_Instruction(unsigned char cmd) {
+    if(sim_now < lcd_busy_until) board_lcd_early++;
+
+    if(cmd >= 0x80) {                           // Set DDRAM address
+        lcd_ac = cmd & 0x7F;
+    } else if(cmd == 0x01) {                    // Clear display
+        memset(lcd_ddram, ' ', sizeof lcd_ddram);
+        lcd_ac = 0;
+        lcd_changed = 1;
+        lcd_busy_until = sim_now + LCD_CLEAR_CYCLES;
+    } else if(cmd >= 0x02 && cmd <= 0x03) {     // Return home
+        lcd_ac = 0;
+        lcd_busy_until = sim_now + LCD_CLEAR_CYCLES;
+    } else if(cmd >= 0x08 && cmd <= 0x0F) {     // Display on/off
+        if(board_lcd_on != !!(cmd & 0x04)) lcd_changed = 1;
+        board_lcd_on = !!(cmd & 0x04);
+    }
+    // Function set, entry mode, oscillator, contrast and follower: no visible effect
+}
+
+static void Lcd_Data(unsigned char value) {
+    if(sim_now < lcd_busy_until) board_lcd_early++;
+    if(lcd_ddram[lcd_ac] != value) lcd_changed = 1;
+    lcd_ddram[lcd_ac] = value;
+
+    // Two-line mode: 0x00-0x27 and 0x40-0x67
+    if(lcd_ac == 0x27) lcd_ac = 0x40;
+    else if(lcd_ac == 0x67) lcd_ac = 0x00;
+    else lcd_ac++;
+}
+
+static void Lcd_Start(void) {
+    lcd_selected = board_lcd_connected && (SIM_R(UCB1I2CSA) & 0x7F) == LCD_ADDR;
+    lcd_control = 0;
+}
+
+static void Lcd_Byte(unsigned char value) {
+    if(!lcd_selected) return;
+
+    if(lcd_control == 0) {                      // Control byte: Co, RS
+        lcd_rs = !!(value & 0x40);
+        lcd_control = (value & 0x80) ? 1 : 2;
+        return;
+    }
+    if(lcd_rs) Lcd_Data(value);
+    else Lcd_Instruction(value);
+    if(lcd_control == 1) lcd_control = 0;
+}
+
+static void Lcd_Stop(void) {
+    unsigned char line, i;
+
+    lcd_selected = 0;
+    if(!lcd_changed) return;
+    lcd_changed = 0;
+
+    for(line = 0; line < 2; line++) {
+        for(i = 0; i < 16; i++) board_lcd[line][i] = (char)lcd_ddram[line * 0x40 + i];
+        board_lcd[line][16] = 0;
+    }
+    if(board_verbose) {
+        Board_Stamp();
+        printf("LCD |%s|%s|%s\n", board_lcd[0], board_lcd[1], board_lcd_on ? "" : " (off)");
+    }
+}
+
+/* ========================= USCI_B1 (I2C master transmitter) =========================
+ * TXBUF is double-buffered as on the chip: TXIFG comes back as soon as the
+ * shift register takes a byte, and a START or STOP waits for the byte on the
+ * wire. A byte is 9 bit clocks, the address 10 (START included).
+ */
+static uint64_t i2c_free;                   // Shift register busy until
+static int i2c_txbuf;                       // Byte waiting in TXBUF (-1 = none)
+static unsigned char i2c_start;             // START requested
+static unsigned char i2c_address;           // Address on the wire (UCTXSTT still set)
+static unsigned char i2c_stop;              // STOP requested
+static unsigned char i2c_open;              // Between START and STOP
+static unsigned char i2c_nacked;            // Not acknowledged: bytes go nowhere until a START
+
+// The slave did not pull SDA low for the ACK: UCNACKIFG, and the master
+// holds SCL low until the firmware asks for a STOP (or a repeated START)
+static void I2C_Nack(void) {
+    i2c_nacked = 1;
+    i2c_txbuf = -1;
+    SIM_R(UCB1IFG) = (SIM_R(UCB1IFG) & ~UCTXIFG) | UCNACKIFG;
+}
+
+static uint64_t I2C_BitCycles(void) {
+    uint64_t hz = ((SIM_R(UCB1CTL1) & UCSSEL_3) == UCSSEL_1) ? Sim_AclkHz() : SIM_MCLK_HZ;
+    unsigned int br = SIM_R(UCB1BR0) | (SIM_R(UCB1BR1) << 8);
+    return SIM_MCLK_HZ * (br ? br : 1) / hz;
+}
+
+void Board_I2C_Sync(void) {
+    unsigned short ctl1 = SIM_R(UCB1CTL1);
+
+    if(ctl1 & UCSWRST) {                        // Held in reset: everything idles
+        if(i2c_open) Lcd_Stop();
+        i2c_txbuf = -1;
+        i2c_start = i2c_address = i2c_stop = i2c_open = i2c_nacked = 0;
+        SIM_R(UCB1IFG) = 0;
+        SIM_R(UCB1TXBUF) = SIM_TXBUF_EMPTY;
+        return;
+    }
+
+    // Requests made since the last look
+    if(SIM_R(UCB1TXBUF) != SIM_TXBUF_EMPTY) {
+        i2c_txbuf = SIM_R(UCB1TXBUF) & 0xFF;
+        SIM_R(UCB1TXBUF) = SIM_TXBUF_EMPTY;
+        SIM_R(UCB1IFG) &= ~UCTXIFG;
+    }
+    if((ctl1 & UCTXSTT) && !i2c_start && !i2c_address) i2c_start = 1;
+    if((ctl1 & UCTXSTP) && !i2c_stop) i2c_stop = 1;
+
+    // Run the bus up to now. A slave holding SDA low stalls everything.
+    while(sim_now >= i2c_free && !board_sda_held) {
+        if(i2c_address) {                       // Address acknowledged, or nobody there
+            i2c_address = 0;
+            SIM_R(UCB1CTL1) &= ~UCTXSTT;
+            if(!lcd_selected) I2C_Nack();
+        } else if(i2c_start) {                  // START (or repeated START) and address
+            if(i2c_open) Lcd_Stop();
+            Lcd_Start();
+            i2c_start = 0;
+            i2c_nacked = 0;
+            i2c_address = 1;
+            i2c_open = 1;
+            board_lcd_bytes++;
+            SIM_R(UCB1IFG) |= UCTXIFG;
+            i2c_free = sim_now + 10 * I2C_BitCycles();
+        } else if(i2c_txbuf >= 0 && i2c_open && !i2c_nacked) { // TXBUF into the shift register
+            if(!lcd_selected) {                 // Unplugged mid-transfer
+                I2C_Nack();
+                continue;
+            }
+            Lcd_Byte((unsigned char)i2c_txbuf);
+            i2c_txbuf = -1;
+            board_lcd_bytes++;
+            SIM_R(UCB1IFG) |= UCTXIFG;
+            i2c_free = sim_now + 9 * I2C_BitCycles();
+        } else if(i2c_stop && i2c_txbuf < 0) {  // STOP once the last byte is out
+            if(i2c_open) Lcd_Stop();
+            i2c_stop = 0;
+            i2c_open = 0;
+            SIM_R(UCB1CTL1) &= ~UCTXSTP;
+            i2c_free = sim_now + I2C_BitCycles();
+        } else {
+            break;                              // Idle, or SCL held until TXBUF is written
+        }
+    }
+}
+
+uint64_t Board_I2C_Due(void) {
+    if(board_sda_held) return UINT64_MAX;
+    if(i2c_address || i2c_start || i2c_stop || (i2c_txbuf >= 0 && i2c_open && !i2c_nacked)) return i2c_free;
+    return UINT64_MAX;
+}
+
+/* ========================= Cable Faults =========================
+ * "lcd unplug" takes the display off the bus (and its power with it): every
+ * address goes unacknowledged until "lcd plug", and the display comes back
+ * blank and off. "i2c stuck N" is a display cut off mid-byte: it holds SDA
+ * low until SCL has been clocked N more times, which only the firmware's bus
+ * recovery can do, with P4.1/P4.2 as open-drain GPIO (driven low through P4DIR).
+ */
+#define PORT4_SDA           0x02
+#define PORT4_SCL           0x04
+
+static unsigned char port4_scl;             // SCL level at the last look
+
+void Board_LcdConnect(unsigned char connected) {
+    if(board_lcd_connected && !connected) {
+        memset(lcd_ddram, ' ', sizeof lcd_ddram);
+        lcd_ac = 0;
+        lcd_selected = 0;
+        board_lcd_on = 0;
+        lcd_changed = 1;
+        Lcd_Stop();                             // Show it now
+    }
+    board_lcd_connected = connected;
+}
+
+void Board_Port4(void) {
+    unsigned char low = SIM_R(P4DIR) & ~SIM_R(P4OUT) & ~SIM_R(P4SEL);  // Pins pulled low
+    unsigned char scl = !(low & PORT4_SCL);
+
+    if(scl && !port4_scl && board_sda_held) board_sda_held--;  // Rising edge: one bit out
+    port4_scl = scl;
+
+    SIM_R(P4IN) &= ~(PORT4_SDA | PORT4_SCL);
+    if(scl) SIM_R(P4IN) |= PORT4_SCL;
+    if(!board_sda_held && !(low & PORT4_SDA)) SIM_R(P4IN) |= PORT4_SDA;
+}
+
+void Board_Reset(void) {
+    unsigned char n;
+
+    board_switches = 0x00;
+    board_leds = 0xFF;
+    board_seg[0] = board_seg[1] = 0xFF;
+    board_keypad = 0x00;
+    board_lcd_on = 0;
+    board_lcd_bytes = 0;
+    board_lcd_early = 0;
+    for(n = 0; n < 8; n++) board_led_edges[n][0] = board_led_edges[n][1] = 0;
+
+    memset(lcd_ddram, ' ', sizeof lcd_ddram);
+    memset(board_lcd, ' ', sizeof board_lcd);
+    board_lcd[0][16] = board_lcd[1][16] = 0;
+    lcd_ac = 0;
+    lcd_selected = 0;
+    lcd_control = 0;
+    lcd_changed = 0;
+    lcd_busy_until = 0;
+
+    i2c_free = 0;
+    i2c_txbuf = -1;
+    i2c_start = i2c_address = i2c_stop = i2c_open = i2c_nacked = 0;
+
+    board_lcd_connected = 1;
+    board_sda_held = 0;
+    port4_scl = 1;
+}
@@ -0,0 +1,28 @@
+# Static RAM per module from the MODULE SUMMARY of an IAR link map, one
+# "bytes module" line each (the ram target sorts and totals them).
+#
+# XLINK maps give it in the DATA column, ILINK maps in "rw data". Figures are
+# right-aligned under their heading and may use a space as the thousands
+# separator, so each is cut out by column position rather than split on blanks.
+/MODULE SUMMARY/ { summary = 1; next }
+
+summary && !ram_end {
+    if((p = index($0, "rw data")) > 0) ram_end = p + 6
+    else if($1 == "Module" && (p = index($0, "DATA")) > 0) ram_end = p + 3
+    if(ram_end) {
+        for(ram_start = p - 1; ram_start > 0 && substr($0, ram_start, 1) == " "; ram_start--);
+        ram_start++                     # Just after the heading to the left
+    }
+    next
+}
+
+summary {
+    if($1 ~ /^\*/ || $0 ~ /Grand Total/) exit   # Next section of the map
+    if(NF < 2 || $1 ~ /^[-(=]/ || $1 ~ /:$/) next   # Rules, units, totals, object directories
+    value = substr($0, ram_start, ram_end - ram_start + 1)
+    gsub(/ /, "", value)
+    if(value !~ /^[0-9]+$/) next
+    module = $1
+    sub(/\.r43$/, "", module)
+    print value + 0, module
+}
@@ -0,0 +1,44 @@
+#ifndef INTRINSICS_H
+#define INTRINSICS_H
+
+/* ========================= IAR Intrinsics (host build) =========================
+ * The status register and the cycle counter belong to the virtual board
+ * (sim.c): sleeping jumps to the next event, __delay_cycles() advances the
+ * clock and running events on the way, and GIE changes let pending
+ * interrupts in.
+ */
+#define __interrupt
+
+typedef unsigned int __istate_t;
+
+void __bis_SR_register(unsigned int bits);
+void __bic_SR_register(unsigned int bits);
+void __bis_SR_register_on_exit(unsigned int bits);
+void __bic_SR_register_on_exit(unsigned int bits);
+unsigned int __get_SR_register(void);
+
+void __enable_interrupt(void);
+void __disable_interrupt(void);
+__istate_t __get_interrupt_state(void);
+void __set_interrupt_state(__istate_t state);
+
+void __delay_cycles(unsigned long cycles);
+void __no_operation(void);
+
+// DADD: decimal add of packed BCD (4 or 8 digits, carry out of the top is lost)
+unsigned short __bcd_add_short(unsigned short a, unsigned short b);
+unsigned long __bcd_add_long(unsigned long a, unsigned long b);
+
+#define __even_in_range(value, bound)   (value)
+
+// CSTACK: the host code runs on the host's stack, so the firmware's stack
+// segment is an array in sim.c, with a stack pointer that each interrupt
+// entry moves down by a modelled frame (SIM_ISR_STACK_BYTES, sim.h) and
+// writes, so the stack monitor (stack.c) has real paint to find overwritten
+#define SIM_CSTACK_BYTES    512
+extern unsigned short sim_cstack[SIM_CSTACK_BYTES / 2];
+#define __segment_begin(name)   ((void *)sim_cstack)
+#define __segment_end(name)     ((void *)(sim_cstack + SIM_CSTACK_BYTES / 2))
+unsigned long __get_SP_register(void);
+
+#endif
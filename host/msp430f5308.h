@@ -0,0 +1,476 @@
+#ifndef MSP430F5308_H
+#define MSP430F5308_H
+
+/* ========================= MSP430F5308 Register Model (host build) =========================
+ * Stands in for the IAR device header when the firmware is built for the
+ * virtual board (see sim.h). Every peripheral register is a 16-bit slot in
+ * sim_regs[] reached through sim_reg(), which advances the virtual clock and
+ * lets the peripheral models react to the access, so polling loops such as
+ * while(!(UCB1IFG & UCTXIFG)) make progress exactly as on the chip.
+ *
+ * Only the registers and bits the CLIC3 sources use are modelled.
+ */
+
+enum sim_reg_id {
+    SIM_P1IN,
+    SIM_P1OUT,
+    SIM_P1DIR,
+    SIM_P1REN,
+    SIM_P1SEL,
+    SIM_P1IES,
+    SIM_P1IE,
+    SIM_P1IFG,
+    SIM_P1IV,
+    SIM_P2IN,
+    SIM_P2OUT,
+    SIM_P2DIR,
+    SIM_P2REN,
+    SIM_P2SEL,
+    SIM_P2IES,
+    SIM_P2IE,
+    SIM_P2IFG,
+    SIM_P2IV,
+    SIM_P3IN,
+    SIM_P3OUT,
+    SIM_P3DIR,
+    SIM_P3REN,
+    SIM_P3SEL,
+    SIM_P4IN,
+    SIM_P4OUT,
+    SIM_P4DIR,
+    SIM_P4REN,
+    SIM_P4SEL,
+    SIM_P5IN,
+    SIM_P5OUT,
+    SIM_P5DIR,
+    SIM_P5REN,
+    SIM_P5SEL,
+    SIM_P6IN,
+    SIM_P6OUT,
+    SIM_P6DIR,
+    SIM_P6REN,
+    SIM_P6SEL,
+    SIM_PJIN,
+    SIM_PJOUT,
+    SIM_PJDIR,
+    SIM_PJREN,
+    SIM_TA0CTL,
+    SIM_TA0R,
+    SIM_TA0CCTL0,
+    SIM_TA0CCTL1,
+    SIM_TA0CCTL2,
+    SIM_TA0CCTL3,
+    SIM_TA0CCTL4,
+    SIM_TA0CCTL5,
+    SIM_TA0CCTL6,
+    SIM_TA0CCR0,
+    SIM_TA0CCR1,
+    SIM_TA0CCR2,
+    SIM_TA0CCR3,
+    SIM_TA0CCR4,
+    SIM_TA0CCR5,
+    SIM_TA0CCR6,
+    SIM_TA0IV,
+    SIM_TA0EX0,
+    SIM_TA1CTL,
+    SIM_TA1R,
+    SIM_TA1CCTL0,
+    SIM_TA1CCTL1,
+    SIM_TA1CCTL2,
+    SIM_TA1CCTL3,
+    SIM_TA1CCTL4,
+    SIM_TA1CCTL5,
+    SIM_TA1CCTL6,
+    SIM_TA1CCR0,
+    SIM_TA1CCR1,
+    SIM_TA1CCR2,
+    SIM_TA1CCR3,
+    SIM_TA1CCR4,
+    SIM_TA1CCR5,
+    SIM_TA1CCR6,
+    SIM_TA1IV,
+    SIM_TA1EX0,
+    SIM_TA2CTL,
+    SIM_TA2R,
+    SIM_TA2CCTL0,
+    SIM_TA2CCTL1,
+    SIM_TA2CCTL2,
+    SIM_TA2CCTL3,
+    SIM_TA2CCTL4,
+    SIM_TA2CCTL5,
+    SIM_TA2CCTL6,
+    SIM_TA2CCR0,
+    SIM_TA2CCR1,
+    SIM_TA2CCR2,
+    SIM_TA2CCR3,
+    SIM_TA2CCR4,
+    SIM_TA2CCR5,
+    SIM_TA2CCR6,
+    SIM_TA2IV,
+    SIM_TA2EX0,
+    SIM_UCB1CTL0,
+    SIM_UCB1CTL1,
+    SIM_UCB1BR0,
+    SIM_UCB1BR1,
+    SIM_UCB1STAT,
+    SIM_UCB1TXBUF,
+    SIM_UCB1RXBUF,
+    SIM_UCB1I2COA,
+    SIM_UCB1I2CSA,
+    SIM_UCB1IE,
+    SIM_UCB1IFG,
+    SIM_UCB1IV,
+    SIM_UCSCTL0,
+    SIM_UCSCTL1,
+    SIM_UCSCTL2,
+    SIM_UCSCTL3,
+    SIM_UCSCTL4,
+    SIM_UCSCTL5,
+    SIM_UCSCTL6,
+    SIM_UCSCTL7,
+    SIM_UCSCTL8,
+    SIM_SFRIE1,
+    SIM_SFRIFG1,
+    SIM_SFRRPCR,
+    SIM_WDTCTL,
+    SIM_FCTL1,
+    SIM_FCTL3,
+    SIM_FCTL4,
+    SIM_PMMCTL0,
+    SIM_PMMCTL1,
+    SIM_SVSMHCTL,
+    SIM_SVSMLCTL,
+    SIM_PMMIFG,
+    SIM_PMMRIE,
+    SIM_SYSRSTIV,
+    SIM_REG_COUNT
+};
+
+volatile unsigned short *sim_reg(enum sim_reg_id id);
+#define SIM_REG(id)     (*sim_reg(id))
+
+// Digital I/O (8-bit)
+#define P1IN        SIM_REG(SIM_P1IN)
+#define P1OUT       SIM_REG(SIM_P1OUT)
+#define P1DIR       SIM_REG(SIM_P1DIR)
+#define P1REN       SIM_REG(SIM_P1REN)
+#define P1SEL       SIM_REG(SIM_P1SEL)
+#define P1IES       SIM_REG(SIM_P1IES)
+#define P1IE        SIM_REG(SIM_P1IE)
+#define P1IFG       SIM_REG(SIM_P1IFG)
+#define P1IV        SIM_REG(SIM_P1IV)
+#define P2IN        SIM_REG(SIM_P2IN)
+#define P2OUT       SIM_REG(SIM_P2OUT)
+#define P2DIR       SIM_REG(SIM_P2DIR)
+#define P2REN       SIM_REG(SIM_P2REN)
+#define P2SEL       SIM_REG(SIM_P2SEL)
+#define P2IES       SIM_REG(SIM_P2IES)
+#define P2IE        SIM_REG(SIM_P2IE)
+#define P2IFG       SIM_REG(SIM_P2IFG)
+#define P2IV        SIM_REG(SIM_P2IV)
+#define P3IN        SIM_REG(SIM_P3IN)
+#define P3OUT       SIM_REG(SIM_P3OUT)
+#define P3DIR       SIM_REG(SIM_P3DIR)
+#define P3REN       SIM_REG(SIM_P3REN)
+#define P3SEL       SIM_REG(SIM_P3SEL)
+#define P4IN        SIM_REG(SIM_P4IN)
+#define P4OUT       SIM_REG(SIM_P4OUT)
+#define P4DIR       SIM_REG(SIM_P4DIR)
+#define P4REN       SIM_REG(SIM_P4REN)
+#define P4SEL       SIM_REG(SIM_P4SEL)
+#define P5IN        SIM_REG(SIM_P5IN)
+#define P5OUT       SIM_REG(SIM_P5OUT)
+#define P5DIR       SIM_REG(SIM_P5DIR)
+#define P5REN       SIM_REG(SIM_P5REN)
+#define P5SEL       SIM_REG(SIM_P5SEL)
+#define P6IN        SIM_REG(SIM_P6IN)
+#define P6OUT       SIM_REG(SIM_P6OUT)
+#define P6DIR       SIM_REG(SIM_P6DIR)
+#define P6REN       SIM_REG(SIM_P6REN)
+#define P6SEL       SIM_REG(SIM_P6SEL)
+
+// Port J
+#define PJIN        SIM_REG(SIM_PJIN)
+#define PJOUT       SIM_REG(SIM_PJOUT)
+#define PJDIR       SIM_REG(SIM_PJDIR)
+#define PJREN       SIM_REG(SIM_PJREN)
+
+// Timer_A: every block has CCR0-CCR6 so the model can index them alike
+// (TA0 has five channels on the F5308, TA1 and TA2 three)
+
+// Timer0_A
+#define TA0CTL      SIM_REG(SIM_TA0CTL)
+#define TA0R        SIM_REG(SIM_TA0R)
+#define TA0CCTL0    SIM_REG(SIM_TA0CCTL0)
+#define TA0CCTL1    SIM_REG(SIM_TA0CCTL1)
+#define TA0CCTL2    SIM_REG(SIM_TA0CCTL2)
+#define TA0CCTL3    SIM_REG(SIM_TA0CCTL3)
+#define TA0CCTL4    SIM_REG(SIM_TA0CCTL4)
+#define TA0CCTL5    SIM_REG(SIM_TA0CCTL5)
+#define TA0CCTL6    SIM_REG(SIM_TA0CCTL6)
+#define TA0CCR0     SIM_REG(SIM_TA0CCR0)
+#define TA0CCR1     SIM_REG(SIM_TA0CCR1)
+#define TA0CCR2     SIM_REG(SIM_TA0CCR2)
+#define TA0CCR3     SIM_REG(SIM_TA0CCR3)
+#define TA0CCR4     SIM_REG(SIM_TA0CCR4)
+#define TA0CCR5     SIM_REG(SIM_TA0CCR5)
+#define TA0CCR6     SIM_REG(SIM_TA0CCR6)
+#define TA0IV       SIM_REG(SIM_TA0IV)
+#define TA0EX0      SIM_REG(SIM_TA0EX0)
+
+// Timer1_A
+#define TA1CTL      SIM_REG(SIM_TA1CTL)
+#define TA1R        SIM_REG(SIM_TA1R)
+#define TA1CCTL0    SIM_REG(SIM_TA1CCTL0)
+#define TA1CCTL1    SIM_REG(SIM_TA1CCTL1)
+#define TA1CCTL2    SIM_REG(SIM_TA1CCTL2)
+#define TA1CCTL3    SIM_REG(SIM_TA1CCTL3)
+#define TA1CCTL4    SIM_REG(SIM_TA1CCTL4)
+#define TA1CCTL5    SIM_REG(SIM_TA1CCTL5)
+#define TA1CCTL6    SIM_REG(SIM_TA1CCTL6)
+#define TA1CCR0     SIM_REG(SIM_TA1CCR0)
+#define TA1CCR1     SIM_REG(SIM_TA1CCR1)
+#define TA1CCR2     SIM_REG(SIM_TA1CCR2)
+#define TA1CCR3     SIM_REG(SIM_TA1CCR3)
+#define TA1CCR4     SIM_REG(SIM_TA1CCR4)
+#define TA1CCR5     SIM_REG(SIM_TA1CCR5)
+#define TA1CCR6     SIM_REG(SIM_TA1CCR6)
+#define TA1IV       SIM_REG(SIM_TA1IV)
+#define TA1EX0      SIM_REG(SIM_TA1EX0)
+
+// Timer2_A
+#define TA2CTL      SIM_REG(SIM_TA2CTL)
+#define TA2R        SIM_REG(SIM_TA2R)
+#define TA2CCTL0    SIM_REG(SIM_TA2CCTL0)
+#define TA2CCTL1    SIM_REG(SIM_TA2CCTL1)
+#define TA2CCTL2    SIM_REG(SIM_TA2CCTL2)
+#define TA2CCTL3    SIM_REG(SIM_TA2CCTL3)
+#define TA2CCTL4    SIM_REG(SIM_TA2CCTL4)
+#define TA2CCTL5    SIM_REG(SIM_TA2CCTL5)
+#define TA2CCTL6    SIM_REG(SIM_TA2CCTL6)
+#define TA2CCR0     SIM_REG(SIM_TA2CCR0)
+#define TA2CCR1     SIM_REG(SIM_TA2CCR1)
+#define TA2CCR2     SIM_REG(SIM_TA2CCR2)
+#define TA2CCR3     SIM_REG(SIM_TA2CCR3)
+#define TA2CCR4     SIM_REG(SIM_TA2CCR4)
+#define TA2CCR5     SIM_REG(SIM_TA2CCR5)
+#define TA2CCR6     SIM_REG(SIM_TA2CCR6)
+#define TA2IV       SIM_REG(SIM_TA2IV)
+#define TA2EX0      SIM_REG(SIM_TA2EX0)
+
+// USCI_B1 (I2C)
+#define UCB1CTL0    SIM_REG(SIM_UCB1CTL0)
+#define UCB1CTL1    SIM_REG(SIM_UCB1CTL1)
+#define UCB1BR0     SIM_REG(SIM_UCB1BR0)
+#define UCB1BR1     SIM_REG(SIM_UCB1BR1)
+#define UCB1STAT    SIM_REG(SIM_UCB1STAT)
+#define UCB1TXBUF   SIM_REG(SIM_UCB1TXBUF)
+#define UCB1RXBUF   SIM_REG(SIM_UCB1RXBUF)
+#define UCB1I2COA   SIM_REG(SIM_UCB1I2COA)
+#define UCB1I2CSA   SIM_REG(SIM_UCB1I2CSA)
+#define UCB1IE      SIM_REG(SIM_UCB1IE)
+#define UCB1IFG     SIM_REG(SIM_UCB1IFG)
+#define UCB1IV      SIM_REG(SIM_UCB1IV)
+
+// Unified clock system
+#define UCSCTL0     SIM_REG(SIM_UCSCTL0)
+#define UCSCTL1     SIM_REG(SIM_UCSCTL1)
+#define UCSCTL2     SIM_REG(SIM_UCSCTL2)
+#define UCSCTL3     SIM_REG(SIM_UCSCTL3)
+#define UCSCTL4     SIM_REG(SIM_UCSCTL4)
+#define UCSCTL5     SIM_REG(SIM_UCSCTL5)
+#define UCSCTL6     SIM_REG(SIM_UCSCTL6)
+#define UCSCTL7     SIM_REG(SIM_UCSCTL7)
+#define UCSCTL8     SIM_REG(SIM_UCSCTL8)
+
+// SFR, watchdog, flash controller, PMM
+#define SFRIE1      SIM_REG(SIM_SFRIE1)
+#define SFRIFG1     SIM_REG(SIM_SFRIFG1)
+#define SFRRPCR     SIM_REG(SIM_SFRRPCR)
+#define WDTCTL      SIM_REG(SIM_WDTCTL)
+#define FCTL1       SIM_REG(SIM_FCTL1)
+#define FCTL3       SIM_REG(SIM_FCTL3)
+#define FCTL4       SIM_REG(SIM_FCTL4)
+#define PMMCTL0     SIM_REG(SIM_PMMCTL0)
+#define PMMCTL1     SIM_REG(SIM_PMMCTL1)
+#define SVSMHCTL    SIM_REG(SIM_SVSMHCTL)
+#define SVSMLCTL    SIM_REG(SIM_SVSMLCTL)
+#define PMMIFG      SIM_REG(SIM_PMMIFG)
+#define PMMRIE      SIM_REG(SIM_PMMRIE)
+#define SYSRSTIV    SIM_REG(SIM_SYSRSTIV)
+
+// Info memory lives in a host array (store.c addresses it from STORE_BASE)
+extern unsigned char sim_info_mem[512];
+#define STORE_BASE      ((unsigned long)sim_info_mem)
+
+/* ========================= Status Register ========================= */
+#define GIE             0x0008
+#define CPUOFF          0x0010
+#define OSCOFF          0x0020
+#define SCG0            0x0040
+#define SCG1            0x0080
+#define LPM0_bits       (CPUOFF)
+#define LPM1_bits       (SCG0 + CPUOFF)
+#define LPM3_bits       (SCG1 + SCG0 + CPUOFF)
+#define LPM4_bits       (SCG1 + SCG0 + OSCOFF + CPUOFF)
+
+/* ========================= Bits ========================= */
+#define BIT0            0x0001
+#define BIT1            0x0002
+#define BIT2            0x0004
+#define BIT3            0x0008
+#define BIT4            0x0010
+#define BIT5            0x0020
+#define BIT6            0x0040
+#define BIT7            0x0080
+
+// Timer_A control
+#define TASSEL_0        0x0000
+#define TASSEL_1        0x0100          // ACLK
+#define TASSEL_2        0x0200          // SMCLK
+#define TASSEL_3        0x0300
+#define TASSEL__ACLK    TASSEL_1
+#define TASSEL__SMCLK   TASSEL_2
+#define ID_0            0x0000
+#define ID_1            0x0040
+#define ID_2            0x0080
+#define ID_3            0x00C0
+#define MC_0            0x0000
+#define MC_1            0x0010          // Up to CCR0
+#define MC_2            0x0020          // Continuous
+#define MC_3            0x0030          // Up/down (not modelled: counts as up)
+#define MC__STOP        MC_0
+#define MC__UP          MC_1
+#define MC__CONTINUOUS  MC_2
+#define TACLR           0x0004
+#define TAIE            0x0002
+#define TAIFG           0x0001
+
+// Timer_A capture/compare control
+#define CM_1            0x4000
+#define CM_2            0x8000
+#define CM_3            0xC000
+#define CCIS_0          0x0000
+#define CCIS_1          0x1000
+#define CCIS_2          0x2000
+#define SCS             0x0800
+#define SCCI            0x0400
+#define CAP             0x0100
+#define OUTMOD_0        0x0000
+#define OUTMOD_4        0x0080
+#define OUTMOD_7        0x00E0
+#define CCIE            0x0010
+#define CCI             0x0008
+#define OUT             0x0004
+#define COV             0x0002
+#define CCIFG           0x0001
+
+// USCI_B (I2C)
+#define UCA10           0x80
+#define UCSLA10         0x40
+#define UCMM            0x20
+#define UCMST           0x08
+#define UCMODE_3        0x06
+#define UCSYNC          0x01
+#define UCSSEL_0        0x00
+#define UCSSEL_1        0x40            // ACLK
+#define UCSSEL_2        0x80            // SMCLK
+#define UCSSEL_3        0xC0
+#define UCSSEL__ACLK    UCSSEL_1
+#define UCSSEL__SMCLK   UCSSEL_2
+#define UCTR            0x10
+#define UCTXNACK        0x08
+#define UCTXSTP         0x04
+#define UCTXSTT         0x02
+#define UCSWRST         0x01
+#define UCBBUSY         0x10
+#define UCRXIFG         0x01
+#define UCTXIFG         0x02
+#define UCSTTIFG        0x04
+#define UCSTPIFG        0x08
+#define UCALIFG         0x10
+#define UCNACKIFG       0x20
+#define UCRXIE          0x01
+#define UCTXIE          0x02
+#define UCSTTIE         0x04
+#define UCSTPIE         0x08
+#define UCALIE          0x10
+#define UCNACKIE        0x20
+
+// Unified clock system
+#define DCORSEL_0       0x0000
+#define DCORSEL_1       0x0010
+#define DCORSEL_2       0x0020
+#define DCORSEL_3       0x0030
+#define DCORSEL_4       0x0040
+#define DCORSEL_5       0x0050
+#define DCORSEL_6       0x0060
+#define DCORSEL_7       0x0070
+#define FLLD_0          0x0000
+#define FLLD_1          0x1000
+#define SELREF__XT1CLK  0x0000
+#define SELREF__REFOCLK 0x0020
+#define SELA_0          0x0000
+#define SELA_7          0x0700
+#define SELA__XT1CLK    0x0000
+#define SELA__VLOCLK    0x0100
+#define SELA__REFOCLK   0x0200
+#define SELA__DCOCLK    0x0300
+#define SELA__DCOCLKDIV 0x0400
+#define SELS__DCOCLK    0x0030
+#define SELS__DCOCLKDIV 0x0040
+#define SELM__DCOCLK    0x0003
+#define SELM__DCOCLKDIV 0x0004
+#define XT1OFF          0x0001
+#define XT2OFF          0x0100
+#define XCAP_3          0x000C
+#define DCOFFG          0x0001
+#define XT1LFOFFG       0x0002
+#define XT2OFFG         0x0008
+#define OFIFG           0x0002
+
+// Watchdog, flash controller, PMM
+#define WDTPW           0x5A00
+#define WDTHOLD         0x0080
+#define FWKEY           0xA500
+#define ERASE           0x0002
+#define MERAS           0x0004
+#define WRT             0x0040
+#define BLKWRT          0x0080
+#define BUSY            0x0001
+#define LOCK            0x0010
+#define LOCKA           0x0040
+#define PMMPW           0xA500
+#define PMMCOREV_0      0x0000
+#define PMMCOREV_1      0x0001
+#define PMMCOREV_2      0x0002
+#define PMMCOREV_3      0x0003
+
+/* ========================= Interrupt Vectors ========================= */
+// Vector numbers as in the IAR header: a higher number has higher priority.
+// #pragma vector is ignored on the host; sim.c binds handlers by name.
+#define RTC_VECTOR          41
+#define PORT2_VECTOR        42
+#define TIMER2_A1_VECTOR    43
+#define TIMER2_A0_VECTOR    44
+#define USCI_B1_VECTOR      45
+#define USCI_A1_VECTOR      46
+#define PORT1_VECTOR        47
+#define TIMER1_A1_VECTOR    48
+#define TIMER1_A0_VECTOR    49
+#define DMA_VECTOR          50
+#define USB_UBM_VECTOR      51
+#define TIMER0_A1_VECTOR    52
+#define TIMER0_A0_VECTOR    53
+#define ADC10_VECTOR        54
+#define USCI_B0_VECTOR      55
+#define USCI_A0_VECTOR      56
+#define WDT_VECTOR          57
+#define TIMER0_B1_VECTOR    58
+#define TIMER0_B0_VECTOR    59
+#define COMP_B_VECTOR       60
+#define UNMI_VECTOR         61
+#define SYSNMI_VECTOR       62
+#define RESET_VECTOR        63
+
+#endif
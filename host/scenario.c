@@ -0,0 +1,502 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "intrinsics.h"
+#include "sim.h"
+#include "latency.h"
+
+/* ========================= Scenario Scripts =========================
+ * One action per line, at a time in ms from reset ("1500", "2.5s") or relative
+ * to the line before ("+250", "+1s"):
+ *
+ *   <time> s3 on|off [bounce N]        S3 (switch bit 7), optionally with N bounces
+ *   <time> switches 0xNN               All eight switches
+ *   <time> key K [hold_ms] [bounce N]  Press keypad key K (0-15), default hold 80 ms
+ *   <time> lcd unplug|plug             LCD cable off (display loses power) or back on
+ *   <time> i2c stuck N                 LCD holds SDA low for the next N SCL clocks
+ *   <time> stack overflow              Something writes over the canary at the bottom of CSTACK
+ *   <time> stack main N                Main's frames are N bytes deep from now on (default 48)
+ *   <time> expect lcd1|lcd2 "text"     LCD line (trailing spaces ignored)
+ *   <time> expect seg NN               Seven-segment digits ('-' = blank)
+ *   <time> expect led N on|off|blink   LED DN (blink: toggled twice in the last 600 ms)
+ *   <time> print                       Show the board
+ *   <time> repeat N every T            Run the lines up to "done" N times, T apart;
+ *   ...                                times inside are offsets from the block start
+ *   done
+ *   <time> end                         Stop (required)
+ *
+ * "<time> if FLAG <action>" only acts in builds with FLAG set, "<time> unless
+ * FLAG <action>" only in builds without it (FLAG: S3_TIMESTAMP, TICKLESS,
+ * KEYPAD_POLL), and the two chain ("if S3_TIMESTAMP unless TICKLESS ...").
+ * The time counts either way, so "+0" after it stays where it was.
+ */
+enum {
+    ACT_S3, ACT_SWITCHES, ACT_KEY_DOWN, ACT_KEY_UP, ACT_LCD_LINK, ACT_I2C_STUCK, ACT_STACK_OVERFLOW, ACT_STACK_MAIN,
+    ACT_EXPECT_LCD, ACT_EXPECT_SEG, ACT_EXPECT_LED, ACT_PRINT, ACT_END
+};
+
+typedef struct {
+    uint64_t at;                            // MCLK cycles
+    unsigned int order;                     // File order among equal times
+    unsigned int line;
+    unsigned char kind;
+    int arg, arg2;                          // Switch byte, key, LCD line, LED and state
+    char text[17];
+} Action;
+
+#define LED_BLINK_CYCLES    SIM_MS(600)
+
+// Hardware scan codes of the 16 keys (the keypad encoder on the CLIC3)
+static const unsigned char scenario_scan[16] = {
+    0x82, 0x11, 0x12, 0x14, 0x21, 0x22, 0x24, 0x41,
+    0x42, 0x44, 0x81, 0x84, 0x88, 0x48, 0x28, 0x18
+};
+
+static const unsigned char scenario_digits[10] = {
+    0x40, 0x79, 0x24, 0x30, 0x19, 0x12, 0x02, 0x78, 0x00, 0x18
+};
+
+static Action *actions;
+static unsigned int action_count, action_cap, action_next;
+static const char *scenario_name;
+static unsigned int expect_passed, expect_failed;
+static const char *flash_path;
+static struct timespec wall_start;
+
+// The firmware's stack monitor (stack.c), if the build has it
+extern unsigned int Stack_HighWater(void) __attribute__((weak));
+
+// The latency histograms (latency.c), if the build has them
+extern unsigned int latency_hist[LAT_COUNT][LATENCY_BUCKETS] __attribute__((weak));
+static const char * const latency_paths[LAT_COUNT] = { "S3>D7", "S3>Seg", "S3>LCD", "Key>LCD" };
+
+// Build flags a line can depend on (defaults as in main_all.c)
+#ifndef S3_TIMESTAMP
+#define S3_TIMESTAMP    0
+#endif
+#ifndef TICKLESS
+#define TICKLESS        0
+#endif
+#ifndef KEYPAD_POLL
+#define KEYPAD_POLL     0
+#endif
+
+static const struct {
+    const char *name;
+    int on;
+} scenario_flags[] = {
+    { "S3_TIMESTAMP", S3_TIMESTAMP },
+    { "TICKLESS", TICKLESS },
+    { "KEYPAD_POLL", KEYPAD_POLL },
+};
+
+/* ========================= Parsing ========================= */
+#define MAX_WORDS   10
+
+static void Parse_Error(unsigned int line, const char *message) {
+    fprintf(stderr, "%s:%u: %s\n", scenario_name, line, message);
+    exit(2);
+}
+
+static Action *Add(uint64_t at, unsigned int line, unsigned char kind) {
+    Action *action;
+
+    if(action_count == action_cap) {
+        action_cap = action_cap ? 2 * action_cap : 256;
+        actions = realloc(actions, action_cap * sizeof *actions);
+        if(!actions) Parse_Error(line, "out of memory");
+    }
+    action = &actions[action_count];
+    memset(action, 0, sizeof *action);
+    action->at = at;
+    action->order = action_count++;
+    action->line = line;
+    action->kind = kind;
+    return action;
+}
+
+// Split on blanks; "quoted text" is one word (quotes dropped)
+static int Split(char *text, char **words) {
+    int count = 0;
+
+    while(count < MAX_WORDS) {
+        text += strspn(text, " \t");
+        if(!*text) break;
+        if(*text == '"') {
+            words[count++] = ++text;
+            text += strcspn(text, "\"");
+        } else {
+            words[count++] = text;
+            text += strcspn(text, " \t");
+        }
+        if(!*text) break;
+        *text++ = 0;
+    }
+    return count;
+}
+
+// "1500", "2.5s", "+250", "+1s" -> ms; *relative says whether it had a '+'
+static int Parse_Time(const char *token, double *ms, int *relative) {
+    char *end;
+
+    *relative = (*token == '+');
+    *ms = strtod(token + *relative, &end);
+    if(end == token + *relative) return 0;
+    if(!strcmp(end, "s")) *ms *= 1000;
+    else if(*end && strcmp(end, "ms")) return 0;
+    return *ms >= 0;
+}
+
+static uint64_t Cycles(double ms) {
+    return (uint64_t)(ms * SIM_MCLK_HZ / 1000 + 0.5);
+}
+
+// Optional "bounce N" after the fixed words
+static int Build_Flag(const char *name, unsigned int line) {
+    unsigned int i;
+
+    for(i = 0; i < sizeof scenario_flags / sizeof scenario_flags[0]; i++) {
+        if(!strcmp(name, scenario_flags[i].name)) return scenario_flags[i].on;
+    }
+    Parse_Error(line, "unknown build flag");
+    return 0;
+}
+
+static int Bounce(char **words, int count, int from, unsigned int line) {
+    if(count == from) return 0;
+    if(count != from + 2 || strcmp(words[from], "bounce")) Parse_Error(line, "expected bounce N");
+    return atoi(words[from + 1]);
+}
+
+static void Parse_Action(char **words, int count, unsigned int line, uint64_t at) {
+    Action *action;
+    int n, i, level, bounce, hold = 80;
+
+    if(!strcmp(words[0], "s3") && count >= 2) {
+        if(strcmp(words[1], "on") && strcmp(words[1], "off")) Parse_Error(line, "s3 on|off");
+        level = !strcmp(words[1], "on");
+        bounce = Bounce(words, count, 2, line);
+        // Contact bounce: the new level and the old one alternate 1 ms apart
+        for(i = 0; i < 2 * bounce; i++) Add(at + SIM_MS(i), line, ACT_S3)->arg = (i & 1) ? !level : level;
+        Add(at + SIM_MS(2 * bounce), line, ACT_S3)->arg = level;
+    } else if(!strcmp(words[0], "switches") && count == 2) {
+        Add(at, line, ACT_SWITCHES)->arg = (int)strtol(words[1], 0, 0) & 0xFF;
+    } else if(!strcmp(words[0], "lcd") && count == 2) {
+        if(!strcmp(words[1], "unplug")) Add(at, line, ACT_LCD_LINK)->arg = 0;
+        else if(!strcmp(words[1], "plug")) Add(at, line, ACT_LCD_LINK)->arg = 1;
+        else Parse_Error(line, "lcd unplug|plug");
+    } else if(!strcmp(words[0], "i2c") && count == 3 && !strcmp(words[1], "stuck")) {
+        n = atoi(words[2]);
+        if(n < 1 || n > 9) Parse_Error(line, "i2c stuck N needs N 1-9");
+        Add(at, line, ACT_I2C_STUCK)->arg = n;
+    } else if(!strcmp(words[0], "stack") && count == 2 && !strcmp(words[1], "overflow")) {
+        Add(at, line, ACT_STACK_OVERFLOW);
+    } else if(!strcmp(words[0], "stack") && count == 3 && !strcmp(words[1], "main")) {
+        n = atoi(words[2]);
+        if(n < 2 || n > SIM_CSTACK_BYTES) Parse_Error(line, "stack main N needs N 2-512");
+        Add(at, line, ACT_STACK_MAIN)->arg = n;
+    } else if(!strcmp(words[0], "key") && count >= 2) {
+        n = atoi(words[1]);
+        if(n < 0 || n > 15) Parse_Error(line, "keys are 0-15");
+        i = 2;
+        if(count > 2 && strcmp(words[2], "bounce")) hold = atoi(words[i++]);
+        bounce = Bounce(words, count, i, line);
+        for(i = 0; i < bounce; i++) {
+            Add(at + SIM_MS(2 * i), line, ACT_KEY_DOWN)->arg = n;
+            Add(at + SIM_MS(2 * i + 1), line, ACT_KEY_UP)->arg = n;
+        }
+        Add(at + SIM_MS(2 * bounce), line, ACT_KEY_DOWN)->arg = n;
+        Add(at + SIM_MS(2 * bounce + hold), line, ACT_KEY_UP)->arg = n;
+    } else if(!strcmp(words[0], "expect") && count == 3 && (!strcmp(words[1], "lcd1") || !strcmp(words[1], "lcd2"))) {
+        if(strlen(words[2]) > 16) Parse_Error(line, "LCD lines are 16 characters");
+        action = Add(at, line, ACT_EXPECT_LCD);
+        action->arg = words[1][3] - '1';
+        strcpy(action->text, words[2]);
+    } else if(!strcmp(words[0], "expect") && count == 3 && !strcmp(words[1], "seg")) {
+        if(strlen(words[2]) != 2) Parse_Error(line, "expect seg NN");
+        strcpy(Add(at, line, ACT_EXPECT_SEG)->text, words[2]);
+    } else if(!strcmp(words[0], "expect") && count == 4 && !strcmp(words[1], "led")) {
+        n = atoi(words[2]);
+        if(n < 0 || n > 7) Parse_Error(line, "LEDs are 0-7");
+        if(!strcmp(words[3], "off")) level = 0;
+        else if(!strcmp(words[3], "on")) level = 1;
+        else if(!strcmp(words[3], "blink")) level = 2;
+        else Parse_Error(line, "expect led N on|off|blink");
+        action = Add(at, line, ACT_EXPECT_LED);
+        action->arg = n;
+        action->arg2 = level;
+    } else if(!strcmp(words[0], "print") && count == 1) {
+        Add(at, line, ACT_PRINT);
+    } else if(!strcmp(words[0], "end") && count == 1) {
+        Add(at, line, ACT_END);
+    } else {
+        Parse_Error(line, "unknown action");
+    }
+}
+
+static int Compare(const void *a, const void *b) {
+    const Action *x = a, *y = b;
+    if(x->at != y->at) return x->at < y->at ? -1 : 1;
+    return x->order < y->order ? -1 : (x->order > y->order);
+}
+
+static void Scenario_Load(const char *path) {
+    FILE *file = fopen(path, "r");
+    char buffer[256], *words[MAX_WORDS];
+    unsigned int line = 0, repeat_line = 0, k, first = 0, last, order;
+    double ms, last_ms = 0, block_ms = 0, every_ms = 0;
+    int count, relative, repeat = 0, i, in_block = 0, have_end = 0, skip, taken;
+    Action copy, *action;
+
+    scenario_name = path;
+    if(!file) {
+        perror(path);
+        exit(2);
+    }
+
+    while(fgets(buffer, sizeof buffer, file)) {
+        line++;
+        buffer[strcspn(buffer, "\r\n#")] = 0;
+        count = Split(buffer, words);
+        if(!count) continue;
+
+        if(!strcmp(words[0], "done") && count == 1) {
+            if(!in_block) Parse_Error(line, "done without repeat");
+            // Replay the block, each copy every_ms later than the one before
+            last = action_count;
+            for(i = 1; i < repeat; i++) {
+                for(k = first; k < last; k++) {
+                    copy = actions[k];
+                    action = Add(0, 0, 0);
+                    order = action->order;
+                    *action = copy;
+                    action->at += Cycles(i * every_ms);
+                    action->order = order;
+                }
+            }
+            last_ms = block_ms + repeat * every_ms;
+            in_block = 0;
+            continue;
+        }
+
+        if(count < 2) Parse_Error(line, "expected <time> <action>");
+        if(!Parse_Time(words[0], &ms, &relative)) Parse_Error(line, "bad time");
+        if(relative) ms += last_ms;
+        else if(in_block) ms += block_ms;
+        else if(ms < last_ms) Parse_Error(line, "time goes backwards");
+        last_ms = ms;
+
+        if(!strcmp(words[1], "repeat")) {
+            if(in_block) Parse_Error(line, "repeat blocks do not nest");
+            if(count != 5 || strcmp(words[3], "every") || !Parse_Time(words[4], &every_ms, &relative))
+                Parse_Error(line, "repeat N every T");
+            repeat = atoi(words[2]);
+            if(repeat < 1) Parse_Error(line, "repeat count");
+            in_block = 1;
+            first = action_count;
+            block_ms = ms;
+            repeat_line = line;
+            continue;
+        }
+        // "if FLAG" / "unless FLAG": this build may not take the action
+        for(skip = 1, taken = 1; skip < count && (!strcmp(words[skip], "if") || !strcmp(words[skip], "unless")); skip += 2) {
+            if(skip + 2 >= count) Parse_Error(line, "expected if|unless FLAG <action>");
+            if(Build_Flag(words[skip + 1], line) != !strcmp(words[skip], "if")) taken = 0;
+        }
+        if(!taken) continue;
+        if(!strcmp(words[skip], "end")) have_end = 1;
+        Parse_Action(words + skip, count - skip, line, Cycles(ms));
+    }
+    fclose(file);
+
+    if(in_block) Parse_Error(repeat_line, "repeat without done");
+    if(!have_end) Parse_Error(line, "no end");
+    qsort(actions, action_count, sizeof *actions, Compare);
+}
+
+/* ========================= Running ========================= */
+static char Segment_Char(unsigned char code) {
+    unsigned char i;
+
+    if((code & 0x7F) == 0x7F) return '-';
+    for(i = 0; i < 10; i++) {
+        if((code & 0x7F) == scenario_digits[i]) return '0' + i;
+    }
+    return '?';
+}
+
+static void Expect_Result(const Action *action, int ok, const char *want, const char *got) {
+    if(ok) {
+        expect_passed++;
+        return;
+    }
+    expect_failed++;
+    printf("%s:%u: at %.3f s expected %s, got %s\n", scenario_name, action->line,
+           (double)sim_now / SIM_MCLK_HZ, want, got);
+}
+
+static void Trim(char *text) {
+    size_t n = strlen(text);
+    while(n && text[n - 1] == ' ') text[--n] = 0;
+}
+
+static void Print_Board(void) {
+    printf("[%10.3f s] LCD |%s|%s|  SEG %c%c  LEDS %02X  S %02X\n", (double)sim_now / SIM_MCLK_HZ,
+           board_lcd[0], board_lcd[1], Segment_Char(board_seg[1]), Segment_Char(board_seg[0]),
+           board_leds, board_switches);
+}
+
+// Each path's histogram: the buckets in use as their lower bound and count
+static void Scenario_Latency(void) {
+    unsigned int path, n, used;
+
+    for(path = 0; path < LAT_COUNT; path++) {
+        printf("  latency %-7s", latency_paths[path]);
+        for(used = 0, n = 0; n < LATENCY_BUCKETS; n++) {
+            if(!latency_hist[path][n]) continue;
+            printf(" %luus+ x%u", n ? 1UL << n : 0UL, latency_hist[path][n]);
+            used = 1;
+        }
+        printf(used ? "\n" : " -\n");
+    }
+}
+
+static void Scenario_Finish(void) {
+    struct timespec wall_end;
+    double wall, simulated = (double)sim_now / SIM_MCLK_HZ;
+    FILE *file;
+
+    clock_gettime(CLOCK_MONOTONIC, &wall_end);
+    wall = (wall_end.tv_sec - wall_start.tv_sec) + (wall_end.tv_nsec - wall_start.tv_nsec) / 1e9;
+
+    if(flash_path && (file = fopen(flash_path, "wb")) != 0) {
+        fwrite(sim_info_mem, 1, sizeof sim_info_mem, file);
+        fclose(file);
+    }
+
+    printf("%s: %u/%u expectations met, %.3f s simulated in %.3f s (%.0fx)\n", scenario_name,
+           expect_passed, expect_passed + expect_failed, simulated, wall, wall > 0 ? simulated / wall : 0);
+    printf("  %lu interrupts, %lu LCD bytes, %lu flash erases, %lu flash words",
+           sim_interrupts, board_lcd_bytes, sim_flash_erases, sim_flash_words);
+    if(Stack_HighWater) printf(", stack peak %u bytes (modelled)", Stack_HighWater());
+    printf("\n");
+    if(latency_hist) Scenario_Latency();
+    if(board_lcd_early) printf("  warning: %lu LCD writes inside the 1.08 ms clear/home time\n", board_lcd_early);
+    fflush(stdout);
+    exit(expect_failed ? 1 : 0);
+}
+
+static void Apply(const Action *action) {
+    char want[40], got[40];
+    uint64_t *edges;
+    int state, ok;
+
+    switch(action->kind) {
+    case ACT_S3:
+        if(action->arg) board_switches |= 0x80;
+        else board_switches &= ~0x80;
+        break;
+    case ACT_SWITCHES:
+        board_switches = (unsigned char)action->arg;
+        break;
+    case ACT_KEY_DOWN:
+        board_keypad = scenario_scan[action->arg];
+        Sim_Port2Input(0, 1);
+        break;
+    case ACT_KEY_UP:
+        Sim_Port2Input(0, 0);
+        break;
+    case ACT_LCD_LINK:
+        Board_LcdConnect((unsigned char)action->arg);
+        break;
+    case ACT_I2C_STUCK:
+        board_sda_held = (unsigned char)action->arg;
+        break;
+    case ACT_STACK_OVERFLOW:
+        sim_cstack[0] = 0;
+        break;
+    case ACT_STACK_MAIN:
+        Sim_MainStack((unsigned int)action->arg);
+        break;
+    case ACT_EXPECT_LCD:
+        snprintf(want, sizeof want, "%s", action->text);
+        snprintf(got, sizeof got, "%s", board_lcd_on ? board_lcd[action->arg] : "(display off)");
+        Trim(want);
+        Trim(got);
+        ok = !strcmp(want, got);
+        snprintf(want, sizeof want, "lcd%d \"%.16s\"", action->arg + 1, action->text);
+        Expect_Result(action, ok, want, got);
+        break;
+    case ACT_EXPECT_SEG:
+        got[0] = Segment_Char(board_seg[1]);
+        got[1] = Segment_Char(board_seg[0]);
+        got[2] = 0;
+        snprintf(want, sizeof want, "seg %s", action->text);
+        Expect_Result(action, got[0] == action->text[0] && got[1] == action->text[1], want, got);
+        break;
+    case ACT_EXPECT_LED:
+        edges = board_led_edges[action->arg];
+        if(edges[0] && sim_now - edges[0] < LED_BLINK_CYCLES) state = 2;
+        else state = !(board_leds & (1 << action->arg));
+        snprintf(want, sizeof want, "led %d %s", action->arg, action->arg2 == 2 ? "blink" : action->arg2 ? "on" : "off");
+        snprintf(got, sizeof got, "%s", state == 2 ? "blink" : state ? "on" : "off");
+        Expect_Result(action, state == action->arg2, want, got);
+        break;
+    case ACT_PRINT:
+        Print_Board();
+        break;
+    case ACT_END:
+        Scenario_Finish();
+        break;
+    }
+}
+
+uint64_t Scenario_Due(void) {
+    return action_next < action_count ? actions[action_next].at : UINT64_MAX;
+}
+
+void Scenario_Run(void) {
+    while(action_next < action_count && actions[action_next].at <= sim_now) {
+        Apply(&actions[action_next++]);
+    }
+}
+
+/* ========================= Main ========================= */
+void clic3_main(void);                      // The firmware's main(), renamed by the Makefile
+
+int main(int argc, char **argv) {
+    const char *path = 0;
+    FILE *file;
+    int i;
+
+    for(i = 1; i < argc; i++) {
+        if(!strcmp(argv[i], "-v")) board_verbose = 1;
+        else if(!strcmp(argv[i], "--flash") && i + 1 < argc) flash_path = argv[++i];
+        else if(!path) path = argv[i];
+        else path = 0, i = argc;
+    }
+    if(!path) {
+        fprintf(stderr, "usage: %s [-v] [--flash image] scenario.txt\n", argv[0]);
+        return 2;
+    }
+
+    Scenario_Load(path);
+
+    // Info memory starts erased unless an image from an earlier run is given
+    memset(sim_info_mem, 0xFF, sizeof sim_info_mem);
+    if(flash_path && (file = fopen(flash_path, "rb")) != 0) {
+        if(fread(sim_info_mem, 1, sizeof sim_info_mem, file) != sizeof sim_info_mem) {
+            memset(sim_info_mem, 0xFF, sizeof sim_info_mem);
+        }
+        fclose(file);
+    }
+
+    Board_Reset();
+    Sim_Reset();
+    clock_gettime(CLOCK_MONOTONIC, &wall_start);
+    clic3_main();
+
+    fprintf(stderr, "sim: firmware main() returned\n");
+    return 3;
+}
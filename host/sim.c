@@ -0,0 +1,569 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+#include "intrinsics.h"
+
+/* ========================= Firmware Interrupt Handlers ========================= */
+// #pragma vector means nothing to the host compiler, so handlers are bound by
+// name. Weak references let builds that leave some of them out still link.
+extern void Timer_ISR(void) __attribute__((weak));
+extern void TimerWrap_ISR(void) __attribute__((weak));
+extern void Boot_ISR(void) __attribute__((weak));
+extern void Keypad_ISR(void) __attribute__((weak));
+extern void I2C_ISR(void) __attribute__((weak));
+
+typedef struct {
+    unsigned char vector;
+    void (*handler)(void);
+    const char *name;
+} SimVector;
+
+static const SimVector sim_vectors[] = {
+    { TIMER0_A0_VECTOR, Timer_ISR,       "Timer_ISR" },
+    { TIMER0_A1_VECTOR, TimerWrap_ISR,   "TimerWrap_ISR" },
+    { TIMER1_A1_VECTOR, Boot_ISR,        "Boot_ISR" },
+    { USCI_B1_VECTOR,   I2C_ISR,         "I2C_ISR" },
+    { PORT2_VECTOR,     Keypad_ISR,      "Keypad_ISR" },
+};
+
+/* ========================= State ========================= */
+volatile unsigned short sim_regs[SIM_REG_COUNT];
+uint64_t sim_now;
+unsigned int sim_sr;
+unsigned char sim_info_mem[512];
+unsigned long sim_flash_erases;
+unsigned long sim_flash_words;
+unsigned long sim_interrupts;
+unsigned short sim_cstack[SIM_CSTACK_BYTES / 2];
+unsigned int sim_sp;
+static unsigned int sim_main_sp;            // sim_sp whenever main is running
+static unsigned int sim_isr_depth;          // Interrupts entered and not yet returned from
+
+static int sim_last = -1;                   // Register of the previous access (may have been written)
+static uint64_t sim_due;                    // Next time something has to happen
+static unsigned int *sim_exit_bic;          // SR bits the running ISR clears on exit
+static unsigned int *sim_exit_bis;          // ...and sets
+
+/* ========================= Clocks ========================= */
+// MCLK = SMCLK = the DCO at CLOCK_HZ_ACTUAL from t = 0 (Initial's FLL lock is not modelled)
+uint64_t Sim_AclkHz(void) {
+    switch(SIM_R(UCSCTL4) & SELA_7) {
+    case SELA__XT1CLK:
+    case SELA__REFOCLK: return SIM_ACLK_LF_HZ;
+    case SELA__VLOCLK:  return 10000;
+    default:            return SIM_MCLK_HZ;
+    }
+}
+
+/* ========================= Timer_A ========================= */
+// Each block is CTL, R, CCTL0-6, CCR0-6, IV, EX0 (see msp430f5308.h)
+#define SIM_TIMERS          3
+#define SIM_TIMER_REGS      (SIM_TA1CTL - SIM_TA0CTL)
+#define T_CTL               0
+#define T_R                 1
+#define T_CCTL(n)           (2 + (n))
+#define T_CCR(n)            (9 + (n))
+#define T_IV                16
+#define T_EX0               17
+#define TREG(t, off)        sim_regs[SIM_TA0CTL + (t) * SIM_TIMER_REGS + (off)]
+
+static const unsigned char sim_timer_channels[SIM_TIMERS] = { 5, 3, 3 };
+static uint64_t timer_updated[SIM_TIMERS];  // sim_now at the last update
+static uint64_t timer_frac[SIM_TIMERS];     // Partial count, in (clock Hz) units
+
+// Counting clock in Hz (0 = stopped); Timer_Den() is MCLK times the input divider
+static uint64_t Timer_Hz(unsigned char t) {
+    switch(TREG(t, T_CTL) & TASSEL_3) {
+    case TASSEL_1: return Sim_AclkHz();
+    case TASSEL_2: return (sim_sr & SCG1) ? 0 : SIM_MCLK_HZ;   // SMCLK stops in LPM3
+    default:       return 0;
+    }
+}
+
+static uint64_t Timer_Den(unsigned char t) {
+    unsigned int div = (1u << ((TREG(t, T_CTL) >> 6) & 3)) * ((TREG(t, T_EX0) & 7) + 1);
+    return SIM_MCLK_HZ * div;
+}
+
+static uint64_t Timer_Period(unsigned char t) {
+    return ((TREG(t, T_CTL) & MC_3) == MC_2) ? 0x10000 : (uint64_t)TREG(t, T_CCR(0)) + 1;
+}
+
+// Counts until TAR next reaches value (a full period if it is there now)
+static uint64_t Timer_Dist(uint64_t from, uint64_t value, uint64_t period) {
+    uint64_t dist = (value + period - from) % period;
+    return dist ? dist : period;
+}
+
+// Step TAR by n counts, raising the flags of every compare and wrap passed on the way
+static void Timer_Count(unsigned char t, uint64_t n) {
+    uint64_t period = Timer_Period(t);
+    uint64_t r = TREG(t, T_R);
+    unsigned char ch;
+
+    if(r >= period) {                       // CCR0 moved below TAR: rolls to zero
+        r = 0;
+        n--;
+        TREG(t, T_CTL) |= TAIFG;
+    }
+    for(ch = 0; ch < sim_timer_channels[t]; ch++) {
+        if(TREG(t, T_CCTL(ch)) & CAP) continue;
+        if(TREG(t, T_CCR(ch)) >= period) continue;
+        if(Timer_Dist(r, TREG(t, T_CCR(ch)), period) <= n) TREG(t, T_CCTL(ch)) |= CCIFG;
+    }
+    if(period - r <= n) TREG(t, T_CTL) |= TAIFG;
+    TREG(t, T_R) = (unsigned short)((r + n) % period);
+}
+
+// Bring TAR and the flags up to sim_now
+static void Timer_Update(unsigned char t) {
+    uint64_t hz = Timer_Hz(t);
+    uint64_t elapsed = sim_now - timer_updated[t];
+    unsigned __int128 acc;
+    uint64_t den, n;
+
+    timer_updated[t] = sim_now;
+    if(!(TREG(t, T_CTL) & MC_3) || !hz || !elapsed) return;
+
+    den = Timer_Den(t);
+    acc = (unsigned __int128)elapsed * hz + timer_frac[t];
+    n = (uint64_t)(acc / den);
+    timer_frac[t] = (uint64_t)(acc % den);
+    if(n) Timer_Count(t, n);
+}
+
+// When the next interrupt-enabled compare or wrap falls (UINT64_MAX = never)
+static uint64_t Timer_Due(unsigned char t) {
+    uint64_t hz = Timer_Hz(t);
+    uint64_t period, r, best = UINT64_MAX, dist;
+    unsigned __int128 need;
+    unsigned char ch;
+
+    if(!(TREG(t, T_CTL) & MC_3) || !hz) return UINT64_MAX;
+
+    period = Timer_Period(t);
+    r = TREG(t, T_R);
+    if(r >= period) best = 1;
+    for(ch = 0; ch < sim_timer_channels[t]; ch++) {
+        if((TREG(t, T_CCTL(ch)) & (CCIE | CAP)) != CCIE) continue;
+        if(TREG(t, T_CCR(ch)) >= period) continue;
+        dist = Timer_Dist(r, TREG(t, T_CCR(ch)), period);
+        if(dist < best) best = dist;
+    }
+    if((TREG(t, T_CTL) & TAIE) && period - r < best) best = period - r;
+    if(best == UINT64_MAX) return UINT64_MAX;
+
+    need = (unsigned __int128)best * Timer_Den(t) - timer_frac[t];
+    return sim_now + (uint64_t)((need + hz - 1) / hz);
+}
+
+// TAxIV: highest pending enabled CCR1-6 or TAIFG, cleared by the read
+static unsigned short Timer_IV(unsigned char t) {
+    unsigned char ch;
+
+    for(ch = 1; ch < sim_timer_channels[t]; ch++) {
+        if((TREG(t, T_CCTL(ch)) & (CCIE | CCIFG)) == (CCIE | CCIFG)) {
+            TREG(t, T_CCTL(ch)) &= ~CCIFG;
+            return 2 * ch;
+        }
+    }
+    if((TREG(t, T_CTL) & (TAIE | TAIFG)) == (TAIE | TAIFG)) {
+        TREG(t, T_CTL) &= ~TAIFG;
+        return 14;
+    }
+    return 0;
+}
+
+static unsigned char Timer_Pending0(unsigned char t) {
+    return (TREG(t, T_CCTL(0)) & (CCIE | CCIFG)) == (CCIE | CCIFG);
+}
+
+static unsigned char Timer_Pending1(unsigned char t) {
+    unsigned char ch;
+
+    for(ch = 1; ch < sim_timer_channels[t]; ch++) {
+        if((TREG(t, T_CCTL(ch)) & (CCIE | CCIFG)) == (CCIE | CCIFG)) return 1;
+    }
+    return (TREG(t, T_CTL) & (TAIE | TAIFG)) == (TAIE | TAIFG);
+}
+
+/* ========================= Flash Controller ========================= */
+// Writes to info memory are plain stores on the host. The flash controller
+// compares the array with the copy taken when FCTL1 was last seen idle: in
+// ERASE mode a changed byte (the dummy write) erases its segment, in WRT mode
+// bits can only go from 1 to 0. Changes made with LOCK set are undone.
+static unsigned char flash_programmed[sizeof sim_info_mem];
+
+static void Flash_Check(void) {
+    unsigned int mode = SIM_R(FCTL1) & (ERASE | WRT);
+    unsigned int i, segment, bytes = 0;
+
+    if(!mode) {
+        memcpy(flash_programmed, sim_info_mem, sizeof sim_info_mem);
+        return;
+    }
+
+    for(i = 0; i < sizeof sim_info_mem; i++) {
+        if(sim_info_mem[i] == flash_programmed[i]) continue;
+        if(SIM_R(FCTL3) & LOCK) {
+            sim_info_mem[i] = flash_programmed[i];
+        } else if(mode & ERASE) {
+            segment = i & ~127u;
+            memset(&sim_info_mem[segment], 0xFF, 128);
+            memset(&flash_programmed[segment], 0xFF, 128);
+            sim_flash_erases++;
+            Sim_Advance(SIM_MS(SIM_FLASH_ERASE_MS));
+            i = segment + 127;
+        } else {
+            sim_info_mem[i] &= flash_programmed[i];
+            flash_programmed[i] = sim_info_mem[i];
+            bytes++;
+        }
+    }
+    if(bytes) {
+        sim_flash_words += (bytes + 1) / 2;
+        Sim_Advance(SIM_MS((bytes + 1) / 2 * SIM_FLASH_WORD_US) / 1000);
+    }
+}
+
+/* ========================= Interrupts ========================= */
+// Highest-priority pending source (0 = none), in vector order
+static unsigned char Sim_Pending(void) {
+    if(Timer_Pending0(0)) return TIMER0_A0_VECTOR;
+    if(Timer_Pending1(0)) return TIMER0_A1_VECTOR;
+    if(Timer_Pending0(1)) return TIMER1_A0_VECTOR;
+    if(Timer_Pending1(1)) return TIMER1_A1_VECTOR;
+    if(SIM_R(P1IE) & SIM_R(P1IFG)) return PORT1_VECTOR;
+    if(SIM_R(UCB1IE) & SIM_R(UCB1IFG)) return USCI_B1_VECTOR;
+    if(Timer_Pending0(2)) return TIMER2_A0_VECTOR;
+    if(Timer_Pending1(2)) return TIMER2_A1_VECTOR;
+    if(SIM_R(P2IE) & SIM_R(P2IFG)) return PORT2_VECTOR;
+    return 0;
+}
+
+static void Sim_Settle(void);
+
+static void Sim_SetSR(unsigned int sr) {
+    unsigned char t;
+
+    // SMCLK gating changes: timers on SMCLK count up to here at the old rate
+    if((sr ^ sim_sr) & SCG1) {
+        for(t = 0; t < SIM_TIMERS; t++) Timer_Update(t);
+        sim_sr = sr;
+        Sim_Reschedule();
+    } else {
+        sim_sr = sr;
+    }
+}
+
+static void Sim_Interrupt(unsigned char vector) {
+    const SimVector *entry = 0;
+    unsigned int saved = sim_sr, bic = 0, bis = 0;
+    unsigned int *outer_bic = sim_exit_bic, *outer_bis = sim_exit_bis;
+    unsigned int i, outer_sp = sim_sp;
+
+    for(i = 0; i < sizeof sim_vectors / sizeof sim_vectors[0]; i++) {
+        if(sim_vectors[i].vector == vector) entry = &sim_vectors[i];
+    }
+    if(!entry || !entry->handler) {
+        fprintf(stderr, "sim: interrupt vector %u pending with no handler\n", vector);
+        exit(3);
+    }
+
+    // Single-source vectors clear their flag on entry
+    if(vector == TIMER0_A0_VECTOR) TREG(0, T_CCTL(0)) &= ~CCIFG;
+    if(vector == TIMER1_A0_VECTOR) TREG(1, T_CCTL(0)) &= ~CCIFG;
+    if(vector == TIMER2_A0_VECTOR) TREG(2, T_CCTL(0)) &= ~CCIFG;
+
+    sim_interrupts++;
+    Sim_SetSR(0);                           // GIE and the LPM bits clear on entry
+    sim_now += SIM_ISR_CYCLES;
+    sim_exit_bic = &bic;
+    sim_exit_bis = &bis;
+
+    // The entry frame goes on the stack below the interrupted code's (a
+    // stack already at the bottom of CSTACK runs over the canary)
+    sim_sp = (sim_sp > SIM_ISR_STACK_BYTES) ? sim_sp - SIM_ISR_STACK_BYTES : 0;
+    for(i = sim_sp; i < outer_sp; i += 2) sim_cstack[i / 2] = 0;
+
+    sim_isr_depth++;
+    entry->handler();
+    Sim_Settle();
+    sim_sp = --sim_isr_depth ? outer_sp : sim_main_sp;  // Main's frames may have moved meanwhile
+    sim_exit_bic = outer_bic;
+    sim_exit_bis = outer_bis;
+    Sim_SetSR((saved & ~bic) | bis);        // RETI
+}
+
+static void Sim_CheckInterrupts(void) {
+    unsigned char vector;
+
+    while((sim_sr & GIE) && (vector = Sim_Pending()) != 0) Sim_Interrupt(vector);
+}
+
+/* ========================= Scheduler ========================= */
+uint64_t Sim_PeripheralDue(void) {
+    uint64_t due = Board_I2C_Due(), next;
+    unsigned char t;
+
+    for(t = 0; t < SIM_TIMERS; t++) {
+        Timer_Update(t);
+        next = Timer_Due(t);
+        if(next < due) due = next;
+    }
+    return due;
+}
+
+void Sim_Reschedule(void) {
+    uint64_t scenario = Scenario_Due();
+
+    sim_due = Sim_PeripheralDue();
+    if(scenario < sim_due) sim_due = scenario;
+}
+
+static void Sim_Events(void) {
+    unsigned char t, guard = 0;
+
+    do {
+        for(t = 0; t < SIM_TIMERS; t++) Timer_Update(t);
+        Board_I2C_Sync();
+        Scenario_Run();
+        Sim_Reschedule();
+    } while(sim_due <= sim_now && ++guard < 8);
+}
+
+void Sim_Advance(uint64_t cycles) {
+    uint64_t step;
+
+    do {
+        if(sim_now >= sim_due) Sim_Events();
+        step = cycles;
+        if(sim_due > sim_now && sim_due - sim_now < step) step = sim_due - sim_now;
+        sim_now += step;
+        cycles -= step;
+        if(sim_now >= sim_due) Sim_Events();
+        Sim_CheckInterrupts();
+    } while(cycles);
+}
+
+// The CPU is off: jump from event to event until an ISR wakes it
+static void Sim_Sleep(void) {
+    while(sim_sr & CPUOFF) {
+        if((sim_sr & GIE) && Sim_Pending()) {
+            Sim_CheckInterrupts();
+            continue;
+        }
+        if(sim_due == UINT64_MAX) {
+            fprintf(stderr, "sim: CPU asleep with nothing left to wake it\n");
+            exit(3);
+        }
+        if(sim_due > sim_now) sim_now = sim_due;
+        Sim_Events();
+    }
+}
+
+/* ========================= Register Access ========================= */
+static void Sim_PreAccess(enum sim_reg_id id) {
+    unsigned int offset;
+
+    if(id >= SIM_TA0CTL && id < SIM_TA0CTL + SIM_TIMERS * SIM_TIMER_REGS) {
+        offset = id - SIM_TA0CTL;
+        Timer_Update(offset / SIM_TIMER_REGS);
+        if(offset % SIM_TIMER_REGS == T_IV) sim_regs[id] = Timer_IV(offset / SIM_TIMER_REGS);
+    } else if(id >= SIM_UCB1CTL0 && id <= SIM_UCB1IV) {
+        Board_I2C_Sync();
+        if(id == SIM_UCB1IV) {
+            // UCB1IV: highest pending enabled flag, cleared by the read
+            static const unsigned char order[] = { UCALIFG, UCNACKIFG, UCSTTIFG, UCSTPIFG, UCRXIFG, UCTXIFG };
+            unsigned int i;
+            SIM_R(UCB1IV) = 0;
+            for(i = 0; i < sizeof order; i++) {
+                if(SIM_R(UCB1IE) & SIM_R(UCB1IFG) & order[i]) {
+                    SIM_R(UCB1IFG) &= ~order[i];
+                    SIM_R(UCB1IV) = 2 * (i + 1);
+                    break;
+                }
+            }
+        }
+    } else if(id == SIM_FCTL1) {
+        Flash_Check();
+    } else if(id >= SIM_P4IN && id <= SIM_P4SEL) {
+        Board_Port4();
+    }
+}
+
+// After an access that may have been a write: mask byte registers, let the
+// peripheral see its new settings
+static void Sim_PostAccess(enum sim_reg_id id) {
+    unsigned int offset;
+    unsigned char t;
+
+    if(id <= SIM_P6SEL) {
+        sim_regs[id] &= 0xFF;
+        if(id >= SIM_P4IN && id <= SIM_P4SEL) Board_Port4();
+    } else if(id >= SIM_TA0CTL && id < SIM_TA0CTL + SIM_TIMERS * SIM_TIMER_REGS) {
+        offset = id - SIM_TA0CTL;
+        t = offset / SIM_TIMER_REGS;
+        if(offset % SIM_TIMER_REGS == T_CTL && (TREG(t, T_CTL) & TACLR)) {
+            TREG(t, T_CTL) &= ~TACLR;
+            TREG(t, T_R) = 0;
+            timer_frac[t] = 0;
+        }
+        Sim_Reschedule();
+    } else if(id >= SIM_UCB1CTL0 && id <= SIM_UCB1IV) {
+        if(id != SIM_UCB1TXBUF && id != SIM_UCB1I2CSA && id != SIM_UCB1I2COA) sim_regs[id] &= 0xFF;
+        Board_I2C_Sync();
+        Sim_Reschedule();
+    }
+}
+
+static void Sim_Settle(void) {
+    if(sim_last < 0) return;
+    Sim_PostAccess((enum sim_reg_id)sim_last);
+    sim_last = -1;
+}
+
+volatile unsigned short *sim_reg(enum sim_reg_id id) {
+    Sim_Settle();
+    Sim_Advance(SIM_REG_CYCLES);
+    Sim_PreAccess(id);
+    sim_last = id;
+    return &sim_regs[id];
+}
+
+void Sim_Port2Input(unsigned char bit, unsigned char level) {
+    unsigned char mask = 1 << bit;
+    unsigned char was = SIM_R(P2IN) & mask;
+
+    if(level) SIM_R(P2IN) |= mask;
+    else SIM_R(P2IN) &= ~mask;
+    if(!was == !level) return;
+
+    // Edge selected by P2IES: 0 = rising, 1 = falling
+    if(!(SIM_R(P2IES) & mask) == !!level) SIM_R(P2IFG) |= mask;
+}
+
+void Sim_Reset(void) {
+    unsigned char t;
+
+    memset((void *)sim_regs, 0, sizeof sim_regs);
+    SIM_R(UCSCTL4) = SELS__DCOCLKDIV | SELM__DCOCLKDIV;
+    SIM_R(UCB1CTL1) = UCSWRST;
+    SIM_R(UCB1TXBUF) = SIM_TXBUF_EMPTY;
+    SIM_R(FCTL3) = LOCK | LOCKA;
+    SIM_R(WDTCTL) = 0x6904;
+
+    sim_now = 0;
+    sim_sr = 0;
+    sim_last = -1;
+    sim_exit_bic = 0;
+    sim_exit_bis = 0;
+    sim_flash_erases = 0;
+    sim_flash_words = 0;
+    sim_interrupts = 0;
+    memset(sim_cstack, 0, sizeof sim_cstack);
+    sim_isr_depth = 0;
+    sim_main_sp = SIM_CSTACK_BYTES - SIM_MAIN_STACK_BYTES;
+    sim_sp = sim_main_sp;
+    for(t = 0; t < SIM_TIMERS; t++) {
+        timer_updated[t] = 0;
+        timer_frac[t] = 0;
+    }
+    memcpy(flash_programmed, sim_info_mem, sizeof sim_info_mem);
+    sim_due = 0;
+}
+
+/* ========================= Intrinsics ========================= */
+void __bis_SR_register(unsigned int bits) {
+    Sim_Settle();
+    Sim_SetSR(sim_sr | bits);
+    Sim_CheckInterrupts();
+    if(sim_sr & CPUOFF) Sim_Sleep();
+}
+
+void __bic_SR_register(unsigned int bits) {
+    Sim_Settle();
+    Sim_SetSR(sim_sr & ~bits);
+}
+
+void __bis_SR_register_on_exit(unsigned int bits) {
+    if(!sim_exit_bis) return;
+    *sim_exit_bis |= bits;
+    *sim_exit_bic &= ~bits;
+}
+
+void __bic_SR_register_on_exit(unsigned int bits) {
+    if(!sim_exit_bic) return;
+    *sim_exit_bic |= bits;
+    *sim_exit_bis &= ~bits;
+}
+
+unsigned int __get_SR_register(void) {
+    return sim_sr;
+}
+
+void __enable_interrupt(void) {
+    Sim_Settle();
+    Sim_SetSR(sim_sr | GIE);
+    Sim_CheckInterrupts();
+}
+
+void __disable_interrupt(void) {
+    Sim_Settle();
+    Sim_SetSR(sim_sr & ~GIE);
+}
+
+__istate_t __get_interrupt_state(void) {
+    return sim_sr & GIE;
+}
+
+void __set_interrupt_state(__istate_t state) {
+    Sim_Settle();
+    Sim_SetSR((sim_sr & ~GIE) | (state & GIE));
+    Sim_CheckInterrupts();
+}
+
+void __delay_cycles(unsigned long cycles) {
+    Sim_Settle();
+    Sim_Advance(cycles);
+}
+
+void __no_operation(void) {
+    Sim_Advance(1);
+}
+
+// Main's frames now reach bytes below the top of CSTACK (a deeper call chain):
+// they write the words they cover, and interrupts stack below them
+void Sim_MainStack(unsigned int bytes) {
+    unsigned int i;
+
+    sim_main_sp = (bytes < SIM_CSTACK_BYTES) ? SIM_CSTACK_BYTES - bytes : 0;
+    for(i = sim_main_sp; i < SIM_CSTACK_BYTES; i += 2) sim_cstack[i / 2] = 0;
+    if(!sim_isr_depth) sim_sp = sim_main_sp;
+}
+
+unsigned long __get_SP_register(void) {
+    return (unsigned long)((unsigned char *)sim_cstack + sim_sp);
+}
+
+static unsigned long Bcd_Add(unsigned long a, unsigned long b, unsigned int digits) {
+    unsigned long sum = 0;
+    unsigned int carry = 0, digit, i;
+
+    for(i = 0; i < digits; i++) {
+        digit = ((a >> (4 * i)) & 0x0F) + ((b >> (4 * i)) & 0x0F) + carry;
+        carry = digit > 9;
+        if(carry) digit -= 10;
+        sum |= (unsigned long)digit << (4 * i);
+    }
+    return sum;
+}
+
+unsigned short __bcd_add_short(unsigned short a, unsigned short b) {
+    return (unsigned short)Bcd_Add(a, b, 4);
+}
+
+unsigned long __bcd_add_long(unsigned long a, unsigned long b) {
+    return Bcd_Add(a, b, 8);
+}
@@ -0,0 +1,80 @@
+#ifndef SIM_H
+#define SIM_H
+
+/* ========================= Virtual CLIC3 Board (host build) =========================
+ * The firmware runs unchanged on the host against a register model of the
+ * MSP430F5308 (msp430f5308.h in this directory). Time is a virtual MCLK cycle
+ * count: every register access, bus cycle, ISR entry and __delay_cycles()
+ * advances it, and sleeping in an LPM jumps straight to the next event (timer
+ * compare, I2C byte, scenario action), so idle time costs nothing to simulate.
+ *
+ * Modules:
+ *   sim.c       clock, register hooks, Timer_A, port 2, flash, interrupts, intrinsics
+ *   board.c     Initial(), the CLIC3 bus devices and the ST7032 on USCI_B1
+ *   scenario.c  scenario scripts, expectations and main()
+ */
+#include <stdint.h>
+#include "msp430f5308.h"
+#include "clock.h"
+
+#define SIM_MCLK_HZ         ((uint64_t)CLOCK_HZ_ACTUAL)     // Where the FLL locks, not CLOCK_MHZ
+#define SIM_ACLK_LF_HZ      32768           // REFO or XT1
+#define SIM_MS(ms)          ((uint64_t)(ms) * SIM_MCLK_HZ / 1000)
+
+// Cost model (MCLK cycles)
+#define SIM_REG_CYCLES      3               // One peripheral register access
+#define SIM_ISR_CYCLES      11              // Interrupt entry (6) plus RETI (5)
+#define SIM_BUS_CYCLES      40              // One CLIC3 bus cycle (BusRead.asm/BusWrite.asm)
+#define SIM_FLASH_ERASE_MS  25              // Segment erase, CPU held
+#define SIM_FLASH_WORD_US   75              // Word program, CPU held
+#define SIM_MAIN_STACK_BYTES 48             // Stack model: main's frames below the top of CSTACK (at reset)
+#define SIM_ISR_STACK_BYTES  12             // PC and SR, plus R12-R15 saved by a C ISR
+
+/* ========================= Core (sim.c) ========================= */
+extern uint64_t sim_now;                    // MCLK cycles since reset
+extern unsigned int sim_sr;                 // Status register (GIE and LPM bits)
+extern unsigned char sim_info_mem[512];     // Info memory D..A (0x1800-0x19FF)
+extern unsigned long sim_flash_erases;
+extern unsigned long sim_flash_words;
+extern unsigned long sim_interrupts;
+extern unsigned int sim_sp;                 // Modelled stack pointer: byte offset into sim_cstack
+
+// Register storage, for the models (no clock or hooks, unlike the firmware's view)
+extern volatile unsigned short sim_regs[SIM_REG_COUNT];
+#define SIM_R(name)         sim_regs[SIM_##name]
+#define SIM_TXBUF_EMPTY     0xFFFF          // UCB1TXBUF after the shifter took the byte
+
+void Sim_Reset(void);
+uint64_t Sim_AclkHz(void);
+void Sim_Advance(uint64_t cycles);          // Busy time: runs due events and interrupts
+void Sim_Reschedule(void);                  // Something changed: recompute the next event
+uint64_t Sim_PeripheralDue(void);           // Next timer/I2C event (UINT64_MAX = none)
+void Sim_Port2Input(unsigned char bit, unsigned char level);
+void Sim_MainStack(unsigned int bytes);     // Main's frames reach this deep into CSTACK from now on
+
+/* ========================= Board (board.c) ========================= */
+extern unsigned char board_switches;
+extern unsigned char board_leds;            // Latch contents (active-low)
+extern unsigned char board_seg[2];          // SEG_LOW, SEG_HIGH latch contents
+extern unsigned char board_keypad;          // Scan code latched by the keypad encoder
+extern char board_lcd[2][17];               // Visible LCD text
+extern unsigned char board_lcd_on;          // Display on (0x08 command with D set)
+extern unsigned long board_lcd_bytes;       // Bytes seen on the I2C bus
+extern unsigned long board_lcd_early;       // Instructions sent while the LCD was busy
+extern unsigned char board_lcd_connected;   // 0 = unplugged: nobody acknowledges
+extern unsigned char board_sda_held;        // SCL clocks until the LCD releases SDA (0 = free)
+extern uint64_t board_led_edges[8][2];      // Last two toggle times of each LED
+extern int board_verbose;
+
+void Board_Reset(void);
+void Board_I2C_Sync(void);                  // USCI_B1 register hook
+uint64_t Board_I2C_Due(void);
+void Board_LcdConnect(unsigned char connected);
+void Board_Port4(void);                     // P4 register hook (I2C pins as GPIO)
+void Board_LedsChanged(unsigned char old_leds);
+
+/* ========================= Scenario (scenario.c) ========================= */
+uint64_t Scenario_Due(void);
+void Scenario_Run(void);                    // Apply actions that are due (may end the run)
+
+#endif
@@ -0,0 +1,68 @@
+/* ========================= CLIC3 Telemetry Decoder (host) =========================
+ * Reads the UART stream from telemetry.c (a capture file, or stdin) and
+ * writes one CSV row per record:
+ *
+ *   seq,time_ms,event,value,lost
+ *
+ * "lost" is how many records the board dropped before this one (from gaps in
+ * the 8-bit sequence counter). Bytes that do not start a record are skipped
+ * and counted, so a capture may begin mid-record.
+ *
+ *   cc -o telemetry_decode telemetry_decode.c
+ *   ./telemetry_decode capture.bin > session.csv
+ */
+#include <stdio.h>
+
+#define TEL_SYNC        0xA5
+#define TEL_RECORD_LEN  10
+
+static const char *event_names[] = {
+    "boot", "s3_on", "s3_off", "second", "threshold", "alarm_on", "alarm_off"
+};
+
+int main(int argc, char **argv) {
+    FILE *in = stdin;
+    unsigned char rec[TEL_RECORD_LEN];
+    int fill = 0, c, i, have_seq = 0;
+    unsigned char expect = 0;
+    unsigned long skipped = 0;
+
+    if(argc > 1 && !(in = fopen(argv[1], "rb"))) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    printf("seq,time_ms,event,value,lost\n");
+    while((c = getc(in)) != EOF) {
+        if(fill == 0 && c != TEL_SYNC) {   // Hunt for the next record
+            skipped++;
+            continue;
+        }
+        rec[fill++] = (unsigned char)c;
+        if(fill < TEL_RECORD_LEN) continue;
+        fill = 0;
+
+        if(rec[2] >= sizeof event_names / sizeof event_names[0]) {
+            // Not a record after all: drop the SYNC byte and hunt again from
+            // rec[1], since the real record may start inside this one
+            for(i = 1; i < TEL_RECORD_LEN && rec[i] != TEL_SYNC; i++);
+            skipped += i;
+            for(; i < TEL_RECORD_LEN; i++) rec[fill++] = rec[i];
+            continue;
+        }
+
+        unsigned long value = rec[3] | (unsigned long)rec[4] << 8 | (unsigned long)rec[5] << 16;
+        unsigned long time_ms = rec[6] | (unsigned long)rec[7] << 8
+                              | (unsigned long)rec[8] << 16 | (unsigned long)rec[9] << 24;
+        unsigned char lost = have_seq ? (unsigned char)(rec[1] - expect) : 0;
+        if(rec[2] == 0) lost = 0;           // Board reset: sequence restarts
+
+        printf("%u,%lu,%s,%lu,%u\n", rec[1], time_ms, event_names[rec[2]], value, lost);
+        expect = rec[1] + 1;
+        have_seq = 1;
+    }
+
+    if(skipped) fprintf(stderr, "telemetry_decode: skipped %lu bytes\n", skipped);
+    if(in != stdin) fclose(in);
+    return 0;
+}
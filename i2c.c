@@ -0,0 +1,311 @@
+#include "msp430f5308.h"
+#include "intrinsics.h"
+#include "i2c.h"
+#include "clock.h"
+
+/* ========================= Configuration ========================= */
+#define I2C_SDA         0x02        // P4.1
+#define I2C_SCL         0x04        // P4.2
+#define I2C_QUEUE_SIZE  128         // Ring size in bytes (must be a power of two)
+#define I2C_QUEUE_MASK  (I2C_QUEUE_SIZE - 1)
+
+// Polled waits give up after I2C_WAIT_US: a byte takes 23 us (90 us in
+// standard mode), and a poll is about 8 cycles
+#define I2C_WAIT_US     1000
+#define I2C_WAIT_POLLS  (I2C_WAIT_US * CLOCK_MHZ / 8 + 1)
+
+#define I2C_RECOVER_CLOCKS  9       // A slave can be at most 8 bits and an ACK into a byte
+#define I2C_HALF_BIT()      __delay_cycles(CLOCK_CYCLES_US(CLOCK_I2C_HALF_US))
+
+#define I2C_FAULT_IE    (UCNACKIE | UCALIE)
+
+/* ========================= Transmit Queue ========================= */
+// Each queued transfer is stored as a length byte followed by its payload.
+// Main is the only producer (advances i2c_head), the ISR the only consumer.
+static volatile unsigned char i2c_queue[I2C_QUEUE_SIZE];
+static volatile unsigned char i2c_head;         // Next free slot
+static volatile unsigned char i2c_tail;         // Next byte to send
+static volatile unsigned char i2c_remaining;    // Payload bytes left in current transfer
+static volatile unsigned char i2c_busy;         // 1 = ISR owns the bus
+static volatile unsigned char i2c_deferred;     // 1 = start held until the last STOP is out
+static unsigned char i2c_fill;                  // Write cursor while building a transfer
+
+/* ========================= Fault Handling ========================= */
+static volatile unsigned char i2c_progress;     // Bumped by each start and each interrupt
+static unsigned char i2c_seen;                  // i2c_progress at the last watchdog call
+static volatile unsigned int i2c_rest_ms;       // Rest left after an error
+static unsigned char i2c_address;
+static void (*i2c_callback)(void);
+
+volatile unsigned int i2c_nacks;
+volatile unsigned int i2c_timeouts;
+volatile unsigned int i2c_recoveries;
+volatile unsigned int i2c_errors;
+
+/* ========================= Bus Set-up and Recovery ========================= */
+// UCB1 as the only master, from SMCLK at the clock.h rate
+static void I2C_Configure(void) {
+    UCB1CTL1 |= UCSWRST;
+    UCB1CTL0 = UCMST | UCMODE_3 | UCSYNC;
+    UCB1CTL1 = UCSSEL_2 | UCSWRST;  // SMCLK (ACLK may be 32 kHz)
+    UCB1BR0 = CLOCK_I2C_DIV;
+    UCB1BR1 = 0;
+    UCB1I2CSA = i2c_address;
+    P4SEL |= I2C_SDA | I2C_SCL;
+    UCB1CTL1 &= ~UCSWRST;
+}
+
+// Bus recovery (I2C spec 3.1.16): a slave cut off mid-byte holds SDA low
+// until it has clocked the byte out. With the pins taken from the USCI, clock
+// SCL until SDA is released, make a STOP and hand the pins back. Lines are
+// driven open-drain through P4DIR with P4OUT low, and float high when released.
+static void I2C_Recover(void) {
+    unsigned char n;
+
+    UCB1CTL1 |= UCSWRST;
+    P4OUT &= ~(I2C_SDA | I2C_SCL);
+    P4DIR &= ~(I2C_SDA | I2C_SCL);
+    P4SEL &= ~(I2C_SDA | I2C_SCL);
+    I2C_HALF_BIT();
+
+    if(!(P4IN & I2C_SDA)) {
+        for(n = 0; n < I2C_RECOVER_CLOCKS && !(P4IN & I2C_SDA); n++) {
+            P4DIR |= I2C_SCL;
+            I2C_HALF_BIT();
+            P4DIR &= ~I2C_SCL;
+            I2C_HALF_BIT();
+        }
+        i2c_recoveries++;
+    }
+
+    // STOP: SDA rises while SCL is high
+    P4DIR |= I2C_SCL;
+    I2C_HALF_BIT();
+    P4DIR |= I2C_SDA;
+    I2C_HALF_BIT();
+    P4DIR &= ~I2C_SCL;
+    I2C_HALF_BIT();
+    P4DIR &= ~I2C_SDA;
+    I2C_HALF_BIT();
+
+    I2C_Configure();
+}
+
+// Any error: count it and rest the link
+static void I2C_Error(void) {
+    i2c_errors++;
+    i2c_rest_ms = I2C_RETRY_MS;
+}
+
+// Error on a queued transfer: drop everything queued (the client resends)
+static void I2C_Drop(void) {
+    i2c_tail = i2c_head;
+    i2c_remaining = 0;
+    I2C_Error();
+}
+
+// The queue is done with the bus (drained or dropped): tell the client
+static void I2C_Idle(void) {
+    UCB1IE &= ~(UCTXIE | I2C_FAULT_IE);
+    i2c_deferred = 0;
+    i2c_busy = 0;
+    if(i2c_callback) i2c_callback();
+}
+
+// STOP, then idle without waiting for it: UCTXSTP clears once the STOP is
+// on the bus, after the byte being shifted. The next start checks for that.
+static void I2C_Stop(void) {
+    UCB1CTL1 |= UCTXSTP;
+    I2C_Idle();
+}
+
+// START + address for the transfer at i2c_tail, TXIFG follows
+static void I2C_Start(void) {
+    i2c_deferred = 0;
+    i2c_remaining = i2c_queue[i2c_tail];
+    i2c_tail = (i2c_tail + 1) & I2C_QUEUE_MASK;
+
+    UCB1IFG &= ~(UCNACKIFG | UCALIFG);
+    UCB1CTL1 |= UCTR | UCTXSTT;
+    UCB1IE |= UCTXIE | I2C_FAULT_IE;
+}
+
+void I2C_Init(unsigned char address) {
+    // Explicit reset of the driver state (the assembly build skips C startup)
+    i2c_head = 0;
+    i2c_tail = 0;
+    i2c_remaining = 0;
+    i2c_busy = 0;
+    i2c_deferred = 0;
+    i2c_progress = 0;
+    i2c_seen = 0;
+    i2c_rest_ms = 0;
+    i2c_callback = 0;
+    i2c_nacks = 0;
+    i2c_timeouts = 0;
+    i2c_recoveries = 0;
+    i2c_errors = 0;
+    i2c_address = address;
+
+    // A reset can cut a transfer off mid-byte: free the bus before using it
+    I2C_Recover();
+}
+
+/* ========================= Polled Transfers ========================= */
+// Wait for TXIFG; a NACK or lost arbitration ends the wait early
+static unsigned char I2C_WaitTx(void) {
+    unsigned int polls = I2C_WAIT_POLLS;
+
+    while(!(UCB1IFG & (UCTXIFG | UCNACKIFG | UCALIFG))) {
+        if(!--polls) return I2C_TIMEOUT;
+    }
+    return (UCB1IFG & (UCNACKIFG | UCALIFG)) ? I2C_NACK : I2C_OK;
+}
+
+unsigned char I2C_Write(const unsigned char *data, unsigned char len) {
+    unsigned int polls = I2C_WAIT_POLLS;
+    unsigned char status, i;
+
+    UCB1IFG &= ~(UCNACKIFG | UCALIFG);
+    UCB1CTL1 |= UCTR | UCTXSTT;
+    status = I2C_WaitTx();
+    for(i = 0; i < len && status == I2C_OK; i++) {
+        UCB1TXBUF = data[i];
+        status = I2C_WaitTx();
+    }
+
+    if(status != I2C_TIMEOUT) {
+        UCB1CTL1 |= UCTXSTP;
+        while((UCB1CTL1 & UCTXSTP) && --polls);
+        if(!polls) status = I2C_TIMEOUT;
+        else if(UCB1IFG & (UCNACKIFG | UCALIFG)) status = I2C_NACK;    // The last byte
+    }
+
+    if(status == I2C_TIMEOUT) {
+        i2c_timeouts++;
+        I2C_Recover();
+    } else if(status == I2C_NACK) {
+        i2c_nacks++;
+        if(UCB1IFG & UCALIFG) I2C_Configure();  // Lost arbitration left UCB1 a slave
+    }
+    if(status != I2C_OK) I2C_Error();
+    UCB1IFG &= ~(UCTXIFG | UCNACKIFG | UCALIFG);
+    return status;
+}
+
+/* ========================= Queued Transfers ========================= */
+unsigned char I2C_Free(void) {
+    return (unsigned char)(i2c_tail - i2c_head - 1) & I2C_QUEUE_MASK;
+}
+
+// Transfers are built at i2c_fill and published with a single store to
+// i2c_head, so the ISR never sees a partially written transfer
+void I2C_Begin(unsigned char len) {
+    i2c_fill = i2c_head;
+    i2c_queue[i2c_fill] = len;
+    i2c_fill = (i2c_fill + 1) & I2C_QUEUE_MASK;
+}
+
+void I2C_Put(unsigned char value) {
+    i2c_queue[i2c_fill] = value;
+    i2c_fill = (i2c_fill + 1) & I2C_QUEUE_MASK;
+}
+
+// Publish, and start the engine if it is idle. The ISR picks up anything
+// queued while busy. The ISR does not wait for its last STOP, so this does:
+// a byte time at most (main only). A STOP still pending after I2C_WAIT_US
+// parks the transfer, and the next I2C_Watchdog() starts it or, if the STOP
+// never goes out, recovers the bus.
+void I2C_Send(void) {
+    unsigned int polls = I2C_WAIT_POLLS;
+
+    i2c_head = i2c_fill;
+    if(i2c_busy || i2c_tail == i2c_head) return;
+
+    i2c_progress++;                 // Before i2c_busy: the watchdog must not see a stall
+    while((UCB1CTL1 & UCTXSTP) && --polls);
+    if(!polls) {
+        i2c_deferred = 1;           // Before i2c_busy: the watchdog only starts it once busy
+        i2c_busy = 1;
+        return;
+    }
+    i2c_busy = 1;
+    I2C_Start();
+}
+
+unsigned char I2C_Busy(void) {
+    return i2c_busy | (i2c_tail != i2c_head);
+}
+
+unsigned char I2C_Ready(void) {
+    return !i2c_rest_ms;
+}
+
+void I2C_SetDoneCallback(void (*callback)(void)) {
+    i2c_callback = callback;
+}
+
+unsigned char I2C_Watchdog(unsigned char ms) {
+    unsigned char rested = 0;
+
+    if(i2c_rest_ms) {
+        i2c_rest_ms = (i2c_rest_ms > ms) ? i2c_rest_ms - ms : 0;
+        rested = !i2c_rest_ms;
+        if(rested && !i2c_busy && i2c_callback) i2c_callback();    // Open for business again
+    }
+
+    if(i2c_busy && i2c_deferred && !(UCB1CTL1 & UCTXSTP)) {
+        i2c_progress++;
+        I2C_Start();                            // The STOP is out: start the held transfer
+    }
+
+    if(!i2c_busy || i2c_progress != i2c_seen) {
+        i2c_seen = i2c_progress;
+        return rested;
+    }
+
+    // No interrupt (or a STOP still pending) for a whole period: SDA or SCL is being held
+    i2c_timeouts++;
+    I2C_Drop();
+    I2C_Recover();
+    I2C_Idle();
+    return 1;
+}
+
+/* ========================= USCI_B1 ISR ========================= */
+#pragma vector = USCI_B1_VECTOR
+__interrupt void I2C_ISR(void) {
+    i2c_progress++;
+    switch(__even_in_range(UCB1IV, 12)) {
+    case 2:                                     // ALIFG: lost the bus, UCB1 is now a slave
+        i2c_nacks++;
+        I2C_Drop();
+        I2C_Configure();
+        I2C_Idle();
+        break;
+    case 4:                                     // NACKIFG: nobody answered (cable, address)
+        i2c_nacks++;
+        I2C_Drop();
+        I2C_Stop();
+        break;
+    case 12:                                    // TXIFG: ready for the next byte
+        if(i2c_remaining) {
+            UCB1TXBUF = i2c_queue[i2c_tail];
+            i2c_tail = (i2c_tail + 1) & I2C_QUEUE_MASK;
+            i2c_remaining--;
+        }
+        else if(i2c_tail != i2c_head) {
+            // Chain the next transfer with a repeated START
+            i2c_remaining = i2c_queue[i2c_tail];
+            i2c_tail = (i2c_tail + 1) & I2C_QUEUE_MASK;
+            UCB1CTL1 |= UCTXSTT;
+        }
+        else {
+            I2C_Stop();                         // Queue empty
+        }
+        break;
+    default:
+        break;
+    }
+    if(!i2c_busy) __bic_SR_register_on_exit(LPM3_bits);
+}
@@ -0,0 +1,69 @@
+#ifndef I2C_H
+#define I2C_H
+
+/* ========================= I2C Master (USCI_B1) =========================
+ * UCB1 on P4.1 (SDA) and P4.2 (SCL), clocked from SMCLK at 400 kHz, or
+ * 100 kHz with I2C_FAST=0 (clock.h). Writes only: the one slave is the LCD.
+ *
+ * Transfers are queued in a ring buffer and drained by the USCI_B1 interrupt:
+ * back-to-back transfers are chained with a repeated START and a STOP is only
+ * issued once the queue is empty. The interrupt does not wait for that STOP;
+ * I2C_Send() does, for up to I2C_WAIT_US, when it starts the next transfer.
+ * Only a STOP that takes longer (a held bus) parks the transfer until the
+ * next I2C_Watchdog() call, up to one call period later: 1 ms from a 1 ms
+ * tick, TICKLESS_POLL_MS (10 ms) tickless. Every image that links this
+ * driver must call I2C_Watchdog(). I2C_Write() is the polled alternative for
+ * bring-up, before interrupts are on.
+ *
+ * Nothing waits forever. A NACK or lost arbitration ends the transfer with a
+ * STOP and drops the queue (the client resends); a transfer that stops making
+ * progress is caught by I2C_Watchdog() and a polled wait by its own timeout,
+ * and both clock the bus free. After any error the link rests for
+ * I2C_RETRY_MS, so an unplugged display costs one address byte per rest.
+ */
+
+// Polled transfer results
+#define I2C_OK          0
+#define I2C_NACK        1           // Address or a data byte not acknowledged
+#define I2C_TIMEOUT     2           // Bus stuck: recovered, transfer lost
+
+#define I2C_RETRY_MS    250         // Rest after an error before the queue takes more
+
+// Error counters since I2C_Init()
+extern volatile unsigned int i2c_nacks;         // NACKs and lost arbitration
+extern volatile unsigned int i2c_timeouts;      // Stalled transfers and polled waits
+extern volatile unsigned int i2c_recoveries;    // Times SCL was clocked to free SDA
+extern volatile unsigned int i2c_errors;        // Any of the above: compare to notice a fault
+
+// Configure UCB1 for the slave at address (clearing the counters and the
+// queue); clocks the bus free first if a slave is holding SDA low
+void I2C_Init(unsigned char address);
+
+// Polled write of one transfer (START, data, STOP). The queue must be idle.
+unsigned char I2C_Write(const unsigned char *data, unsigned char len);
+
+// Queued writes: I2C_Begin() a transfer of len bytes once I2C_Free() shows
+// room for len + 1, I2C_Put() each byte, then I2C_Send() publishes it
+// (main only: it may wait out the last STOP)
+unsigned char I2C_Free(void);
+void I2C_Begin(unsigned char len);
+void I2C_Put(unsigned char value);
+void I2C_Send(void);
+
+// Nonzero while a transfer is queued or on the bus
+unsigned char I2C_Busy(void);
+
+// Zero while the link rests after an error: queue nothing until it is back
+unsigned char I2C_Ready(void);
+
+// Run from the ISR when the queue drains or is dropped, and when a rest ends
+// (keep it short)
+void I2C_SetDoneCallback(void (*callback)(void));
+
+// Call from a timer ISR every ms milliseconds (at least 1 ms apart). Aborts a
+// transfer that made no progress since the last call and times the rest.
+// Returns 1 when the done callback has run: a transfer was ended or the rest
+// is over.
+unsigned char I2C_Watchdog(unsigned char ms);
+
+#endif
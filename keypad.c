@@ -0,0 +1,59 @@
+#include "keypad.h"
+
+/* ========================= Decode ========================= */
+// One-hot nibble -> bit number; anything else is no key or two keys at once
+static const unsigned char KeyBit[16] = {
+    KEY_NONE, 0, 1, KEY_NONE, 2, KEY_NONE, KEY_NONE, KEY_NONE,
+    3, KEY_NONE, KEY_NONE, KEY_NONE, KEY_NONE, KEY_NONE, KEY_NONE, KEY_NONE
+};
+
+// Key number by [row bit][column bit]
+static const unsigned char KeyGrid[4][4] = {
+    {  1,  2,  3, 15 },
+    {  4,  5,  6, 14 },
+    {  7,  8,  9, 13 },
+    { 10,  0, 11, 12 }
+};
+
+unsigned char Keypad_Decode(unsigned char scan) {
+    unsigned char row = KeyBit[scan >> 4];
+    unsigned char column = KeyBit[scan & 0x0F];
+
+    if((row | column) > 3) return KEY_NONE;
+    return KeyGrid[row][column];
+}
+
+/* ========================= Event FIFO ========================= */
+// Free-running 8-bit indices: head - tail is the fill level
+static volatile unsigned char key_fifo[KEY_FIFO_SIZE];
+static volatile unsigned char key_fifo_head;        // Written by the ISR only
+static volatile unsigned char key_fifo_tail;        // Written by main only
+volatile unsigned int key_fifo_dropped;
+
+void Keypad_FifoInit(void) {
+    key_fifo_head = 0;
+    key_fifo_tail = 0;
+    key_fifo_dropped = 0;
+}
+
+unsigned char Keypad_Push(unsigned char event) {
+    unsigned char head = key_fifo_head;
+
+    if((unsigned char)(head - key_fifo_tail) >= KEY_FIFO_SIZE) {
+        key_fifo_dropped++;
+        return 0;
+    }
+    key_fifo[head & (KEY_FIFO_SIZE - 1)] = event;
+    key_fifo_head = head + 1;           // Publish after the slot is written
+    return 1;
+}
+
+unsigned char Keypad_Pop(void) {
+    unsigned char tail = key_fifo_tail;
+    unsigned char event;
+
+    if(tail == key_fifo_head) return KEY_NONE;
+    event = key_fifo[tail & (KEY_FIFO_SIZE - 1)];
+    key_fifo_tail = tail + 1;           // Slot is free once read
+    return event;
+}
@@ -0,0 +1,40 @@
+#ifndef KEYPAD_H
+#define KEYPAD_H
+
+/* ========================= 16-Key Keypad =========================
+ * The keypad encoder returns one row bit in the high nibble of the scan code
+ * and one column bit in the low nibble:
+ *
+ *   row \ column   0x01  0x02  0x04  0x08
+ *   0x10            1     2     3     F
+ *   0x20            4     5     6     E
+ *   0x40            7     8     9     D
+ *   0x80            A     0     B     C
+ *
+ * Keypad_Decode() turns a scan code into the key number 0-15 (0-9 are the
+ * digits, 10-15 the letters) with two table reads, whichever key it is.
+ *
+ * Key events go from the ISR that reads the keypad to the main loop through a
+ * FIFO: a key number for a press, KEY_RELEASED | key for the release. There is
+ * one producer (an ISR, so interrupts are off) and one consumer (main); each
+ * side writes only its own index, so neither needs a critical section.
+ */
+#define KEY_NONE        0xFF        // No key, more than one key, or FIFO empty
+#define KEY_RELEASED    0x80        // Event flag: key let go
+
+// Threshold entry keys
+#define KEY_CLEAR       13          // D: start the entry again
+#define KEY_BACKSPACE   14          // E: drop the last digit
+#define KEY_ENTER       15          // F: accept the digits entered so far
+
+#define KEY_FIFO_SIZE   8           // Events (a power of two)
+
+extern volatile unsigned int key_fifo_dropped;     // Events lost to a full FIFO
+
+unsigned char Keypad_Decode(unsigned char scan);
+
+void Keypad_FifoInit(void);
+unsigned char Keypad_Push(unsigned char event);    // ISR only; 0 = FIFO full, event dropped
+unsigned char Keypad_Pop(void);                    // Main only; KEY_NONE = empty
+
+#endif
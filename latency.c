@@ -0,0 +1,121 @@
+#include "msp430f5308.h"
+#include "intrinsics.h"
+#include "latency.h"
+
+#if LATENCY
+
+unsigned int latency_hist[LAT_COUNT][LATENCY_BUCKETS];
+
+static unsigned long latency_start[LAT_COUNT];      // Input stamp of each waiting path
+static unsigned char latency_waiting;               // Bit n: path n waits for its output
+
+static const char * const latency_names[LAT_COUNT] = {
+    "S3>D7  ", "S3>Seg ", "S3>LCD ", "Key>LCD"
+};
+
+void Latency_Input(unsigned char paths, unsigned long stamp) {
+    unsigned char path;
+
+    for(path = 0; path < LAT_COUNT; path++) {
+        if(!(paths & LAT_BIT(path)) || (latency_waiting & LAT_BIT(path))) continue;
+        latency_start[path] = stamp;
+        latency_waiting |= LAT_BIT(path);
+    }
+}
+
+void Latency_Output(unsigned char paths, unsigned long stamp) {
+    unsigned long us;
+    unsigned char path, bucket;
+
+    paths &= latency_waiting;
+    latency_waiting &= ~paths;
+    for(path = 0; paths; path++, paths >>= 1) {
+        if(!(paths & 0x01)) continue;
+        us = Latency_Us(stamp - latency_start[path]);
+        for(bucket = 0; us > 1 && bucket < LATENCY_BUCKETS - 1; bucket++) us >>= 1;
+        if(latency_hist[path][bucket] != 0xFFFF) latency_hist[path][bucket]++;
+    }
+}
+
+void Latency_Drop(unsigned char paths) {
+    latency_waiting &= ~paths;
+}
+
+unsigned char Latency_Waiting(void) {
+    return latency_waiting;
+}
+
+// A bucket as its bound, 5 wide: "<512u", "  <4m", or ">524m" for the last one
+static void Latency_Bound(char *dst, unsigned char bucket) {
+    unsigned long bound;
+    unsigned char i = 4;
+
+    if(bucket == LATENCY_BUCKETS - 1) {
+        dst[0] = '>';
+        bound = 1UL << bucket;
+    } else {
+        bound = 1UL << (bucket + 1);
+    }
+    if(bound < 1000) {
+        dst[4] = 'u';
+    } else {
+        dst[4] = 'm';
+        bound = (bound + 500) / 1000;
+    }
+    do {
+        dst[--i] = '0' + (char)(bound % 10);
+        bound /= 10;
+    } while(bound);
+    if(bucket != LATENCY_BUCKETS - 1) dst[--i] = '<';
+}
+
+void Latency_Render(unsigned char path, char *line1, char *line2) {
+    unsigned int hist[LATENCY_BUCKETS];
+    unsigned long count = 0, seen = 0;
+    unsigned char i, median = 0, max = 0;
+    __istate_t state = __get_interrupt_state();
+
+    __disable_interrupt();
+    for(i = 0; i < LATENCY_BUCKETS; i++) hist[i] = latency_hist[path][i];
+    __set_interrupt_state(state);
+
+    for(i = 0; i < 16; i++) {
+        line1[i] = ' ';
+        line2[i] = ' ';
+    }
+    for(i = 0; i < LATENCY_BUCKETS; i++) {
+        count += hist[i];
+        if(hist[i]) max = i;
+    }
+    for(i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += hist[i];
+        if(2 * seen >= count) {
+            median = i;
+            break;
+        }
+    }
+
+    // "S3>LCD  p50 <33m" / "n=  123 max <66m"
+    for(i = 0; i < 7; i++) line1[i] = latency_names[path][i];
+    line1[8] = 'p';
+    line1[9] = '5';
+    line1[10] = '0';
+    line2[0] = 'n';
+    line2[1] = '=';
+    if(count > 99999) count = 99999;
+    for(i = 6; i > 1; i--) {
+        line2[i] = (count || i == 6) ? '0' + (char)(count % 10) : ' ';
+        count /= 10;
+    }
+    line2[8] = 'm';
+    line2[9] = 'a';
+    line2[10] = 'x';
+    if(seen) {
+        Latency_Bound(&line1[11], median);
+        Latency_Bound(&line2[11], max);
+    } else {
+        line1[13] = '-';
+        line2[13] = '-';
+    }
+}
+#endif
@@ -0,0 +1,51 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+/* ========================= Input-to-Output Latency =========================
+ * Build with LATENCY=1 to measure what the operator sees: the time from an
+ * input to the output that answers it, per path, in log2 histograms.
+ *
+ * The application stamps the input (the first sample at S3's new level, the
+ * keypad edge) and hands it over with Latency_Input() once it has acted on
+ * it. The path then waits for its output: Latency_Output() when the output
+ * has been committed (the bus write, the end of the LCD transfer) records
+ * the span in the path's histogram. Latency_Drop() forgets a path whose
+ * output did not need to change. While a path waits, later inputs on it
+ * are not stamped again: the first one has waited longest.
+ *
+ * Bucket n counts spans from 2^n to 2^(n+1) - 1 us; the last one everything
+ * longer. Stamps are in the application's clock (Event_Now() units), turned
+ * into microseconds by Latency_Us().
+ */
+#ifndef LATENCY
+#define LATENCY         0
+#endif
+
+enum {
+    LAT_S3_LED,                 // S3 edge to D7 written
+    LAT_S3_SEG,                 // S3 edge to the digits written (00 on a start)
+    LAT_S3_LCD,                 // S3 edge to "Timing"/"Elapsed" all on the LCD
+    LAT_KEY_LCD,                // Key press to the entry all on the LCD
+    LAT_COUNT
+};
+
+#define LAT_BIT(path)       (1 << (path))
+#define LATENCY_BUCKETS     20      // Up to 2^19 us (524 ms), then the overflow bucket
+
+#if LATENCY
+extern unsigned int latency_hist[LAT_COUNT][LATENCY_BUCKETS];  // Counts stop at 0xFFFF
+
+// Provided by the application: a span of stamps in microseconds
+unsigned long Latency_Us(unsigned long span);
+
+// The rest run with interrupts off (main and the ISR that ends the LCD transfer share them)
+void Latency_Input(unsigned char paths, unsigned long stamp);
+void Latency_Output(unsigned char paths, unsigned long stamp);
+void Latency_Drop(unsigned char paths);
+unsigned char Latency_Waiting(void);    // Paths waiting for their output
+
+// Format one path for the LCD: "S3>LCD  p50 <33m" / "n=  123 max <66m"
+void Latency_Render(unsigned char path, char *line1, char *line2);
+#endif
+
+#endif
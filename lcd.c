@@ -0,0 +1,316 @@
+#include "msp430f5308.h"
+#include "intrinsics.h"
+#include "lcd.h"
+#include "i2c.h"
+#include "clock.h"
+
+/* ========================= Configuration ========================= */
+#define LCD_I2C_ADDR    0x3E
+#define LCD_LINE_LEN    16
+#define LCD_RUN_GAP     4           // Unchanged chars cheaper to resend than a new transfer
+
+#define LCD_CTRL_CMD    0x80        // Control byte: Co=1, RS=0 (one command follows)
+#define LCD_CTRL_DATA   0x40        // Control byte: Co=0, RS=1 (data until STOP)
+#define LCD_SET_DDRAM   0x80        // Set DDRAM address command
+
+// ST7032 datasheet minimum waits, timed by LCD_Tick() in the non-blocking bring-up
+#define LCD_POWERON_MS  40          // VDD stable to the first instruction
+#define LCD_FOLLOWER_MS 200         // Follower control to display on (booster settling)
+#define LCD_CLEAR_MS    2           // Clear display takes 1.08 ms
+
+/* ========================= Shadow Framebuffer ========================= */
+// The text the application wants on screen is lcd_text, a screen in flash
+// (LCD_LINES x 16), except for the cells set in lcd_fields (bit n = column n), which come
+// from lcd_frame. LCD_Screen() patches only its fields into lcd_frame and the
+// static text is read straight from flash; LCD_Frame() sets every bit.
+// lcd_shadow is what the display holds once every queued transfer has gone
+// out. LCD_Sync() sends only the runs where the two differ.
+static char lcd_frame[LCD_LINES][LCD_LINE_LEN];
+static char lcd_shadow[LCD_LINES][LCD_LINE_LEN];
+static const char *lcd_text;                    // Screen text, line 1 then line 2
+static unsigned int lcd_fields[LCD_LINES];      // Cells taken from lcd_frame, per line
+static unsigned char lcd_dirty;                 // 1 = frame may differ from shadow
+
+static const unsigned int lcd_cell_bit[LCD_LINE_LEN] = {
+    0x0001, 0x0002, 0x0004, 0x0008, 0x0010, 0x0020, 0x0040, 0x0080,
+    0x0100, 0x0200, 0x0400, 0x0800, 0x1000, 0x2000, 0x4000, 0x8000
+};
+
+/* ========================= Bring-up ========================= */
+// Nothing but the init sequence is sent until lcd_ready is set. In the
+// non-blocking bring-up lcd_step walks the sequence, each step waiting
+// lcd_wait_ms once the queue has drained.
+static volatile unsigned char lcd_ready;
+static volatile unsigned char lcd_step;
+static volatile unsigned int  lcd_wait_ms;
+
+static void (*lcd_callback)(void);
+static unsigned int lcd_errors;                 // i2c_errors the display has been resynced for
+
+static const unsigned char lcd_power_up[] = { 0x39, 0x14, 0x74, 0x54, 0x6F };
+static const unsigned char lcd_display_on[] = { 0x0E, 0x01 };
+
+volatile unsigned char lcd_done;
+volatile unsigned int  lcd_overflows;
+unsigned long lcd_tx_bytes;
+
+// Queue drained, or dropped after a link error (runs in the ISR)
+static void LCD_Drained(void) {
+    lcd_done = 1;
+    if(lcd_callback) lcd_callback();
+}
+
+static void LCD_Send(void) {
+    lcd_done = 0;
+    I2C_Send();
+}
+
+// The character wanted in column i of a line: a field cell from lcd_frame,
+// anything else from the screen text in flash
+static char LCD_Cell(unsigned char line, unsigned char i) {
+    if(lcd_fields[line] & lcd_cell_bit[i]) return lcd_frame[line][i];
+    return lcd_text[line * LCD_LINE_LEN + i];
+}
+
+// Queue one transfer: a DDRAM address command followed by a run of characters.
+// Returns 0 (and queues nothing) if the ring has no room for the whole transfer.
+static unsigned char LCD_QueueText(unsigned char line, unsigned char start, unsigned char len) {
+    unsigned char i;
+
+    if(I2C_Free() < len + 4) return 0;
+
+    lcd_tx_bytes += len + 4;        // Payload plus the address byte
+    I2C_Begin(len + 3);
+    I2C_Put(LCD_CTRL_CMD);
+    I2C_Put(LCD_SET_DDRAM | ((line ? 0x40 : 0x00) + start));
+    I2C_Put(LCD_CTRL_DATA);
+    for(i = start; i < start + len; i++) I2C_Put(LCD_Cell(line, i));
+    LCD_Send();
+    return 1;
+}
+
+// Diff the wanted text against lcd_shadow and queue one transfer per changed
+// run. Runs separated by fewer than LCD_RUN_GAP unchanged chars are merged,
+// since resending those is cheaper than the extra START, address and control bytes.
+static void LCD_Sync(void) {
+    unsigned char line, start, end, i;
+    char *shadow;
+
+    // Sent once the bring-up finishes, or the link is back from an error
+    if(!lcd_ready || !I2C_Ready()) {
+        lcd_dirty = 1;
+        return;
+    }
+
+    for(line = 0; line < LCD_LINES; line++) {
+        shadow = lcd_shadow[line];
+        i = 0;
+        while(i < LCD_LINE_LEN) {
+            if(LCD_Cell(line, i) == shadow[i]) { i++; continue; }
+
+            // Extend the run while the next difference is within LCD_RUN_GAP
+            start = i;
+            end = i;
+            for(i++; i < LCD_LINE_LEN && i - end <= LCD_RUN_GAP; i++) {
+                if(LCD_Cell(line, i) != shadow[i]) end = i;
+            }
+            i = end + 1;
+
+            // No room: keep the rest dirty and retry once the queue drains
+            if(!LCD_QueueText(line, start, i - start)) {
+                lcd_overflows++;
+                lcd_dirty = 1;
+                return;
+            }
+            for(; start < i; start++) shadow[start] = LCD_Cell(line, start);
+        }
+    }
+    lcd_dirty = 0;
+}
+
+/* ========================= Public Interface ========================= */
+void LCD_SendCommand(unsigned char cmd) {
+    if(!lcd_ready || I2C_Free() < 3) {
+        lcd_overflows++;
+        return;
+    }
+
+    lcd_tx_bytes += 3;
+    I2C_Begin(2);
+    I2C_Put(0x00);                  // Control byte: Co=0, RS=0
+    I2C_Put(cmd);
+
+    // Clear display blanks the DDRAM behind the shadow's back
+    if(cmd == 0x01) LCD_Invalidate(' ');
+
+    LCD_Send();
+}
+
+void LCD_SendLine1(const char *text) {
+    unsigned char i;
+    for(i = 0; i < LCD_LINE_LEN; i++) lcd_frame[0][i] = text[i];
+    lcd_fields[0] = 0xFFFF;
+    LCD_Sync();
+}
+
+#if LCD_LINES > 1
+void LCD_SendLine2(const char *text) {
+    unsigned char i;
+    for(i = 0; i < LCD_LINE_LEN; i++) lcd_frame[1][i] = text[i];
+    lcd_fields[1] = 0xFFFF;
+    LCD_Sync();
+}
+
+void LCD_SendBothLines(const char *line1, const char *line2) {
+    LCD_Frame(line1, line2);
+}
+
+void LCD_Frame(const char *line1, const char *line2) {
+    unsigned char i;
+    for(i = 0; i < LCD_LINE_LEN; i++) {
+        lcd_frame[0][i] = line1[i];
+        lcd_frame[1][i] = line2[i];
+    }
+    lcd_fields[0] = 0xFFFF;
+    lcd_fields[1] = 0xFFFF;
+    LCD_Sync();
+}
+#endif
+
+void LCD_Screen(const LcdScreen *screen, LcdRender render) {
+    const LcdField *field = screen->fields;
+    unsigned char n, line, at, last;
+
+    lcd_text = screen->text;
+    for(line = 0; line < LCD_LINES; line++) lcd_fields[line] = 0;
+    for(n = screen->field_count; n; n--, field++) {
+        line = field->cell >= LCD_LINE_LEN;
+        at = field->cell & (LCD_LINE_LEN - 1);
+        last = at + field->width - 1;
+        render(field->source, &lcd_frame[line][at], field->width);
+
+        // Bits at..last: the bit above last, less the bit at (wraps to 0 for column 15)
+        lcd_fields[line] |= (unsigned int)(lcd_cell_bit[last] << 1) - lcd_cell_bit[at];
+    }
+    LCD_Sync();
+}
+
+void LCD_Invalidate(char fill) {
+    unsigned char line, i;
+    for(line = 0; line < LCD_LINES; line++) {
+        for(i = 0; i < LCD_LINE_LEN; i++) lcd_shadow[line][i] = fill;
+    }
+    lcd_dirty = 1;
+}
+
+// Queue one command transfer: control byte 0x00, then the commands
+static void LCD_QueueCommands(const unsigned char *cmds, unsigned char len) {
+    unsigned char i;
+
+    lcd_tx_bytes += len + 2;
+    I2C_Begin(len + 1);
+    I2C_Put(0x00);                  // Control byte: Co=0, RS=0
+    for(i = 0; i < len; i++) I2C_Put(cmds[i]);
+    LCD_Send();
+}
+
+void LCD_Service(void) {
+    // After a link error the display may have missed transfers, or lost power
+    // with its cable: set it up again (no clear) and resend every cell. The
+    // contrast booster settles over the next 200 ms.
+    if(lcd_errors != i2c_errors && lcd_ready && I2C_Ready() && !I2C_Busy()) {
+        lcd_errors = i2c_errors;
+        LCD_QueueCommands(lcd_power_up, sizeof lcd_power_up);
+        LCD_QueueCommands(lcd_display_on, 1);       // Display on, not the clear
+        LCD_Invalidate(0);
+    }
+    if(lcd_dirty) LCD_Sync();
+}
+
+unsigned char LCD_Ready(void) {
+    return lcd_ready;
+}
+
+unsigned char LCD_Busy(void) {
+    return I2C_Busy();
+}
+
+unsigned char LCD_Shown(void) {
+    return lcd_ready && !lcd_dirty && lcd_errors == i2c_errors && !I2C_Busy();
+}
+
+void LCD_SetDoneCallback(void (*callback)(void)) {
+    lcd_callback = callback;
+}
+
+// Engine state and USCI_B1 set-up shared by both bring-ups
+static void LCD_Reset(void) {
+    unsigned char line, i;
+
+    // Explicit reset of the engine state (the assembly build skips C startup)
+    lcd_callback = 0;
+    lcd_done = 0;
+    lcd_overflows = 0;
+    lcd_tx_bytes = 0;
+    lcd_ready = 0;
+    lcd_step = 0;
+    lcd_wait_ms = 0;
+
+    I2C_Init(LCD_I2C_ADDR);
+    I2C_SetDoneCallback(LCD_Drained);
+    lcd_errors = i2c_errors;
+
+    // Clear display (0x01) leaves DDRAM all spaces: start the shadow from there
+    LCD_Invalidate(' ');
+    for(line = 0; line < LCD_LINES; line++) {
+        for(i = 0; i < LCD_LINE_LEN; i++) lcd_frame[line][i] = ' ';
+        lcd_fields[line] = 0xFFFF;
+    }
+    lcd_text = lcd_frame[0];
+    lcd_dirty = 0;
+}
+
+void LCD_Init(void) {
+    static const unsigned char lcd_init[] = { 0x00, 0x39, 0x14, 0x74, 0x54, 0x6F, 0x0E, 0x01 };
+
+    LCD_Reset();
+
+    // LCD initialization sequence (polled: runs once, before interrupts are
+    // enabled). If nobody answers, LCD_Service() sets it up once the link works.
+    I2C_Write(lcd_init, sizeof lcd_init);
+
+    __delay_cycles(CLOCK_CYCLES_US(2000));  // Clear display needs 1.08 ms
+    lcd_ready = 1;
+}
+
+void LCD_Start(void) {
+    LCD_Reset();
+    lcd_step = 1;
+    lcd_wait_ms = LCD_POWERON_MS + 1;       // +1: the first tick may come at once
+}
+
+unsigned char LCD_Tick(void) {
+    if(!lcd_step) return 0;
+
+    // Waits run from the moment the previous step is on the wire
+    if(LCD_Busy()) return 1;
+    if(--lcd_wait_ms) return 1;
+
+    switch(lcd_step) {
+    case 1:                         // Function set, oscillator, contrast, follower on
+        LCD_QueueCommands(lcd_power_up, sizeof lcd_power_up);
+        lcd_wait_ms = LCD_FOLLOWER_MS + 1;
+        lcd_step = 2;
+        return 1;
+    case 2:                         // Display on, clear
+        LCD_QueueCommands(lcd_display_on, sizeof lcd_display_on);
+        lcd_wait_ms = LCD_CLEAR_MS + 1;
+        lcd_step = 3;
+        return 1;
+    default:                        // Ready: the frame goes out on the next LCD_Service()
+        lcd_step = 0;
+        lcd_ready = 1;
+        lcd_done = 1;
+        return 0;
+    }
+}
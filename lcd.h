@@ -0,0 +1,98 @@
+#ifndef LCD_H
+#define LCD_H
+
+/* ========================= ST7032 LCD over I2C (USCI_B1) =========================
+ * Transfers go through the interrupt-driven queue of the I2C driver (i2c.h),
+ * so callers return immediately and the CPU can sleep in LPM0 while the bytes
+ * go out. If the link fails (NACK, stuck bus) the driver drops the queue, and
+ * the next LCD_Service() after its rest sets the display up again and resends
+ * every cell.
+ *
+ * On top of the queue sits a 2x16 shadow framebuffer: every update is diffed
+ * against what the display already holds and only the changed character runs
+ * are sent, each as one DDRAM set-address command plus its characters.
+ *
+ * Screens are declared once, in flash: the 32 characters of both lines and a
+ * table of the variable fields in them. LCD_Screen() has the application
+ * render just those fields into the framebuffer; the rest of the text is
+ * diffed and sent straight from flash, never copied.
+ *
+ * LCD_LINES=1 builds drive line 1 only: line 2 is never written, and the
+ * line-2 text and fields of the screens are left out of flash (LCD_LINE2).
+ */
+#ifndef LCD_LINES
+#define LCD_LINES       2           // Lines of text used: 2, or 1 (line 2 left blank)
+#endif
+
+// Screen text or fields on line 2: dropped from the build when LCD_LINES=1
+#if LCD_LINES > 1
+#define LCD_LINE2(...)  __VA_ARGS__
+#else
+#define LCD_LINE2(...)
+#endif
+
+// Completion flag: set by the ISR each time the queue drains, cleared by the user
+extern volatile unsigned char lcd_done;
+
+// Number of syncs that did not fit in the queue (the rest is retried later)
+extern volatile unsigned int lcd_overflows;
+
+// Bytes put on the I2C bus (address + control + payload), for traffic checks
+extern unsigned long lcd_tx_bytes;
+
+// Blocking bring-up: sends the init sequence polled, before interrupts are on
+void LCD_Init(void);
+
+// Non-blocking bring-up: LCD_Start() returns at once and LCD_Tick() must then
+// run every millisecond (interrupts on) until it returns 0. Frames drawn
+// meanwhile are held and sent once the display is ready.
+void LCD_Start(void);
+unsigned char LCD_Tick(void);
+unsigned char LCD_Ready(void);
+
+void LCD_SendCommand(unsigned char cmd);
+void LCD_SendLine1(const char *text);
+#if LCD_LINES > 1
+void LCD_SendLine2(const char *text);
+void LCD_SendBothLines(const char *line1, const char *line2);
+
+// Show a full 2x16 frame; only characters that differ from the display are sent
+void LCD_Frame(const char *line1, const char *line2);
+#endif
+
+// A variable field of a screen. A field stays on one line.
+typedef struct {
+    unsigned char cell;             // Column, 0-15 on line 1, 16-31 on line 2
+    unsigned char width;            // Characters
+    unsigned char source;           // What goes there: passed on to the LcdRender
+} LcdField;
+
+typedef struct {
+    const char *text;               // 16 characters per line in use: line 1, then line 2
+    const LcdField *fields;
+    unsigned char field_count;
+} LcdScreen;
+
+// Writes exactly width characters for source at out
+typedef void (*LcdRender)(unsigned char source, char *out, unsigned char width);
+
+// Show a screen: its fields are rendered in place, then synced like a frame
+void LCD_Screen(const LcdScreen *screen, LcdRender render);
+
+// Forget what the display holds (assume every cell is 'fill') and resend on next sync
+void LCD_Invalidate(char fill);
+
+// Send frame changes that were deferred because the queue was full
+void LCD_Service(void);
+
+// Nonzero while a transfer is queued or on the bus
+unsigned char LCD_Busy(void);
+
+// Nonzero once the display holds everything drawn: nothing queued, deferred
+// or waiting to be resent after a link error
+unsigned char LCD_Shown(void);
+
+// Optional hook run from the ISR when the queue drains (keep it short)
+void LCD_SetDoneCallback(void (*callback)(void));
+
+#endif
@@ -1,41 +1,123 @@
 #include "msp430f5308.h"
 #include "intrinsics.h"
+#include "lcd.h"
+#include "i2c.h"
+#include "bus.h"
+#include "clock.h"
+#include "prof.h"
+#include "telemetry.h"
+#include "store.h"
+#include "keypad.h"
+#include "bcd.h"
+#include "channels.h"
+#include "event.h"
+#include "wheel.h"
+#include "stack.h"
+#include "latency.h"
 
 /* ========================= Bus Interface (provided) ========================= */
-volatile unsigned int BusAddress, BusData;
+volatile unsigned int BusAddress, BusData;          // Only used by the legacy BusRead/BusWrite
 void Initial(void);
-void BusRead(void);
-void BusWrite(void);
-
-/* ========================= Hardware Addresses ========================= */
-#define SWITCHES_ADDR   0x4000
-#define LED_ADDR        0x4002
-#define SEG_LOW         0x4004
-#define SEG_HIGH        0x4006
-#define KEYPAD_ADDR     0x4008
 
 /* ========================= Configuration ========================= */
 #define SWITCH_S3_BIT   0x80        // S3 is bit 7 (not bit 0!)
 #define LED_D0          0x01        // Alarm LED (ACTIVE-LOW: 0=ON, 1=OFF)
 #define LED_D7          0x80        // S3 status LED (ACTIVE-LOW: 0=ON, 1=OFF)
+
+// Build variants: every option below is fixed at compile time, and a variant
+// carries only the code and screen text it uses (see README, Build variants)
+#ifndef DEBOUNCE_MS
 #define DEBOUNCE_MS     20          // 20ms debounce time
+#endif
+#ifndef BLINK_MS
 #define BLINK_MS        250         // 250ms toggle = 2Hz blink
+#endif
+#ifndef DEFAULT_THRESHOLD
+#define DEFAULT_THRESHOLD   0x0010  // mm:ss until one is entered or restored
+#endif
+
+// Reset on stop: 1 = S3 off clears the threshold entry for the next run,
+// 0 = the threshold is entered once and kept for every run
+#ifndef RESET_ON_STOP
+#define RESET_ON_STOP   1
+#endif
+
+// Keypad polling: 1 = the timer samples P2.0 every KEY_POLL_MS and there is
+// no port interrupt, 0 = P2.0 edges interrupt (Keypad_ISR)
+#ifndef KEYPAD_POLL
+#define KEYPAD_POLL     0
+#endif
+#define KEY_POLL_MS     20
+
+// Tickless mode: TA0 runs from ACLK and the CPU sleeps in LPM3 between events
+// instead of waking every millisecond (see README for the wakeup budget)
+#ifndef TICKLESS
+#define TICKLESS        0
+#endif
+#ifndef TICKLESS_XT1
+#define TICKLESS_XT1    0           // 1 = ACLK from a 32768 Hz crystal on XT1, 0 = REFO
+#endif
+#define TICKLESS_POLL_MS    10      // S3 poll period while nothing is pending
+#define DEBOUNCE_STEP_MS    5       // S3 poll period while a change is being debounced
+
+// Edge timestamps: start/stop are back-dated to the first sample that saw the
+// new S3 level and the run length is kept in microseconds
+#ifndef S3_TIMESTAMP
+#define S3_TIMESTAMP    0
+#endif
+
+// The 1 ms build keeps S3 edge stamps if any of them needs them
+#define EDGE_STAMPS     (S3_TIMESTAMP || TELEMETRY || LATENCY)
+
+#define TICK_CYCLES     ((unsigned long)CLOCK_TICK_CYCLES)  // SMCLK cycles per 1 ms tick
+
+// Fast boot: timer, keypad and outputs come up first and the LCD is brought up
+// in the background with the datasheet waits timed by TA1
+#ifndef FAST_BOOT
+#define FAST_BOOT       0
+#endif
+
+// Multi-channel: every switch runs its own stopwatch, threshold and alarm LED
+// (channels.h), and key C pages the displays between them. The switches are
+// sampled every CHANNEL_SAMPLE_MS, so a change must hold for 15-20 ms.
+#ifndef MULTI_CHANNEL
+#define MULTI_CHANNEL   0
+#endif
+#define CHANNEL_SAMPLE_MS   (DEBOUNCE_MS / DEBOUNCE_SAMPLES)
+#define KEY_CHANNEL_NEXT    12      // C: show the next channel
+#if MULTI_CHANNEL && (TICKLESS || EDGE_STAMPS)
+#error "MULTI_CHANNEL needs the 1 ms tick and no edge timestamps (TICKLESS, S3_TIMESTAMP, TELEMETRY and LATENCY off)"
+#endif
+
+// Profiler view (PROFILE=1): spare keypad keys (see keypad.h)
+#define KEY_PROF_NEXT   10          // A: next profiler page
+#define KEY_PROF_CLOSE  11          // B: back to the normal display
+#define KEY_STACK       10          // A: stack use (STACK_CHECK, A is the profiler's with PROFILE)
+#define KEY_LATENCY     11          // B: next latency page (LATENCY, B is the profiler's with PROFILE)
+#if PROFILE && TICKLESS
+#error "The profiler needs TA1 on the DCO (TICKLESS=0)"
+#endif
+#if (PROFILE || MULTI_CHANNEL || LATENCY) && LCD_LINES < 2
+#error "The profiler view, the channel pages and the latency pages need both LCD lines (LCD_LINES=2)"
+#endif
+
+#define KEY_PRESS_MS    5           // Keypad: settle time before the scan code is read
+#define KEY_RELEASE_MS  10          // Keypad: P2.0 must stay low this long to count as released
+#define KEYPAD_DA       0x01        // P2.0: keypad data available (high while a key is held)
+
+// Leave LPM0 or LPM3, whichever main went to sleep in
+#define WAKE_MAIN()     __bic_SR_register_on_exit(LPM3_bits)
 
 /* ========================= Seven-Segment Lookup (0-9) ========================= */
 static const unsigned char SegmentLookup[10] = {
     0x40, 0x79, 0x24, 0x30, 0x19, 0x12, 0x02, 0x78, 0x00, 0x18
 };
 
-/* ========================= Keypad Scan Code Lookup (0-9) ========================= */
-static const unsigned char KeypadLookup[16] = {
-    0x82, 0x11, 0x12, 0x14, 0x21, 0x22, 0x24, 0x41,
-    0x42, 0x44, 0x81, 0x84, 0x88, 0x48, 0x28, 0x18
-};
-
 /* ========================= Application State ========================= */
-// Timing variables
-static volatile unsigned char seconds = 0;          // Elapsed time (0-99)
-static volatile unsigned int  ms_count = 0;         // Millisecond counter
+// Timing variables (times are packed BCD, see bcd.h)
+static volatile unsigned long elapsed = 0;          // Elapsed time, hh:mm:ss
+static volatile unsigned long elapsed_prev = 0;     // Before the last tick (stop correction)
+static volatile unsigned long second_time = 0;      // Wheel_Now() count the last second tick fell at
 static volatile unsigned char timing = 0;           // 1 = actively timing
 
 // S3 switch state
@@ -44,451 +126,1492 @@ static volatile unsigned char s3_last = 0;          // Previous state for edge d
 static volatile unsigned char s3_raw = 0;           // Raw sample
 static volatile unsigned int  debounce_counter = 0;
 
+#if TICKLESS
+// Tickless timekeeping (TA0 counts ACLK, all times are Wheel_Now() counts)
+static volatile unsigned long s3_edge_time = 0;     // First sample at the new S3 level
+static volatile unsigned long s3_accept_time = 0;   // s3_edge_time of the last accepted change
+static volatile unsigned char tick_counted = 0;     // A tick fell this run (elapsed_prev is valid)
+#endif
+
+#if !TICKLESS
+static volatile unsigned long ms_ticks = 0;         // Free-running 1 ms count (the wheel's clock)
+static unsigned int tick_frac = 0;                  // CLOCK_TICK_FRAC carried between ticks (/1000)
+static unsigned long wheel_due;                     // Wheel_Compare() deadline...
+static volatile unsigned char wheel_due_set = 0;    // ...still to be reached by the tick
+#endif
+
+#if EDGE_STAMPS && !TICKLESS
+// Edge timestamps: the 1 ms build stamps (ms tick, TA0R), the tickless build TA0R
+static volatile unsigned long s3_edge_ms = 0;       // First sample at the new S3 level...
+static volatile unsigned int  s3_edge_sub = 0;      // ...and TA0R when it was taken
+static volatile unsigned long s3_accept_ms = 0;     // Edge of the last accepted change
+static volatile unsigned int  s3_accept_sub = 0;
+#endif
+
+#if S3_TIMESTAMP
+#if TICKLESS
+static unsigned long run_start_time;                // s3_edge_time of the start edge
+static volatile unsigned int run_seconds = 0;       // Ticks this run (binary, for run_elapsed_us)
+#else
+static unsigned long run_start_ms;
+static unsigned int  run_start_sub;
+#endif
+static unsigned long run_elapsed_us = 0;            // Length of the last run
+#endif
+
+#if MULTI_CHANNEL
+// All eight switches, debounced together every CHANNEL_SAMPLE_MS
+static Debounce8 switch_debounce;                   // Levels and vertical counts
+static volatile unsigned char switches_changed = 0; // Debounced changes main has not handled
+static volatile unsigned long switches_changed_ms;  // ms_ticks when they were accepted
+static volatile unsigned char blink_dark = 0;       // 0xFF while alarm LEDs are in their off half
+static unsigned char channel_page = 7;              // Channel on the displays (S3's to start with)
+#endif
+
 // Alarm state
-static volatile unsigned char threshold = 10;       // Default 10 seconds (for testing)
+static volatile unsigned int  threshold = DEFAULT_THRESHOLD;    // mm:ss, or the last one stored
+static unsigned char session_alarm = 0;             // Alarm fired during this run (for the log)
 static volatile unsigned char alarm_on = 0;         // Alarm active flag
-static volatile unsigned int  blink_count = 0;      // Blink timer
 
-// Event flags
-static volatile unsigned char flag_switch = 0;
-static volatile unsigned char flag_second = 0;
-static volatile unsigned char flag_blink = 0;
+// Main-loop events (event.h), most urgent first: everything that decides the
+// outputs comes before any LCD drawing
+enum {
+    EV_SWITCH,                  // S3 (or a channel's switch) changed: start or stop
+    EV_SECOND,                  // A second fell: digits, threshold and alarm
+    EV_BLINK,                   // Alarm blink half-period: toggle the LED
+    EV_KEY,                     // Key presses in the keypad FIFO
+    EV_LCD_TIMING,              // Redraw the timing screen
+    EV_LCD_STATUS,              // Redraw the threshold entry
+    EV_LCD_DONE                 // LCD queue drained: send what did not fit
+};
+
+#if TICKLESS
+static volatile unsigned int clock_wraps = 0;       // TA0 wraps since boot (2 s each)
+#endif
+
+static volatile unsigned char key_held = KEY_NONE;  // Key of the press in progress
+#if KEYPAD_POLL
+static volatile unsigned char key_sample = KEY_NONE;    // Key seen by the last poll
+#else
+// Keypad state machine (see Keypad_Deadline)
+enum { KEY_IDLE, KEY_PRESS_WAIT, KEY_DOWN, KEY_RELEASE_WAIT };
+static volatile unsigned char key_state = KEY_IDLE;
+#endif
+
+// Worst-case Timer_ISR entry latency seen (SMCLK cycles, or ACLK ticks if TICKLESS)
+static volatile unsigned int timer_latency_max = 0;
+
+// Threshold entry state: digits shift in from the right, mm:ss
+#define ENTRY_DIGITS    4
+static volatile unsigned char digit_count = 0;      // Digits entered (0-4)
+static volatile unsigned int  digit_entry = 0;      // The digits, packed BCD, last one lowest
+static volatile unsigned char entry_done = 0;       // Threshold set from them
+
+#if FAST_BOOT
+// Boot times in TA1 counts (ACLK) from the start of main: Initial's fixed
+// PMM/FLL/LCD-reset time comes before that and is not included
+static volatile unsigned int  boot_periods = 0;     // TA1 periods since main started
+static volatile unsigned long boot_ticks_outputs = 0;   // Timer, keypad and outputs live
+static volatile unsigned long boot_ticks_display = 0;   // Start-up frame on the LCD
+#endif
+
+#if PROFILE
+static volatile unsigned char prof_page = 0;        // 0 = off, else 1 + 2 * routine + page
+#endif
+
+#if STACK_CHECK
+static unsigned char stack_view = 0;                // 1 = the status screen shows stack use
+static unsigned char stack_fault = 0;               // Canary hit: outputs frozen in the alarm state
+#define STACK_FAULTED()     stack_fault
+#else
+#define STACK_FAULTED()     0
+#endif
 
-// Threshold entry state
-static volatile unsigned char digit_count = 0;      // 0, 1, or 2 digits entered
-static volatile unsigned char digit_buffer[2];      // Store entered digits
-static volatile unsigned char lcd_refresh = 0;      // LCD update needed
+#if LATENCY
+static volatile unsigned long key_edge_stamp;       // Event_Now() at the last keypad edge (or first sample)...
+static volatile unsigned long key_press_stamp;      // ...that became the last press queued
+static unsigned char lat_page = 0;                  // 0 = off, else 1 + path on the LCD
+static volatile unsigned char lat_drawn = 0;        // LCD paths whose screen has been drawn
+#define KEY_EDGE_STAMP()    (key_edge_stamp = Event_Now())
+#else
+#define KEY_EDGE_STAMP()
+#endif
 
 // LED shadow register (ACTIVE-LOW: 0=ON, 1=OFF)
 static volatile unsigned char leds = 0xFF;          // Start with all LEDs OFF
 
-/* ========================= LCD Setup (I2C) ========================= */
-static void LCD_SendCommand(unsigned char cmd) {
-    UCB1CTL1 |= UCTR | UCTXSTT;
-    while(!(UCB1IFG & UCTXIFG));
-    UCB1TXBUF = 0x00; while(!(UCB1IFG & UCTXIFG));
-    UCB1TXBUF = cmd;  while(!(UCB1IFG & UCTXIFG));
-    UCB1CTL1 |= UCTXSTP; while(UCB1CTL1 & UCTXSTP);
-    UCB1IFG &= ~UCTXIFG;
+/* ========================= Helper Functions ========================= */
+// Outputs go through the shadow layer (bus.c): the timer ISRs flush the LEDs
+// they change, main flushes everything at the end of each main-loop pass
+static void UpdateLEDs(void) {
+    BusOut_Set(LED_ADDR, leds);
 }
 
-static void LCD_SendLine1(const char *text) {
-    unsigned char i;
-    
-    // Position cursor at start of first line (0x80)
-    UCB1CTL1 |= UCTR | UCTXSTT;
-    while(!(UCB1IFG & UCTXIFG));
-    UCB1TXBUF = 0x80;  // Control byte for command
-    while(!(UCB1IFG & UCTXIFG));
-    UCB1TXBUF = 0x80;  // DDRAM address 0x00 (line 1)
-    while(!(UCB1IFG & UCTXIFG));
-    
-    UCB1TXBUF = 0x40;  // Control byte for data
-    while(!(UCB1IFG & UCTXIFG));
-    
-    for(i = 0; i < 16; i++) {
-        UCB1TXBUF = text[i];
-        while(!(UCB1IFG & UCTXIFG));
-    }
-    
-    UCB1CTL1 |= UCTXSTP;
-    while(UCB1CTL1 & UCTXSTP);
-    UCB1IFG &= ~UCTXIFG;
+#if PROFILE
+// Bus reads go through here so the profiler sees them
+static unsigned int ReadBus(unsigned int address) {
+    unsigned int value;
+    PROF_ENTER(PROF_BUS_READ);
+    value = BusReadAt(address);
+    PROF_EXIT(PROF_BUS_READ);
+    return value;
 }
+#else
+#define ReadBus(address)    BusReadAt(address)
+#endif
 
-static void LCD_SendLine2(const char *text) {
-    unsigned char i;
-    
-    // Position cursor at start of second line (0xC0)
-    UCB1CTL1 |= UCTR | UCTXSTT;
-    while(!(UCB1IFG & UCTXIFG));
-    UCB1TXBUF = 0x80;  // Control byte for command
-    while(!(UCB1IFG & UCTXIFG));
-    UCB1TXBUF = 0xC0;  // DDRAM address 0x40 (line 2)
-    while(!(UCB1IFG & UCTXIFG));
-    
-    UCB1TXBUF = 0x40;  // Control byte for data
-    while(!(UCB1IFG & UCTXIFG));
+// Two digits for an hh:mm:ss time: the top field in use (seconds for the
+// first minute, then minutes, then hours)
+static void UpdateDisplay(unsigned long time) {
+    unsigned char field;
+    PROF_ENTER(PROF_UPDATE_DISPLAY);
     
-    for(i = 0; i < 16; i++) {
-        UCB1TXBUF = text[i];
-        while(!(UCB1IFG & UCTXIFG));
-    }
+    if(time >> 16) field = (unsigned char)(time >> 16);
+    else if(time >> 8) field = (unsigned char)(time >> 8);
+    else field = (unsigned char)time;
     
-    UCB1CTL1 |= UCTXSTP;
-    while(UCB1CTL1 & UCTXSTP);
-    UCB1IFG &= ~UCTXIFG;
+    BusOut_Set(SEG_LOW, SegmentLookup[field & 0x0F]);
+    BusOut_Set(SEG_HIGH, SegmentLookup[field >> 4]);
+    PROF_EXIT(PROF_UPDATE_DISPLAY);
 }
 
-static void LCD_SendBothLines(const char *line1, const char *line2) {
-    LCD_SendLine1(line1);
-    LCD_SendLine2(line2);
+// Two packed-BCD digits as text; returns the position after them
+static char *PutBCD(char *text, unsigned char bcd) {
+    text[0] = '0' + (bcd >> 4);
+    text[1] = '0' + (bcd & 0x0F);
+    return text + 2;
 }
 
-static void LCD_Init(void) {
-    unsigned int Wait;
-    
-    // I2C configuration
-    UCB1CTL1 |= UCSWRST;
-    UCB1CTL0 = UCMST | UCMODE_3 | UCSYNC;
-    UCB1CTL1 = UCSSEL_1 | UCSWRST;
-    UCB1BR0 = 63;
-    UCB1I2CSA = 0x3E;
-    P4SEL |= 0x06;                  // P4.1=SDA, P4.2=SCL
-    UCB1CTL1 &= ~UCSWRST;
-
-    // LCD initialization sequence
-    UCB1CTL1 |= UCTR | UCTXSTT;
-    while(!(UCB1IFG & UCTXIFG));
-    UCB1TXBUF = 0x00; while(!(UCB1IFG & UCTXIFG));
-    UCB1TXBUF = 0x39; while(!(UCB1IFG & UCTXIFG));
-    UCB1TXBUF = 0x14; while(!(UCB1IFG & UCTXIFG));
-    UCB1TXBUF = 0x74; while(!(UCB1IFG & UCTXIFG));
-    UCB1TXBUF = 0x54; while(!(UCB1IFG & UCTXIFG));
-    UCB1TXBUF = 0x6F; while(!(UCB1IFG & UCTXIFG));
-    UCB1TXBUF = 0x0E; while(!(UCB1IFG & UCTXIFG));
-    UCB1TXBUF = 0x01; while(!(UCB1IFG & UCTXIFG));
-    UCB1CTL1 |= UCTXSTP; while(UCB1CTL1 & UCTXSTP);
-    UCB1IFG &= ~UCTXIFG;
-
-    for(Wait = 0; Wait < 10000; Wait++);
-
-    LCD_SendLine1("  CLIC3 Timer   ");
-    LCD_SendLine2("Enter threshold:");
+// "mm:ss"
+static char *PutMinSec(char *text, unsigned int time) {
+    text = PutBCD(text, (unsigned char)(time >> 8));
+    *text++ = ':';
+    return PutBCD(text, (unsigned char)time);
 }
 
-/* ========================= Helper Functions ========================= */
-static void UpdateLEDs(void) {
-    BusAddress = LED_ADDR;
-    BusData = leds;
-    BusWrite();
+/* ========================= Screens =========================
+ * Every LCD screen is a 2x16 frame in flash plus the fields patched into it
+ * on each draw (lcd.h). Only Screen_Field() formats anything; the static text
+ * goes from flash to the display without a copy. A new screen is an entry in
+ * screens[] and, if it shows anything variable, its field list.
+ */
+enum {
+    FIELD_ELAPSED,              // "mm:ss", or "hh:mm:ss" in an 8-wide field
+    FIELD_THRESHOLD,            // "mm:ss"
+    FIELD_ENTRY,                // Digits entered so far, as "mm:ss"
+    FIELD_RUN_MS,               // Last run as "ss.mmm" (S3_TIMESTAMP)
+    FIELD_CHANNEL,              // Channel on the displays, one digit (MULTI_CHANNEL)
+    FIELD_STACK_PEAK,           // Stack_HighWater(), decimal bytes (STACK_CHECK)
+    FIELD_STACK_SIZE            // Stack_Size(), decimal bytes
+};
+
+// In screens[] order. Each _H screen (hh:mm:ss) follows its mm:ss form.
+enum {
+    SCREEN_BOOT,
+    SCREEN_PROMPT,
+    SCREEN_ENTRY,
+    SCREEN_READY,
+    SCREEN_TIMING,
+    SCREEN_TIMING_H,
+    SCREEN_EXCEEDED,
+    SCREEN_EXCEEDED_H,
+    SCREEN_ELAPSED,
+    SCREEN_ELAPSED_H,
+    SCREEN_ELAPSED_MS,
+#if MULTI_CHANNEL
+    SCREEN_CH_ENTRY,
+    SCREEN_CH_TIMING,
+    SCREEN_CH_TIMING_H,
+    SCREEN_CH_EXCEEDED,
+    SCREEN_CH_EXCEEDED_H,
+    SCREEN_CH_STOPPED,
+    SCREEN_CH_STOPPED_H,
+#endif
+#if STACK_CHECK
+    SCREEN_STACK,
+    SCREEN_STACK_FAULT,
+#endif
+};
+
+static const LcdField fields_entry[]      = { {  8, 5, FIELD_ENTRY } };
+static const LcdField fields_ready[]      = { { 11, 5, FIELD_THRESHOLD } };
+static const LcdField fields_timing[]     = { {  8, 5, FIELD_ELAPSED }, LCD_LINE2({ 23, 5, FIELD_THRESHOLD }) };
+static const LcdField fields_exceeded[]   = { { 10, 5, FIELD_ELAPSED }, LCD_LINE2({ 23, 5, FIELD_THRESHOLD }) };
+static const LcdField fields_hours[]      = { {  8, 8, FIELD_ELAPSED }, LCD_LINE2({ 23, 5, FIELD_THRESHOLD }) };
+static const LcdField fields_elapsed[]    = { {  9, 5, FIELD_ELAPSED } };
+static const LcdField fields_elapsed_h[]  = { {  8, 8, FIELD_ELAPSED } };
+static const LcdField fields_elapsed_ms[] = { {  9, 6, FIELD_RUN_MS } };
+#if MULTI_CHANNEL
+static const LcdField fields_ch_entry[]    = { {  2, 1, FIELD_CHANNEL }, { 11, 5, FIELD_ENTRY } };
+static const LcdField fields_ch_timing[]   = { {  8, 5, FIELD_ELAPSED }, { 23, 5, FIELD_THRESHOLD }, { 31, 1, FIELD_CHANNEL } };
+static const LcdField fields_ch_exceeded[] = { { 10, 5, FIELD_ELAPSED }, { 23, 5, FIELD_THRESHOLD }, { 31, 1, FIELD_CHANNEL } };
+static const LcdField fields_ch_stopped[]  = { {  9, 5, FIELD_ELAPSED }, { 23, 5, FIELD_THRESHOLD }, { 31, 1, FIELD_CHANNEL } };
+static const LcdField fields_ch_hours[]    = { {  8, 8, FIELD_ELAPSED }, { 23, 5, FIELD_THRESHOLD }, { 31, 1, FIELD_CHANNEL } };
+#endif
+#if STACK_CHECK
+static const LcdField fields_stack[]      = { { 12, 4, FIELD_STACK_PEAK }, LCD_LINE2({ 19, 4, FIELD_STACK_SIZE }) };
+#endif
+
+#if RESET_ON_STOP
+#define ELAPSED_LINE2           "Enter threshold:"
+#else
+#define ELAPSED_LINE2           "Press S3 to run "  // The threshold is kept
+#endif
+
+#define SCREEN(text, fields)    { text, fields, sizeof fields / sizeof fields[0] }
+#define SCREEN_TEXT(text)       { text, 0, 0 }
+
+// Text under a field is never shown; it documents the layout. Line 2 goes
+// through LCD_LINE2, so a one-line build leaves it out of flash.
+static const LcdScreen screens[] = {
+    SCREEN_TEXT("  CLIC3 Timer   " LCD_LINE2("Enter threshold:")),
+    SCREEN_TEXT("  Press 0-9     " LCD_LINE2("Enter threshold:")),
+    SCREEN("Thresh: mm:ss   "      LCD_LINE2("More 0-9, F=set "), fields_entry),
+    SCREEN("Threshold: mm:ss"      LCD_LINE2("Press S3 to run "), fields_ready),
+    SCREEN("Timing: mm:ss   "      LCD_LINE2("Limit: mm:ss    "), fields_timing),
+    SCREEN("Timing: hh:mm:ss"      LCD_LINE2("Limit: mm:ss    "), fields_hours),
+    SCREEN("EXCEEDED! mm:ss "      LCD_LINE2("Limit: mm:ss    "), fields_exceeded),
+    SCREEN("EXCEED! hh:mm:ss"      LCD_LINE2("Limit: mm:ss    "), fields_hours),
+    SCREEN("Elapsed: mm:ss  "      LCD_LINE2(ELAPSED_LINE2), fields_elapsed),
+    SCREEN("Elapsed hh:mm:ss"      LCD_LINE2(ELAPSED_LINE2), fields_elapsed_h),
+    SCREEN("Elapsed: ss.mmms"      LCD_LINE2(ELAPSED_LINE2), fields_elapsed_ms),
+#if MULTI_CHANNEL
+    SCREEN("Ch7 limit: mm:ss"      "More 0-9, F=set ", fields_ch_entry),
+    SCREEN("Timing: mm:ss   "      "Limit: mm:ss Ch7", fields_ch_timing),
+    SCREEN("Timing: hh:mm:ss"      "Limit: mm:ss Ch7", fields_ch_hours),
+    SCREEN("EXCEEDED! mm:ss "      "Limit: mm:ss Ch7", fields_ch_exceeded),
+    SCREEN("EXCEED! hh:mm:ss"      "Limit: mm:ss Ch7", fields_ch_hours),
+    SCREEN("Elapsed: mm:ss  "      "Limit: mm:ss Ch7", fields_ch_stopped),
+    SCREEN("Elapsed hh:mm:ss"      "Limit: mm:ss Ch7", fields_ch_hours),
+#endif
+#if STACK_CHECK
+    SCREEN("Stack peak: nnnn"      LCD_LINE2("of ssss bytes   "), fields_stack),
+    SCREEN_TEXT("STACK OVERFLOW! " LCD_LINE2("Reset the board ")),
+#endif
+};
+
+static unsigned long screen_elapsed;                // elapsed as of this draw
+
+static void Screen_Field(unsigned char source, char *out, unsigned char width) {
+    switch(source) {
+    case FIELD_ELAPSED:
+        if(width == 8) {
+            out = PutBCD(out, (unsigned char)(screen_elapsed >> 16));
+            *out++ = ':';
+        }
+        PutMinSec(out, (unsigned int)screen_elapsed);
+        break;
+    case FIELD_THRESHOLD:
+#if MULTI_CHANNEL
+        PutMinSec(out, channels[channel_page].threshold);
+#else
+        PutMinSec(out, threshold);
+#endif
+        break;
+    case FIELD_ENTRY:
+        PutMinSec(out, digit_entry);
+        break;
+#if S3_TIMESTAMP
+    case FIELD_RUN_MS: {
+        unsigned long ms = run_elapsed_us / 1000;
+        unsigned char i;
+        for(i = 6; i > 0; i--) {
+            if(i == 3) { out[2] = '.'; continue; }
+            out[i - 1] = '0' + (ms % 10);
+            ms /= 10;
+        }
+        break;
+    }
+#endif
+#if MULTI_CHANNEL
+    case FIELD_CHANNEL:
+        *out = '0' + channel_page;
+        break;
+#endif
+#if STACK_CHECK
+    case FIELD_STACK_PEAK:
+    case FIELD_STACK_SIZE: {
+        unsigned int bytes = (source == FIELD_STACK_PEAK) ? Stack_HighWater() : Stack_Size();
+        while(width--) {
+            out[width] = '0' + (bytes % 10);
+            bytes /= 10;
+        }
+        break;
+    }
+#endif
+    default:
+        break;
+    }
 }
 
-static void UpdateDisplay(unsigned char value) {
-    if(value > 99) value = 99;
-    
-    unsigned char tens = value / 10;
-    unsigned char ones = value % 10;
-    
-    BusAddress = SEG_LOW;
-    BusData = SegmentLookup[ones];
-    BusWrite();
-    
-    BusAddress = SEG_HIGH;
-    BusData = SegmentLookup[tens];
-    BusWrite();
+#if LATENCY
+#define LAT_LCD_PATHS   (LAT_BIT(LAT_S3_LCD) | LAT_BIT(LAT_KEY_LCD))
+
+// The LCD paths drawn end once the display holds everything (interrupts off)
+static void Latency_LcdCheck(void) {
+    if(lat_drawn && LCD_Shown()) {
+        Latency_Output(lat_drawn, Event_Now());
+        lat_drawn = 0;
+    }
 }
+#endif
 
-static void UpdateLCD_Status(void) {
+static void ShowScreen(unsigned char screen) {
+    LCD_Screen(&screens[screen], Screen_Field);
+#if LATENCY
+    {
+        // The screen the waiting LCD paths wait for is out: they end with its
+        // transfer, or now if nothing on it changed
+        __istate_t state = __get_interrupt_state();
+        __disable_interrupt();
+        lat_drawn |= Latency_Waiting() & LAT_LCD_PATHS;
+        Latency_LcdCheck();
+        __set_interrupt_state(state);
+    }
+#endif
+}
+
+#if MULTI_CHANNEL
+static void UpdateLCD_Timing(void);
+#endif
+
+#if LATENCY
+// A latency page owns the LCD, so the LCD paths have nothing to wait for
+static void ShowLatency(void) {
     char line1[16], line2[16];
-    unsigned char i;
-    const char *template;
-    
-    // Clear both line buffers with spaces
-    for(i = 0; i < 16; i++) {
-        line1[i] = ' ';
-        line2[i] = ' ';
+    Latency_Render(lat_page - 1, line1, line2);
+    LCD_SendBothLines(line1, line2);
+    __disable_interrupt();
+    Latency_Drop(LAT_LCD_PATHS);
+    lat_drawn = 0;
+    __enable_interrupt();
+}
+#endif
+
+static void UpdateLCD_Status(void) {
+#if LATENCY
+    if(lat_page) {
+        ShowLatency();
+        return;
     }
-    
-    if(digit_count == 0) {
-        // Waiting for threshold entry
-        template = "Enter threshold:";
-        for(i = 0; i < 16; i++) line2[i] = template[i];
-        template = "  Press 0-9     ";
-        for(i = 0; i < 16; i++) line1[i] = template[i];
-    }
-    else if(digit_count == 1) {
-        // Show first digit
-        template = "Thresh: ";
-        for(i = 0; i < 8; i++) line1[i] = template[i];
-        line1[8] = '0' + digit_buffer[0];
-        line1[9] = '_';
-        
-        template = "Enter 2nd digit:";
-        for(i = 0; i < 16; i++) line2[i] = template[i];
-    }
-    else if(digit_count == 2) {
-        // Show complete threshold
-        template = "Threshold: ";
-        for(i = 0; i < 11; i++) line1[i] = template[i];
-        line1[11] = '0' + (threshold / 10);
-        line1[12] = '0' + (threshold % 10);
-        line1[13] = 's';
-        
-        template = "Press S3 to run ";
-        for(i = 0; i < 16; i++) line2[i] = template[i];
+#endif
+#if STACK_CHECK
+    if(stack_view) {
+        ShowScreen(SCREEN_STACK);                       // "Stack peak: nnnn"
+        return;
     }
-    
+#endif
+#if MULTI_CHANNEL
+    UpdateLCD_Timing();                                 // The channel page shows the entry too
+#else
+    if(entry_done) ShowScreen(SCREEN_READY);            // "Threshold: mm:ss"
+    else if(digit_count == 0) ShowScreen(SCREEN_PROMPT);
+    else ShowScreen(SCREEN_ENTRY);                      // Digits so far, as mm:ss
+#endif
+}
+
+#if PROFILE
+static void ShowProfile(void) {
+    char line1[16], line2[16];
+    Prof_Render((prof_page - 1) >> 1, (prof_page - 1) & 1, line1, line2);
     LCD_SendBothLines(line1, line2);
 }
+#endif
 
 static void UpdateLCD_Timing(void) {
-    char line1[16], line2[16];
-    unsigned char i;
-    const char *template;
+    unsigned char hours;
+#if MULTI_CHANNEL
+    unsigned char bit = 1 << channel_page;
+#endif
     
-    // Clear both line buffers with spaces
-    for(i = 0; i < 16; i++) {
-        line1[i] = ' ';
-        line2[i] = ' ';
+#if PROFILE
+    // The profiler view owns the LCD until it is closed
+    if(prof_page) {
+        ShowProfile();
+        return;
     }
-    
-    if(alarm_on) {
-        // Line 1: "EXCEEDED! xx s  "
-        template = "EXCEEDED! ";
-        for(i = 0; i < 10; i++) line1[i] = template[i];
-        line1[10] = '0' + (seconds / 10);
-        line1[11] = '0' + (seconds % 10);
-        line1[12] = 's';
-        
-        // Line 2: "Limit: xx s     "
-        template = "Limit: ";
-        for(i = 0; i < 7; i++) line2[i] = template[i];
-        line2[7] = '0' + (threshold / 10);
-        line2[8] = '0' + (threshold % 10);
-        line2[9] = 's';
-    } else if(timing) {
-        // Line 1: "Timing: xx s    "
-        template = "Timing: ";
-        for(i = 0; i < 8; i++) line1[i] = template[i];
-        line1[8] = '0' + (seconds / 10);
-        line1[9] = '0' + (seconds % 10);
-        line1[10] = 's';
-        
-        // Line 2: "Limit: xx s     "
-        template = "Limit: ";
-        for(i = 0; i < 7; i++) line2[i] = template[i];
-        line2[7] = '0' + (threshold / 10);
-        line2[8] = '0' + (threshold % 10);
-        line2[9] = 's';
-    } else {
-        // Line 1: "Elapsed: xx s   "
-        template = "Elapsed: ";
-        for(i = 0; i < 9; i++) line1[i] = template[i];
-        line1[9] = '0' + (seconds / 10);
-        line1[10] = '0' + (seconds % 10);
-        line1[11] = 's';
-        
-        // Line 2: "Enter threshold:"
-        template = "Enter threshold:";
-        for(i = 0; i < 16; i++) line2[i] = template[i];
+#endif
+#if LATENCY
+    if(lat_page) {
+        ShowLatency();
+        return;
     }
+#endif
+#if STACK_CHECK
+    stack_view = 0;                                     // Run changes take the LCD back
+#endif
+    PROF_ENTER(PROF_UPDATE_LCD);
     
-    LCD_SendBothLines(line1, line2);
+#if MULTI_CHANNEL
+    screen_elapsed = channels[channel_page].elapsed;
+    hours = (screen_elapsed >> 16) != 0;
+    
+    if(digit_count) ShowScreen(SCREEN_CH_ENTRY);        // "Ch7 limit: mm:ss"
+    else if(channels_alarm & bit) ShowScreen(SCREEN_CH_EXCEEDED + hours);
+    else if(channels_running & bit) ShowScreen(SCREEN_CH_TIMING + hours);
+    else ShowScreen(SCREEN_CH_STOPPED + hours);
+#else
+    screen_elapsed = elapsed;
+    hours = (screen_elapsed >> 16) != 0;
+    
+    if(alarm_on) ShowScreen(SCREEN_EXCEEDED + hours);
+    else if(timing) ShowScreen(SCREEN_TIMING + hours);
+#if S3_TIMESTAMP
+    else if(run_elapsed_us / 1000 <= 99999) ShowScreen(SCREEN_ELAPSED_MS);   // Runs under 100 s
+#endif
+    else ShowScreen(SCREEN_ELAPSED + hours);
+#endif
+    
+    PROF_EXIT(PROF_UPDATE_LCD);
+}
+
+#if KEYPAD_POLL
+static unsigned char Keypad_Poll(void);
+#else
+static unsigned char Keypad_Deadline(void);
+#endif
+
+#if TELEMETRY && !TICKLESS
+// Milliseconds since boot for telemetry records (interrupts off)
+static unsigned long Now_ms(void) {
+    return ms_ticks;
+}
+#endif
+
+#if !TICKLESS
+// Event stamps in SMCLK cycles since boot (interrupts off). A tick whose
+// interrupt has not run yet has already restarted TA0R.
+unsigned long Event_Now(void) {
+    unsigned int sub = TA0R;
+    unsigned long ms = ms_ticks;
+    if((TA0CCTL0 & CCIFG) && sub < (TICK_CYCLES >> 1)) ms++;
+    return ms * TICK_CYCLES + sub;
+}
+
+#if LATENCY
+unsigned long Latency_Us(unsigned long span) {
+    return (span / TICK_CYCLES) * 1000 + (span % TICK_CYCLES) * 1000 / TICK_CYCLES;
+}
+
+#define S3_STAMP()      (s3_accept_ms * TICK_CYCLES + s3_accept_sub)   // Event_Now() of the accepted edge
+#endif
+#endif
+
+/* ========================= Software Timers =========================
+ * Every job with a period or a deadline is a timer on the wheel (wheel.c),
+ * in both builds; only the clock differs. The 1 ms build counts ticks
+ * (ms_ticks) and the tick reaches the wheel's deadline; the tickless build
+ * counts ACLK and CCR0 matches it. A new job is a WHEEL_TIMER() and a
+ * Wheel_Start(), with no change to either ISR:
+ *   second_timer - one-second tick, armed only while timing (MULTI_CHANNEL:
+ *                  the earliest channel second, armed by main)
+ *   blink_timer  - 2 Hz alarm blink, armed only while the alarm is on
+ *                  (MULTI_CHANNEL: always, the LEDs blink in step)
+ *   key_timer    - keypad debounce deadline, or the keypad poll every
+ *                  KEY_POLL_MS (KEYPAD_POLL)
+ *   sample_timer - all the switches every CHANNEL_SAMPLE_MS (MULTI_CHANNEL)
+ *   poll_timer   - S3 poll (tickless; the 1 ms tick samples S3 itself)
+ */
+#if TICKLESS
+#define ACLK_HZ             32768UL
+#define MS_TO_TICKS(ms)     ((unsigned int)(((ms) * ACLK_HZ + 500) / 1000))
+#define TICKS_PER_SECOND    ((unsigned int)ACLK_HZ)
+#else
+#define MS_TO_TICKS(ms)     ((unsigned int)(ms))
+#define TICKS_PER_SECOND    1000u
+#endif
+
+static unsigned char Second_Expired(unsigned long due);
+static unsigned char Blink_Expired(unsigned long due);
+static unsigned char Key_Expired(unsigned long due);
+
+static WheelTimer second_timer = WHEEL_TIMER(Second_Expired);
+static WheelTimer blink_timer = WHEEL_TIMER(Blink_Expired);
+static WheelTimer key_timer = WHEEL_TIMER(Key_Expired);
+#if MULTI_CHANNEL
+static unsigned char Sample_Expired(unsigned long due);
+static WheelTimer sample_timer = WHEEL_TIMER(Sample_Expired);
+#endif
+#if TICKLESS
+static unsigned char Poll_Expired(unsigned long due);
+static WheelTimer poll_timer = WHEEL_TIMER(Poll_Expired);
+#endif
+
+#if !TICKLESS
+/* ========================= Timer A0 ISR (1ms tick) =========================
+ * The tick samples S3 and runs the I2C watchdog, the two jobs due every
+ * millisecond; everything else runs from the wheel once the tick count
+ * reaches the deadline Wheel_Compare() left.
+ */
+// The tick count (interrupts off)
+unsigned long Wheel_Now(void) {
+    return ms_ticks;
+}
+
+// The compare is the next tick at or past due: one already passed fires
+// on the next tick
+void Wheel_Compare(unsigned long due) {
+    wheel_due = due;
+    wheel_due_set = 1;
 }
 
-/* ========================= Timer A0 ISR (1ms tick) ========================= */
 #pragma vector = TIMER0_A0_VECTOR
 __interrupt void Timer_ISR(void) {
+    // Up mode restarts TA0R at the CCR0 match, so TA0R is how late this entry is
+    unsigned int latency = TA0R;
+    if(latency > timer_latency_max) timer_latency_max = latency;
+    PROF_ENTER(PROF_TIMER_ISR);
+    ms_ticks++;
+
+    // Length of the tick that has just started: one cycle longer for
+    // CLOCK_TICK_FRAC ticks in 1000, so 1000 ticks are exactly CLOCK_HZ_ACTUAL
+    tick_frac += CLOCK_TICK_FRAC;
+    if(tick_frac >= 1000) {
+        tick_frac -= 1000;
+        TA0CCR0 = TICK_CYCLES;
+    } else {
+        TA0CCR0 = TICK_CYCLES - 1;
+    }
+    
+    // LCD link: end a stuck transfer, time the rest after an error
+    if(I2C_Watchdog(1)) WAKE_MAIN();
+    
+#if !MULTI_CHANNEL
     // Read S3 switch state
-    BusAddress = SWITCHES_ADDR;
-    BusRead();
-    unsigned char s3_now = (BusData & SWITCH_S3_BIT) ? 1 : 0;
+    unsigned char s3_now = (ReadBus(SWITCHES_ADDR) & SWITCH_S3_BIT) ? 1 : 0;
+#if EDGE_STAMPS
+    unsigned int sample_sub = TA0R;     // Sub-ms time of the sample
+#endif
     
     // Debounce logic
     if(s3_now != s3_raw) {
         s3_raw = s3_now;
         debounce_counter = 0;
+#if EDGE_STAMPS
+        s3_edge_ms = ms_ticks;
+        s3_edge_sub = sample_sub;
+#endif
     } else {
         if(debounce_counter < DEBOUNCE_MS) {
             debounce_counter++;
         } else if(s3_debounced != s3_raw) {
             s3_debounced = s3_raw;
-            flag_switch = 1;
-            __bic_SR_register_on_exit(LPM0_bits);
+#if EDGE_STAMPS
+            s3_accept_ms = s3_edge_ms;
+            s3_accept_sub = s3_edge_sub;
+#endif
+            TELEMETRY_EVENT(s3_debounced ? TEL_S3_ON : TEL_S3_OFF, 0, s3_accept_ms);
+            Event_Post(EV_SWITCH);      // D7 follows in main
+            WAKE_MAIN();
         }
     }
+#endif
     
-    // Update D7 to match S3 state (ACTIVE-LOW: clear bit to turn ON)
-    if(s3_debounced) {
-        leds &= ~LED_D7;  // S3 ON -> D7 ON (clear bit = 0)
-    } else {
-        leds |= LED_D7;   // S3 OFF -> D7 OFF (set bit = 1)
+    // Timers due by this tick
+    if(wheel_due_set && (long)(ms_ticks - wheel_due) >= 0) {
+        wheel_due_set = 0;
+        if(Wheel_Run()) WAKE_MAIN();
     }
-    
-    // Timing logic
-    if(timing) {
-        ms_count++;
-        if(ms_count >= 1000) {
-            ms_count = 0;
-            if(seconds < 99) seconds++;
-            flag_second = 1;
-            __bic_SR_register_on_exit(LPM0_bits);
+    PROF_EXIT(PROF_TIMER_ISR);
+}
+
+#else
+/* ========================= Tickless Timer A0 (ACLK) =========================
+ * TA0 free-runs on ACLK and CCR0 alone serves the wheel, so the CPU only
+ * wakes when something is due. S3 is polled from poll_timer, every
+ * TICKLESS_POLL_MS when idle and every DEBOUNCE_STEP_MS while a change is
+ * pending. TA0IFG counts the wraps that extend TA0R to the wheel's 32-bit clock.
+ * Start and stop are back-dated to the first sample that saw the new S3 level,
+ * so the seconds tick up to DEBOUNCE_MS earlier than in the 1 ms build, which
+ * counts from the debounce accept (the run length is the same in both).
+ */
+// TA0 is clocked asynchronously to MCLK: read until two reads agree
+static unsigned int TimerNow(void) {
+    unsigned int a, b;
+    do {
+        a = TA0R;
+        b = TA0R;
+    } while(a != b);
+    return a;
+}
+
+// TA0R extended by the wraps (interrupts off)
+unsigned long Wheel_Now(void) {
+    unsigned int count = TimerNow();
+    unsigned int wraps = clock_wraps;
+    if((TA0CTL & TAIFG) && count < 0x8000) wraps++;     // Wrap not counted yet
+    return ((unsigned long)wraps << 16) | count;
+}
+
+// CCR0 matches on the low 16 bits. A deadline too close for the compare to
+// catch is raised by hand; one more than a wrap away matches early, and
+// Wheel_Run() finds nothing due and sets it again.
+void Wheel_Compare(unsigned long due) {
+    TA0CCR0 = (unsigned int)due;
+    if((long)(due - Wheel_Now()) < 2) TA0CCTL0 = CCIE | CCIFG;
+    else TA0CCTL0 = CCIE;
+}
+
+// Event stamps in ACLK ticks
+unsigned long Event_Now(void) {
+    return Wheel_Now();
+}
+
+#if LATENCY
+// 15625/512 us per ACLK tick, split so a long span cannot overflow
+unsigned long Latency_Us(unsigned long span) {
+    return (span >> 9) * 15625 + (((span & 0x1FF) * 15625) >> 9);
+}
+
+#define S3_STAMP()      s3_accept_time
+#endif
+
+#if TELEMETRY
+// Milliseconds since boot for a wheel time (125/4096 ms per ACLK tick)
+static unsigned long Stamp_ms(unsigned long ticks) {
+    return (ticks >> 16) * 2000 + (((ticks & 0xFFFF) * 125) >> 12);
+}
+
+// The same for now (interrupts off)
+static unsigned long Now_ms(void) {
+    return Stamp_ms(Wheel_Now());
+}
+#endif
+
+static void Tickless_Init(void) {
+#if TICKLESS_XT1
+    P5SEL |= 0x30;                              // P5.4=XIN, P5.5=XOUT
+    UCSCTL6 = (UCSCTL6 & ~XT1OFF) | XCAP_3;
+    do {                                        // Wait for the crystal to settle
+        UCSCTL7 &= ~(XT2OFFG | XT1LFOFFG | DCOFFG);
+        SFRIFG1 &= ~OFIFG;
+    } while(SFRIFG1 & OFIFG);
+    UCSCTL4 = (UCSCTL4 & ~SELA_7) | SELA__XT1CLK;
+#else
+    UCSCTL4 = (UCSCTL4 & ~SELA_7) | SELA__REFOCLK;
+#endif
+
+    // TA1 (the P1.7 reference from Initial) shares ACLK: keep it near 500 Hz
+    TA1CCR0 = MS_TO_TICKS(1) - 1;
+
+    TA0CTL = TASSEL_1 | MC_2 | TACLR | TAIE;    // ACLK, continuous, wraps extend the clock
+    Wheel_StartIn(&poll_timer, MS_TO_TICKS(TICKLESS_POLL_MS), 0);
+}
+
+// One S3 sample, taken at due. Returns 1 if main must wake.
+static unsigned char S3_Poll(unsigned long due) {
+    unsigned long next;
+    unsigned char wake = 0;
+    unsigned char s3_now = (ReadBus(SWITCHES_ADDR) & SWITCH_S3_BIT) ? 1 : 0;
+
+    if(s3_now != s3_raw) {
+        // New level (or a bounce back): restart the debounce from here
+        s3_raw = s3_now;
+        s3_edge_time = due;
+        debounce_counter = 0;
+    } else if(s3_raw != s3_debounced) {
+        debounce_counter += DEBOUNCE_STEP_MS;
+        if(debounce_counter >= DEBOUNCE_MS) {
+            s3_debounced = s3_raw;
+            s3_accept_time = s3_edge_time;
+            TELEMETRY_EVENT(s3_debounced ? TEL_S3_ON : TEL_S3_OFF, 0, Stamp_ms(s3_edge_time));
+            Event_Post(EV_SWITCH);              // D7 follows in main
+            wake = 1;
         }
     }
-    
-    // Blink logic
-    if(alarm_on) {
-        blink_count++;
-        if(blink_count >= BLINK_MS) {
-            blink_count = 0;
-            leds ^= LED_D0;  // Toggle D0 in the ISR itself
-            flag_blink = 1;
-            __bic_SR_register_on_exit(LPM0_bits);
-        }
+
+    // Sample at the debounce rate only while a change is pending
+    if(s3_raw != s3_debounced) next = due + MS_TO_TICKS(DEBOUNCE_STEP_MS);
+    else next = due + MS_TO_TICKS(TICKLESS_POLL_MS);
+    // Held off past the next sample (flash erase): resume from now
+    if((long)(next - Wheel_Now()) <= 0) next = Wheel_Now() + MS_TO_TICKS(DEBOUNCE_STEP_MS);
+    Wheel_Start(&poll_timer, next, 0);
+    return wake;
+}
+
+// S3 poll and LCD link watchdog
+static unsigned char Poll_Expired(unsigned long due) {
+    unsigned char wake = S3_Poll(due);
+    if(I2C_Watchdog(TICKLESS_POLL_MS)) wake = 1;    // Debounce polls only shorten the rest
+    return wake;
+}
+
+// CCR0: the wheel's earliest deadline
+#pragma vector = TIMER0_A0_VECTOR
+__interrupt void Timer_ISR(void) {
+    unsigned int latency = TimerNow() - TA0CCR0;
+    if((short)latency >= 0 && latency > timer_latency_max) timer_latency_max = latency;   // Not raised early by hand
+
+    if(Wheel_Run()) WAKE_MAIN();
+}
+
+// TA0IFG: the counter wrapped (every 2 s)
+#pragma vector = TIMER0_A1_VECTOR
+__interrupt void TimerWrap_ISR(void) {
+    switch(__even_in_range(TA0IV, 14)) {
+    case 14:
+        clock_wraps++;
+        break;
+    default:
+        break;
+    }
+}
+#endif
+
+/* ========================= Timer Expiry (timer ISR) ========================= */
+#if MULTI_CHANNEL
+// The earliest channel second: main advances the channels and arms the next
+static unsigned char Second_Expired(unsigned long due) {
+    Event_Post(EV_SECOND);
+    return 1;
+}
+
+// Blink half-period, kept running so every alarm LED blinks in step
+static unsigned char Blink_Expired(unsigned long due) {
+    blink_dark ^= 0xFF;
+    if(!channels_alarm) return 0;
+    Event_Post(EV_BLINK);
+    return 1;
+}
+
+// All the switches at once, the same few operations for any number of them
+static unsigned char Sample_Expired(unsigned long due) {
+    unsigned char changed = Debounce8_Sample(&switch_debounce, (unsigned char)ReadBus(SWITCHES_ADDR));
+
+    if(!changed) return 0;
+    switches_changed |= changed;
+    switches_changed_ms = due;
+    Event_Post(EV_SWITCH);
+    return 1;
+}
+#else
+// One second has elapsed since the last tick (or since the run started)
+static unsigned char Second_Expired(unsigned long due) {
+    second_time = due;
+    elapsed_prev = elapsed;
+    elapsed = Bcd_Tick(elapsed_prev);
+#if TICKLESS
+    tick_counted = 1;
+#if S3_TIMESTAMP
+    run_seconds++;
+#endif
+    TELEMETRY_EVENT(TEL_SECOND, Bcd_Seconds(elapsed), Stamp_ms(second_time));
+#else
+    TELEMETRY_EVENT(TEL_SECOND, Bcd_Seconds(elapsed), second_time);
+#endif
+    Event_Post(EV_SECOND);
+    return 1;
+}
+
+static unsigned char Blink_Expired(unsigned long due) {
+    Event_Post(EV_BLINK);                       // Main toggles D0
+    return 1;
+}
+#endif
+
+static unsigned char Key_Expired(unsigned long due) {
+#if KEYPAD_POLL
+    return Keypad_Poll();
+#else
+    return Keypad_Deadline();
+#endif
+}
+
+// Start or stop the D0 alarm blink
+static void SetAlarm(unsigned char on) {
+#if TELEMETRY
+    if(on != alarm_on) {
+        // Main is not the ring's only producer: keep the ISRs out while writing
+        __istate_t state = __get_interrupt_state();
+        __disable_interrupt();
+        Telemetry_Event(on ? TEL_ALARM_ON : TEL_ALARM_OFF, Bcd_Seconds(elapsed), Now_ms());
+        __set_interrupt_state(state);
+    }
+#endif
+    alarm_on = on;
+    if(on) {
+        session_alarm = 1;
+        leds &= ~LED_D0;  // D0 ON (ACTIVE-LOW: clear bit = 0)
     } else {
-        // Ensure D0 is OFF when alarm is not active
-        leds |= LED_D0;
+        leds |= LED_D0;   // D0 OFF (ACTIVE-LOW: set bit = 1)
     }
-    
-    // Always update LEDs to keep D7 in sync (and now D0 blink)
+    if(on) Wheel_StartIn(&blink_timer, MS_TO_TICKS(BLINK_MS), MS_TO_TICKS(BLINK_MS));
+    else Wheel_Cancel(&blink_timer);
     UpdateLEDs();
 }
 
-/* ========================= Keypad ISR ========================= */
+/* ========================= Keypad =========================
+ * A key press or release is queued in the keypad FIFO (keypad.c), where it
+ * waits until the main loop runs the threshold entry, so keys typed while
+ * main is busy are kept. Two variants, chosen by KEYPAD_POLL:
+ *
+ * Interrupt (KEYPAD_POLL=0), a timer-driven state machine with no delay loops:
+ *   KEY_IDLE          P2.0 rising edge -> port ISR arms KEY_PRESS_MS
+ *   KEY_PRESS_WAIT    deadline: P2.0 still high -> read the scan code, queue
+ *                     the press, flip P2IES to the falling edge
+ *   KEY_DOWN          P2.0 falling edge -> port ISR arms KEY_RELEASE_MS
+ *   KEY_RELEASE_WAIT  deadline: P2.0 still low -> queue the release, back to
+ *                     the rising edge; P2.0 high again with a different scan
+ *                     code -> the next key was pressed before this one came
+ *                     up (rollover): queue both
+ * The port interrupt stays masked while a deadline is pending, so bounces
+ * cost nothing.
+ *
+ * Polled (KEYPAD_POLL=1): no port interrupt. The timer samples P2.0 (and the
+ * scan code while it is high) every KEY_POLL_MS, and a sample that matches
+ * the one before and differs from the key held is a release, a press, or both.
+ */
+// A key went down: queue it. Returns 1 if main must wake.
+static unsigned char Keypad_Pressed(unsigned char key) {
+    key_held = key;
+    if(key == KEY_NONE || !Keypad_Push(key)) return 0;
+#if LATENCY
+    key_press_stamp = key_edge_stamp;
+#endif
+    Event_Post(EV_KEY);
+    return 1;
+}
+
+static void Keypad_Released(void) {
+    if(key_held != KEY_NONE) Keypad_Push(key_held | KEY_RELEASED);
+    key_held = KEY_NONE;
+}
+
+#if KEYPAD_POLL
+// One keypad sample, from the timer every KEY_POLL_MS. Returns 1 if main must wake.
+static unsigned char Keypad_Poll(void) {
+    unsigned char key = KEY_NONE, wake = 0;
+    PROF_ENTER(PROF_KEY_SCAN);
+
+    if(P2IN & KEYPAD_DA) key = Keypad_Decode((unsigned char)ReadBus(KEYPAD_ADDR));
+    if(key != key_sample) KEY_EDGE_STAMP();     // First sample of a new key
+    if(key == key_sample && key != key_held) {  // Held for two samples: settled
+        Keypad_Released();
+        wake = Keypad_Pressed(key);
+    }
+    key_sample = key;
+
+    PROF_EXIT(PROF_KEY_SCAN);
+    return wake;
+}
+
+#else
+static void Keypad_Arm(unsigned char ms) {
+    P2IE &= ~KEYPAD_DA;
+    Wheel_StartIn(&key_timer, MS_TO_TICKS(ms), 0);
+}
+
+// Wait for the edge selected in P2IES. Changing P2IES can raise P2IFG by
+// itself, and the level may already have moved, so check it by hand.
+static void Keypad_Listen(unsigned char falling) {
+    if(falling) P2IES |= KEYPAD_DA;
+    else P2IES &= ~KEYPAD_DA;
+    P2IFG &= ~KEYPAD_DA;
+
+    if(((P2IN & KEYPAD_DA) != 0) == falling) {
+        P2IE |= KEYPAD_DA;
+    } else if(falling) {
+        key_state = KEY_RELEASE_WAIT;       // Released already
+        Keypad_Arm(KEY_RELEASE_MS);
+    } else {
+        key_state = KEY_PRESS_WAIT;         // Pressed again already
+        KEY_EDGE_STAMP();
+        Keypad_Arm(KEY_PRESS_MS);
+    }
+}
+
+// Runs from the timer ISR when the armed deadline expires. Returns 1 if main must wake.
+static unsigned char Keypad_Deadline(void) {
+    unsigned char held = (P2IN & KEYPAD_DA) ? 1 : 0;
+    unsigned char wake = 0;
+    PROF_ENTER(PROF_KEY_SCAN);
+
+    if(key_state == KEY_PRESS_WAIT) {
+        if(held) {
+            wake = Keypad_Pressed(Keypad_Decode((unsigned char)ReadBus(KEYPAD_ADDR)));
+            key_state = KEY_DOWN;
+            Keypad_Listen(1);
+        } else {                            // Glitch: no key after all
+            key_state = KEY_IDLE;
+            Keypad_Listen(0);
+        }
+    }
+    else if(key_state == KEY_RELEASE_WAIT) {
+        if(held) {                          // Bounce, or the next key already
+            unsigned char key = Keypad_Decode((unsigned char)ReadBus(KEYPAD_ADDR));
+            if(key != key_held) {
+                KEY_EDGE_STAMP();           // Its edge fell inside the release wait: now is its first sample
+                Keypad_Released();
+                wake = Keypad_Pressed(key);
+            }
+            key_state = KEY_DOWN;
+            Keypad_Listen(1);
+        } else {
+            Keypad_Released();
+            key_state = KEY_IDLE;
+            Keypad_Listen(0);
+        }
+    }
+
+    PROF_EXIT(PROF_KEY_SCAN);
+    return wake;
+}
+
 #pragma vector = PORT2_VECTOR
 __interrupt void Keypad_ISR(void) {
-    // Clear interrupt flag first
-    P2IFG &= ~0x01;
+    PROF_ENTER(PROF_KEYPAD_ISR);
+    P2IFG &= ~KEYPAD_DA;
+
+    if(key_state == KEY_IDLE) {
+        key_state = KEY_PRESS_WAIT;
+        KEY_EDGE_STAMP();
+        Keypad_Arm(KEY_PRESS_MS);
+    }
+    else if(key_state == KEY_DOWN) {
+        key_state = KEY_RELEASE_WAIT;
+        Keypad_Arm(KEY_RELEASE_MS);
+    }
+    PROF_EXIT(PROF_KEYPAD_ISR);
+}
+#endif
+
+/* ========================= Threshold Entry (main loop) ========================= */
+// value: the digits as typed, mm:ss with up to 99 in the seconds field
+static void SetThreshold(unsigned int value) {
+    if((value & 0xFF) >= 0x60) {        // 01:90 -> 02:30, 99:60 and up -> 99:59
+        value = (value >= 0x9900) ? BCD_MMSS_MAX : __bcd_add_short(value, 0x0040);
+    }
+    if(value == 0) value = 0x0001;      // Minimum 1 second
+#if MULTI_CHANNEL
+    channels[channel_page].threshold = value;
+    digit_count = 0;                    // Back to the channel page
+    digit_entry = 0;
+#else
+    threshold = value;
+    entry_done = 1;
+#endif
+    Store_AddThreshold(value);
+#if TELEMETRY
+    {
+        // Main is not the ring's only producer: keep the ISRs out while writing
+        __istate_t state = __get_interrupt_state();
+        __disable_interrupt();
+        Telemetry_Event(TEL_THRESHOLD, Bcd_Seconds(value), Now_ms());
+        __set_interrupt_state(state);
+    }
+#endif
+}
+
+// Digits shift in from the right as mm:ss; Enter takes what is there and the
+// fourth digit sets it. Backspace and Clear step back. A complete threshold
+// ignores further digits.
+static void Keypad_Key(unsigned char key) {
+#if PROFILE
+    if(key == KEY_PROF_NEXT) {
+        prof_page = (prof_page % (2 * PROF_COUNT)) + 1;
+        Event_Post(EV_LCD_STATUS);
+        return;
+    }
+    if(key == KEY_PROF_CLOSE) {
+        prof_page = 0;
+        Event_Post(EV_LCD_STATUS);
+        return;
+    }
+#endif
+#if STACK_CHECK && !PROFILE
+    if(key == KEY_STACK) {
+        stack_view = 1;
+        Event_Post(EV_LCD_STATUS);
+        return;
+    }
+    if(stack_view) {                    // Any other key closes the view
+        stack_view = 0;
+        Event_Post(EV_LCD_STATUS);
+    }
+#endif
+#if LATENCY && !PROFILE
+    if(key == KEY_LATENCY) {            // Next path; after the last, the normal display
+        lat_page = (lat_page + 1) % (LAT_COUNT + 1);
+        Event_Post(EV_LCD_STATUS);
+        return;
+    }
+    if(lat_page) {                      // Any other key closes the page
+        lat_page = 0;
+        Event_Post(EV_LCD_STATUS);
+    }
+#endif
+#if MULTI_CHANNEL
+    if(key == KEY_CHANNEL_NEXT) {       // Next channel; an entry in progress is dropped
+        channel_page = (channel_page + 1) & (CHANNEL_COUNT - 1);
+        digit_count = 0;
+        digit_entry = 0;
+        UpdateDisplay(channels[channel_page].elapsed);
+        Event_Post(EV_LCD_STATUS);
+        return;
+    }
+#endif
+
+    if(key < 10) {
+        if(entry_done) return;
+        digit_entry = (digit_entry << 4) | key;
+        if(++digit_count == ENTRY_DIGITS) SetThreshold(digit_entry);
+    } else if(key == KEY_ENTER && digit_count && !entry_done) {
+        SetThreshold(digit_entry);
+    } else if(key == KEY_BACKSPACE && digit_count) {
+        entry_done = 0;
+        digit_entry >>= 4;
+        digit_count--;
+    } else if(key == KEY_CLEAR && digit_count) {
+        entry_done = 0;
+        digit_entry = 0;
+        digit_count = 0;
+    } else {
+        return;
+    }
+#if LATENCY
+    __disable_interrupt();
+    Latency_Input(LAT_BIT(LAT_KEY_LCD), key_press_stamp);
+    __enable_interrupt();
+#endif
+    Event_Post(EV_LCD_STATUS);
+}
+
+// Everything the keypad queued since the last pass; releases need no action
+static void Keypad_Service(void) {
+    unsigned char event;
+
+    while((event = Keypad_Pop()) != KEY_NONE) {
+        if(!(event & KEY_RELEASED)) Keypad_Key(event);
+    }
+}
+
+#if MULTI_CHANNEL
+/* ========================= Channels (main loop) ========================= */
+// Dn on while switch n is on, dark in the off half of the blink while its
+// alarm is on
+static void Channels_Leds(void) {
+    leds = ~(switch_debounce.state & ~(channels_alarm & blink_dark));    // ACTIVE-LOW
+    UpdateLEDs();
+}
+
+// The second timer follows the earliest running channel
+static void Channels_Arm(void) {
+    if(channels_running) Wheel_Start(&second_timer, channels_next_due, 0);
+    else Wheel_Cancel(&second_timer);
+}
+
+// Switches the tick has debounced since the last pass start or stop their
+// channels; a stopped channel keeps its time on the displays and is logged
+static void Channels_Switched(void) {
+    unsigned char changed, on, n, bit;
+    unsigned long when;
     
-    // Debounce delay
-    for(volatile unsigned int i = 0; i < 5000; i++);
+    __disable_interrupt();
+    changed = switches_changed;
+    switches_changed = 0;
+    when = switches_changed_ms;
+    on = switch_debounce.state;
+    __enable_interrupt();
     
-    // Read keypad
-    BusAddress = KEYPAD_ADDR;
-    BusRead();
-    unsigned char scan = (unsigned char)BusData;
+    for(n = 0, bit = 1; n < CHANNEL_COUNT; n++, bit <<= 1) {
+        if((changed & channels_running & bit) && !(on & bit)) {
+            Store_AddSession(Bcd_Seconds(channels[n].elapsed) * 100UL, channels[n].threshold,
+                             (channels_alarm & bit) != 0);
+        }
+    }
+    Channels_Stop(changed & ~on);
+    Channels_Start(changed & on, when);
+    Channels_Arm();
+    Channels_Leds();
+    
+    if(changed & (1 << channel_page)) {
+        UpdateDisplay(channels[channel_page].elapsed);
+        Event_Post(EV_LCD_TIMING);
+    }
+}
+
+// One or more channel seconds fell: advance them and redraw if the shown one moved
+static void Channels_Second(void) {
+    unsigned long now;
     
-    // Ignore if no key pressed (scan = 0)
-    if(scan == 0) return;
+    __disable_interrupt();
+    now = ms_ticks;
+    __enable_interrupt();
     
-    // Find matching digit (0-9 only, ignore other keys)
-    unsigned char digit;
-    unsigned char valid = 0;
-    for(digit = 0; digit < 10; digit++) {
-        if(scan == KeypadLookup[digit]) {
-            valid = 1;
-            break;
-        }
+    if(Channels_Due(now) & (1 << channel_page)) {
+        UpdateDisplay(channels[channel_page].elapsed);
+        Event_Post(EV_LCD_TIMING);
     }
+    Channels_Arm();
+    Channels_Leds();                    // An alarm may have gone on
+}
+#endif
+
+#if !MULTI_CHANNEL
+/* ========================= Timing (main loop) ========================= */
+// S3 changed: start or stop the run. D7 follows S3.
+static void Timing_Switched(void) {
+    if(s3_debounced) leds &= ~LED_D7;   // ACTIVE-LOW
+    else leds |= LED_D7;
+    UpdateLEDs();
+#if LATENCY
+    // D7, the digits and the LCD answer the edge from here
+    __disable_interrupt();
+    Latency_Input(LAT_BIT(LAT_S3_LED) | LAT_BIT(LAT_S3_SEG) | LAT_BIT(LAT_S3_LCD), S3_STAMP());
+    __enable_interrupt();
+#endif
     
-    if(valid) {
-        if(digit_count == 0) {
-            digit_buffer[0] = digit;
-            digit_count = 1;
-            lcd_refresh = 1;
-            __bic_SR_register_on_exit(LPM0_bits);
-        }
-        else if(digit_count == 1) {
-            digit_buffer[1] = digit;
-            threshold = digit_buffer[0] * 10 + digit_buffer[1];
-            if(threshold > 99) threshold = 99;
-            if(threshold == 0) threshold = 1;  // Minimum 1 second
-            digit_count = 2;
-            lcd_refresh = 1;
-            __bic_SR_register_on_exit(LPM0_bits);
+    // Rising edge - start timing
+    if(s3_debounced && !s3_last) {
+#if TICKLESS
+        // First second ends one second after S3 was first seen on
+        tick_counted = 0;
+        Wheel_Start(&second_timer, s3_accept_time + TICKS_PER_SECOND, TICKS_PER_SECOND);
+#if S3_TIMESTAMP
+        run_start_time = s3_accept_time;
+        run_seconds = 0;
+#endif
+#endif
+#if S3_TIMESTAMP && !TICKLESS
+        // Count from the first sample that saw S3 on, not from now
+        __disable_interrupt();
+        run_start_ms = s3_accept_ms;
+        run_start_sub = s3_accept_sub;
+        elapsed = 0;
+        elapsed_prev = 0;
+        timing = 1;
+        Wheel_Start(&second_timer, s3_accept_ms + TICKS_PER_SECOND, TICKS_PER_SECOND);
+        __enable_interrupt();
+#else
+        elapsed = 0;
+        elapsed_prev = 0;
+        timing = 1;
+#if !TICKLESS
+        Wheel_StartIn(&second_timer, TICKS_PER_SECOND, TICKS_PER_SECOND);
+#endif
+#endif
+        SetAlarm(0);
+        session_alarm = 0;
+        UpdateDisplay(0);
+        Event_Post(EV_LCD_TIMING);     // "Timing: 00:00"
+    }
+    // Falling edge - stop timing and reset for new threshold entry
+    else if(!s3_debounced && s3_last) {
+#if TICKLESS
+        // A tick that fell after S3 was first seen off is not part of the run
+        Wheel_Cancel(&second_timer);
+        if(tick_counted && (long)(second_time - s3_accept_time) > 0) {
+            elapsed = elapsed_prev;
+            UpdateDisplay(elapsed);
         }
-        // After 2 digits entered, ignore additional presses until reset
+        tick_counted = 0;
+        Event_Clear(EV_SECOND);
+#if S3_TIMESTAMP
+        if(run_seconds && (long)(second_time - s3_accept_time) > 0) run_seconds--;
+        // Ticks fall every 32768 counts from the start edge: the rest is the fraction
+        run_elapsed_us = (unsigned long)run_seconds * 1000000UL
+            + (((unsigned long)((s3_accept_time - run_start_time) & 0x7FFF) * 15625UL) >> 9);
+#endif
+#endif
+#if S3_TIMESTAMP && !TICKLESS
+        // A tick that fell while the stop was being debounced does not count
+        __disable_interrupt();
+        timing = 0;
+        Wheel_Cancel(&second_timer);
+        if((long)(second_time - s3_accept_ms) > 0) elapsed = elapsed_prev;
+        __enable_interrupt();
+        UpdateDisplay(elapsed);
+        run_elapsed_us = (s3_accept_ms - run_start_ms) * 1000UL;
+        run_elapsed_us += ((long)s3_accept_sub - (long)run_start_sub) * 1000L / (long)TICK_CYCLES;
+#else
+        timing = 0;
+#if !TICKLESS
+        Wheel_Cancel(&second_timer);
+#endif
+#endif
+        SetAlarm(0);
+        Event_Post(EV_LCD_TIMING);     // "Elapsed: mm:ss" + "Enter threshold:"
+        
+        // Log the run; it reaches flash once the loop sees timing stopped
+#if S3_TIMESTAMP
+        Store_AddSession(run_elapsed_us / 10000UL, threshold, session_alarm);
+#else
+        Store_AddSession(Bcd_Seconds(elapsed) * 100UL, threshold, session_alarm);
+#endif
+        
+#if RESET_ON_STOP
+        // Reset threshold entry for new input
+        digit_count = 0;
+        digit_entry = 0;
+        entry_done = 0;
+#endif
     }
     
-    // Additional debounce - wait for key release
-    for(volatile unsigned int i = 0; i < 10000; i++);
+    s3_last = s3_debounced;
 }
 
+// A second fell: seven-segment digits, then the threshold
+static void Timing_Second(void) {
+    UpdateDisplay(elapsed);
+    
+    // Check threshold (only while actively timing); the LED goes first
+    if(timing && elapsed >= threshold) {  // Packed BCD compares like binary
+        if(!alarm_on) SetAlarm(1);      // Threshold just reached or exceeded - start alarm
+    } else {
+        // Below threshold or not timing - ensure alarm is off
+        if(alarm_on) SetAlarm(0);
+    }
+    
+    // Current time (or "EXCEEDED! mm:ss") while timing
+    if(timing) Event_Post(EV_LCD_TIMING);
+}
+
+// Blink half-period: toggle D0 while the alarm is on
+static void Timing_Blink(void) {
+    if(!alarm_on) return;
+    leds ^= LED_D0;                     // ACTIVE-LOW
+    UpdateLEDs();
+}
+#endif
+
+/* ========================= Start-up ========================= */
+static void Timer_Init(void) {
+#if TICKLESS
+    Tickless_Init();
+#else
+    // Configure Timer A0 for 1ms tick (period derived from the clock profile)
+    TA0CCR0 = TICK_CYCLES - 1;
+    TA0CCTL0 = CCIE;
+    TA0CTL = TASSEL_2 | MC_1 | TACLR;
+#endif
+#if KEYPAD_POLL
+    Wheel_StartIn(&key_timer, MS_TO_TICKS(KEY_POLL_MS), MS_TO_TICKS(KEY_POLL_MS));
+#endif
+#if MULTI_CHANNEL
+    Wheel_StartIn(&sample_timer, CHANNEL_SAMPLE_MS, CHANNEL_SAMPLE_MS);
+    Wheel_StartIn(&blink_timer, BLINK_MS, BLINK_MS);
+#endif
+}
+
+static void Keypad_Init(void) {
+    Keypad_FifoInit();
+    
+    P2DIR &= ~KEYPAD_DA;  // Ensure P2.0 is input
+    P2REN &= ~KEYPAD_DA;  // Disable pull-up/down (external pull-up on keypad)
+#if !KEYPAD_POLL
+    // Configure keypad interrupt (P2.0)
+    P2IES &= ~KEYPAD_DA;  // Rising edge (key press)
+    P2IFG &= ~KEYPAD_DA;  // Clear any pending interrupts
+    P2IE  |= KEYPAD_DA;   // Enable interrupt
+#endif
+}
+
+static void Outputs_Init(void) {
+    BusOut_Init();
+    UpdateDisplay(0);
+    UpdateLEDs();
+    BusOut_Flush(BUS_OUT_ALL);
+}
+
+#if FAST_BOOT
+// TA1 counts since main started (TA1 runs up mode, one period per millisecond)
+static unsigned long Boot_Now(void) {
+    unsigned long ticks;
+    unsigned int count;
+#if TICKLESS
+    unsigned int again;
+#endif
+    __istate_t state = __get_interrupt_state();
+
+    __disable_interrupt();
+#if TICKLESS
+    do {                                // ACLK (REFO/XT1) is asynchronous to MCLK
+        count = TA1R;
+        again = TA1R;
+    } while(count != again);
+#else
+    count = TA1R;                       // ACLK is the DCO: two reads never match
+#endif
+    ticks = (unsigned long)boot_periods * (TA1CCR0 + 1) + count;
+    if((TA1CTL & TAIFG) && count < (TA1CCR0 >> 1)) ticks += TA1CCR0 + 1;   // Wrap not counted yet
+    __set_interrupt_state(state);
+    return ticks;
+}
+
+// First queue drain after the LCD is ready: the start-up frame is on screen
+static void Boot_Displayed(void) {
+    if(boot_ticks_display || !LCD_Ready()) return;
+    boot_ticks_display = Boot_Now();
+    TA1CTL &= ~TAIE;                    // Boot over: no more 1 ms wakeups
+}
+
+// TA1 period: drives the LCD bring-up until the start-up frame is out
+#pragma vector = TIMER1_A1_VECTOR
+__interrupt void Boot_ISR(void) {
+    switch(__even_in_range(TA1IV, 14)) {
+    case 14:                            // TA1IFG: one period
+        boot_periods++;
+        if(!LCD_Tick()) {               // LCD ready: main sends the held frame
+            Event_Post(EV_LCD_DONE);
+            WAKE_MAIN();
+        }
+        break;
+    default:
+        break;
+    }
+}
+#endif
+
+// LCD queue drained (runs in the I2C ISR)
+static void Display_Drained(void) {
+#if FAST_BOOT
+    Boot_Displayed();
+#endif
+#if LATENCY
+    Latency_LcdCheck();
+#endif
+    Event_Post(EV_LCD_DONE);
+}
+
+#if STACK_CHECK
+// The stack ran into the data below it, so nothing in RAM can be trusted:
+// every LED on, the fault on the LCD, and from here on no input is acted on
+// and nothing is logged until the board is reset
+static void Stack_Fault(void) {
+    stack_fault = 1;
+    leds = 0x00;                        // ACTIVE-LOW: all on
+    UpdateLEDs();
+    ShowScreen(SCREEN_STACK_FAULT);
+}
+#endif
+
+#if LATENCY
+// Main's flush wrote these outputs: their paths end. Paths whose output did
+// not change (the digits were 00 already) had nothing visible to wait for.
+static void Latency_Flushed(unsigned char written) {
+    unsigned char paths = 0;
+
+    if(written & BUS_OUT_LED) paths |= LAT_BIT(LAT_S3_LED);
+    if(written & BUS_OUT_SEG) paths |= LAT_BIT(LAT_S3_SEG);
+    __disable_interrupt();
+    Latency_Output(paths, Event_Now());
+    Latency_Drop(LAT_BIT(LAT_S3_LED) | LAT_BIT(LAT_S3_SEG));
+    __enable_interrupt();
+}
+#endif
+
 /* ========================= Main ========================= */
 void main(void) {
+    unsigned char event;
+
     Initial();  // Board initialization
+#if STACK_CHECK
+    Stack_Paint();                      // Before anything has used the stack below main
+#endif
+#if PROFILE
+    Prof_Init();
+#endif
+#if TELEMETRY
+    Telemetry_Init();
+#endif
+    Store_Init();
+    if(Store_LastThreshold()) threshold = Store_LastThreshold();
+#if MULTI_CHANNEL
+    Channels_Init(threshold);
+#endif
     
+#if FAST_BOOT
+    // Timer, keypad and outputs first; the LCD comes up in the background
+    Timer_Init();
+    TA1CTL |= TACLR | TAIE;             // Boot clock and LCD bring-up tick
+    LCD_Start();
+    LCD_SetDoneCallback(Display_Drained);
+    ShowScreen(SCREEN_BOOT);                // Held until ready
+    Keypad_Init();
+    Outputs_Init();
+    boot_ticks_outputs = Boot_Now();
+#else
     // Initialize LCD and show startup message
     LCD_Init();
+    LCD_SetDoneCallback(Display_Drained);
+    ShowScreen(SCREEN_BOOT);
+    
+    // LCD transfers are interrupt-driven, so interrupts must be on to send it
+    __bis_SR_register(GIE);
     
     // Small delay to see startup message
-    for(volatile unsigned int i = 0; i < 30000; i++);
+    __delay_cycles(CLOCK_CYCLES_US(13000));
     
     // Initialize displays
-    UpdateDisplay(0);
-    UpdateLEDs();
-    
-    // Configure keypad interrupt (P2.0)
-    P2DIR &= ~0x01;  // Ensure P2.0 is input
-    P2REN &= ~0x01;  // Disable pull-up/down (external pull-up on keypad)
-    P2IES &= ~0x01;  // Rising edge (key press)
-    P2IE  |= 0x01;   // Enable interrupt
-    P2IFG &= ~0x01;  // Clear any pending interrupts
-    
-    // Configure Timer A0 for 1ms tick (assuming 25MHz SMCLK)
-    TA0CCR0 = 25000 - 1;
-    TA0CCTL0 = CCIE;
-    TA0CTL = TASSEL_2 | MC_1 | TACLR;
+    Outputs_Init();
+    Keypad_Init();
+    Timer_Init();
+#endif
     
     __bis_SR_register(GIE);  // Enable interrupts
     
     // Main loop
     while(1) {
-        __bis_SR_register(LPM0_bits | GIE);  // Sleep until interrupt
-        
-        // Handle switch edge
-        if(flag_switch) {
-            flag_switch = 0;
-            
-            // Rising edge - start timing
-            if(s3_debounced && !s3_last) {
-                ms_count = 0;
-                seconds = 0;
-                timing = 1;
-                alarm_on = 0;
-                leds |= LED_D0;  // D0 OFF (ACTIVE-LOW: set bit = 1)
-                UpdateDisplay(0);
-                UpdateLCD_Timing();  // Show "Timing: 00 s"
-            }
-            // Falling edge - stop timing and reset for new threshold entry
-            else if(!s3_debounced && s3_last) {
-                timing = 0;
-                alarm_on = 0;
-                leds |= LED_D0;  // D0 OFF (ACTIVE-LOW: set bit = 1)
-                UpdateLCD_Timing();  // Show "Elapsed: xx s" + "Enter threshold:"
-                
-                // Reset threshold entry for new input
-                digit_count = 0;
-                digit_buffer[0] = 0;
-                digit_buffer[1] = 0;
-                // lcd_refresh will be set when user presses a key
-            }
-            
-            s3_last = s3_debounced;
+        // Sleep only when nothing is pending: the check and the sleep are one
+        // step, so a post in between wakes the LPM entry at once
+        __disable_interrupt();
+        if(!event_pending) {
+#if TICKLESS
+            // LPM3 stops SMCLK, which the LCD's I2C needs while a transfer is out
+            if(LCD_Busy()) __bis_SR_register(LPM0_bits | GIE);
+            else __bis_SR_register(LPM3_bits | GIE);
+#else
+            __bis_SR_register(LPM0_bits | GIE);  // Sleep until interrupt
+#endif
         }
+        __enable_interrupt();
         
-        // Handle second tick
-        if(flag_second) {
-            flag_second = 0;
-            UpdateDisplay(seconds);
-            
-            // Always update LCD with current time while timing
-            if(timing) {
-                UpdateLCD_Timing();  // This will update every second
-            }
-            
-            // Check threshold (only while actively timing)
-            if(timing && seconds >= threshold) {  // Changed from > to >=
-                if(!alarm_on) {
-                    // Threshold just reached or exceeded - start alarm
-                    alarm_on = 1;
-                    blink_count = 0;
-                    leds &= ~LED_D0;  // D0 ON (ACTIVE-LOW: clear bit = 0)
-                    UpdateLEDs();     // Apply immediately
-                    UpdateLCD_Timing();  // Show "EXCEEDED! xx s"
-                }
-            } else {
-                // Below threshold or not timing - ensure alarm is off
-                if(alarm_on) {
-                    alarm_on = 0;
-                    leds |= LED_D0;   // D0 OFF (ACTIVE-LOW: set bit = 1)
-                    UpdateLEDs();     // Apply immediately
-                }
-            }
+        // One event per pass, most urgent first. After a stack fault only the
+        // LCD transfer of the fault screen goes on.
+        event = Event_Take();
+        if(STACK_FAULTED() && event != EV_LCD_DONE) event = EVENT_NONE;
+        switch(event) {
+#if MULTI_CHANNEL
+        case EV_SWITCH:     Channels_Switched(); break;
+        case EV_SECOND:     Channels_Second(); break;
+        case EV_BLINK:      Channels_Leds(); break;
+#else
+        case EV_SWITCH:     Timing_Switched(); break;
+        case EV_SECOND:     Timing_Second(); break;
+        case EV_BLINK:      Timing_Blink(); break;
+#endif
+        case EV_KEY:        Keypad_Service(); break;
+        case EV_LCD_TIMING: UpdateLCD_Timing(); break;
+        case EV_LCD_STATUS:
+#if PROFILE
+            if(prof_page) ShowProfile();
+            else UpdateLCD_Status();
+#else
+            UpdateLCD_Status();
+#endif
+            break;
+        case EV_LCD_DONE:   LCD_Service(); break;   // Send frame changes that did not fit earlier
+        default:            break;
         }
         
-        // Handle blink event flag (for LCD update or other actions if needed)
-        if(flag_blink) {
-            flag_blink = 0;
-            // LED toggle already handled in ISR
-            // Could add additional actions here if needed
-        }
+#if STACK_CHECK
+        if(!stack_fault && !Stack_CanaryOk()) Stack_Fault();
+#endif
         
-        // Handle LCD update for threshold entry
-        if(lcd_refresh) {
-            lcd_refresh = 0;
-            UpdateLCD_Status();
-        }
+        // Program queued log records between sessions only, once nothing is
+        // waiting and the LCD has its screen: an erase holds the CPU, and with
+        // it the rest of the transfer
+#if MULTI_CHANNEL
+        if(!event_pending && !channels_running && !LCD_Busy() && !STACK_FAULTED()) Store_Service();
+#else
+        if(!event_pending && !timing && !LCD_Busy() && !STACK_FAULTED()) Store_Service();
+#endif
+        
+        // Commit the output changes made during this pass
+#if LATENCY
+        Latency_Flushed(BusOut_Flush(BUS_OUT_ALL));
+#else
+        BusOut_Flush(BUS_OUT_ALL);
+#endif
     }
 }
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include "msp430f5308.h"
+#include "intrinsics.h"
+#include "prof.h"
+
+#if PROFILE
+#include "clock.h"
+
+ProfStat prof_stats[PROF_COUNT];
+
+static unsigned int prof_overhead;              // Cycles between two back-to-back TA1R reads
+
+static const char * const prof_names[PROF_COUNT] = {
+    "TimerISR", "KeypdISR", "Key scan", "BusRead ",
+    "BusWrite", "UpdDisp ", "UpdLCD  "
+};
+
+void Prof_Init(void) {
+    unsigned char id;
+    unsigned int start, now;
+
+    for(id = 0; id < PROF_COUNT; id++) {
+        prof_stats[id].count = 0;
+        prof_stats[id].total = 0;
+        prof_stats[id].min = 0xFFFF;
+        prof_stats[id].max = 0;
+    }
+
+    // Calibrate: the cost of the stamp itself comes off every measurement
+    start = TA1R;
+    now = TA1R;
+    if(now < start) now += CLOCK_TICK_CYCLES;
+    prof_overhead = now - start;
+}
+
+void Prof_Exit(unsigned char id, unsigned int start) {
+    unsigned int now = TA1R;
+    unsigned int cycles;
+    ProfStat *stat = &prof_stats[id];
+    __istate_t state = __get_interrupt_state();
+
+    // TA1 wraps at CCR0, not at 0xFFFF
+    if(now < start) now += CLOCK_TICK_CYCLES;
+    cycles = now - start;
+    cycles = (cycles > prof_overhead) ? cycles - prof_overhead : 0;
+
+    // The same routine may be timed from main and from an ISR
+    __disable_interrupt();
+    stat->count++;
+    stat->total += cycles;
+    if(cycles < stat->min) stat->min = cycles;
+    if(cycles > stat->max) stat->max = cycles;
+    __set_interrupt_state(state);
+}
+
+// Right-aligned decimal, clipped to the field width
+static void Prof_Number(char *dst, unsigned char width, unsigned long value) {
+    while(width--) {
+        dst[width] = (value || width == 0) ? '0' + (char)(value % 10) : ' ';
+        value /= 10;
+    }
+}
+
+void Prof_Render(unsigned char id, unsigned char page, char *line1, char *line2) {
+    ProfStat stat;
+    unsigned char i;
+    __istate_t state = __get_interrupt_state();
+
+    __disable_interrupt();
+    stat = prof_stats[id];
+    __set_interrupt_state(state);
+
+    for(i = 0; i < 16; i++) {
+        line1[i] = ' ';
+        line2[i] = ' ';
+    }
+    for(i = 0; i < 8; i++) line1[i] = prof_names[id][i];
+
+    if(page == 0) {
+        // "TimerISR n123456" / "cyc   1234567890"
+        line1[8] = 'n';
+        Prof_Number(&line1[9], 7, stat.count);
+        line2[0] = 'c'; line2[1] = 'y'; line2[2] = 'c';
+        Prof_Number(&line2[4], 12, stat.total);
+    } else {
+        // "TimerISR a  1234" / "<12345  >12345  "
+        if(stat.count == 0) stat.min = 0;
+        line1[9] = 'a';
+        Prof_Number(&line1[10], 6, stat.count ? stat.total / stat.count : 0);
+        line2[0] = '<';
+        Prof_Number(&line2[1], 5, stat.min);
+        line2[8] = '>';
+        Prof_Number(&line2[9], 5, stat.max);
+    }
+}
+#endif
@@ -0,0 +1,48 @@
+#ifndef PROF_H
+#define PROF_H
+
+/* ========================= Cycle Profiler =========================
+ * Build with PROFILE=1 to time the routines below against TA1, which Initial
+ * runs in up mode from the DCO (one period = CLOCK_TICK_CYCLES = 1 ms). Each
+ * routine keeps a call count and min/max/total cycles; spans longer than one
+ * TA1 period alias. With PROFILE=0 PROF_ENTER/PROF_EXIT expand to nothing.
+ */
+#ifndef PROFILE
+#define PROFILE         0
+#endif
+
+enum {
+    PROF_TIMER_ISR,
+    PROF_KEYPAD_ISR,
+    PROF_KEY_SCAN,
+    PROF_BUS_READ,
+    PROF_BUS_WRITE,
+    PROF_UPDATE_DISPLAY,
+    PROF_UPDATE_LCD,
+    PROF_COUNT
+};
+
+#if PROFILE
+typedef struct {
+    unsigned long count;
+    unsigned long total;
+    unsigned int  min;
+    unsigned int  max;
+} ProfStat;
+
+extern ProfStat prof_stats[PROF_COUNT];
+
+void Prof_Init(void);
+void Prof_Exit(unsigned char id, unsigned int start);
+
+// Format one routine for the LCD: page 0 = count and total, page 1 = min/max/avg
+void Prof_Render(unsigned char id, unsigned char page, char *line1, char *line2);
+
+#define PROF_ENTER(id)  unsigned int prof_start_##id = TA1R
+#define PROF_EXIT(id)   Prof_Exit(id, prof_start_##id)
+#else
+#define PROF_ENTER(id)
+#define PROF_EXIT(id)
+#endif
+
+#endif
@@ -0,0 +1,41 @@
+#include "intrinsics.h"
+#include "stack.h"
+
+#if STACK_CHECK
+
+#pragma segment = "CSTACK"
+
+#define STACK_BOTTOM    ((unsigned short *)__segment_begin("CSTACK"))
+#define STACK_TOP       ((unsigned short *)__segment_end("CSTACK"))
+#define STACK_LIVE_GAP  4           // Words left alone below SP (Stack_Paint's own use)
+
+void Stack_Paint(void) {
+    unsigned short *word = STACK_BOTTOM;
+    unsigned short *live = (unsigned short *)__get_SP_register() - STACK_LIVE_GAP;
+    unsigned char n;
+
+    for(n = 0; n < STACK_CANARY_WORDS; n++) *word++ = STACK_CANARY;
+    while(word < live) *word++ = STACK_PAINT;
+}
+
+unsigned int Stack_HighWater(void) {
+    const unsigned short *word = STACK_BOTTOM + STACK_CANARY_WORDS;
+
+    while(word < STACK_TOP && *word == STACK_PAINT) word++;
+    return (unsigned int)(STACK_TOP - word) * sizeof *word;
+}
+
+unsigned int Stack_Size(void) {
+    return (unsigned int)(STACK_TOP - STACK_BOTTOM) * sizeof(unsigned short);
+}
+
+unsigned char Stack_CanaryOk(void) {
+    const unsigned short *word = STACK_BOTTOM;
+    unsigned char n;
+
+    for(n = 0; n < STACK_CANARY_WORDS; n++) {
+        if(word[n] != STACK_CANARY) return 0;
+    }
+    return 1;
+}
+#endif
@@ -0,0 +1,40 @@
+#ifndef STACK_H
+#define STACK_H
+
+/* ========================= Stack Monitor =========================
+ * Every ISR runs on main's stack, on top of whatever main is in the middle
+ * of, so the worst case is main's deepest call plus the deepest interrupt
+ * frames at that moment. Nothing in the build bounds that, so it is measured:
+ *
+ * Stack_Paint() fills the free part of CSTACK (below the live frames) with
+ * STACK_PAINT at boot. Whatever the stack has used since overwrote the paint,
+ * and Stack_HighWater() finds the deepest word that is no longer painted.
+ * The lowest STACK_CANARY_WORDS words hold STACK_CANARY instead: once
+ * anything has written them the stack ran past its segment into the data
+ * below, and Stack_CanaryOk() returns 0.
+ *
+ * Build with STACK_CHECK=0 to leave the monitor out.
+ */
+#ifndef STACK_CHECK
+#define STACK_CHECK     1
+#endif
+
+#define STACK_PAINT         0xA5A5
+#define STACK_CANARY        0x5AC3
+#define STACK_CANARY_WORDS  2
+
+#if STACK_CHECK
+// Boot, before interrupts are on
+void Stack_Paint(void);
+
+// Deepest stack use since Stack_Paint(), in bytes (scans the paint: main only)
+unsigned int Stack_HighWater(void);
+
+// CSTACK size in bytes, canary included
+unsigned int Stack_Size(void);
+
+// 0 = the stack overflowed into the canary
+unsigned char Stack_CanaryOk(void);
+#endif
+
+#endif
@@ -0,0 +1,193 @@
+#include "msp430f5308.h"
+#include "intrinsics.h"
+#include "store.h"
+
+/* ========================= Configuration ========================= */
+#ifndef STORE_BASE
+#define STORE_BASE      0x1800      // Info segment D; C and B follow
+#endif
+#define STORE_SEGMENTS  3
+#define STORE_SEG_SIZE  128
+#define STORE_MAGIC     0xC3A6      // Changes with the record layout: older logs read as blank
+#define STORE_PER_SEG   ((STORE_SEG_SIZE - sizeof(StoreHeader)) / sizeof(StoreRecord))
+#define STORE_PENDING   8           // RAM queue (records)
+
+typedef struct {
+    unsigned int magic;
+    unsigned int seq;
+} StoreHeader;
+
+typedef struct {
+    StoreHeader header;
+    StoreRecord records[(STORE_SEG_SIZE - sizeof(StoreHeader)) / sizeof(StoreRecord)];
+} StoreSegment;
+
+#define STORE_SEG(n)    ((StoreSegment *)(STORE_BASE + (n) * STORE_SEG_SIZE))
+
+/* ========================= State ========================= */
+static unsigned char store_seg;                 // Newest segment, 0xFF = log empty
+static unsigned char store_fill;                // Records in the newest segment
+static unsigned int  store_seq;                 // Its sequence number
+static unsigned int  store_threshold;           // Last threshold written or queued
+
+// Records waiting for Store_Service(); producers may be ISRs, so the queue
+// indices only change with interrupts masked
+static StoreRecord store_pending[STORE_PENDING];
+static volatile unsigned char store_count;
+volatile unsigned int store_dropped;
+
+/* ========================= Flash Access ========================= */
+// Interrupt vectors live in flash too: keep interrupts off while it is busy
+static void Flash_Erase(void *segment) {
+    __istate_t state = __get_interrupt_state();
+    __disable_interrupt();
+    FCTL3 = FWKEY;                  // Unlock (LOCKA stays set: segment A is safe)
+    FCTL1 = FWKEY | ERASE;
+    *(volatile unsigned char *)segment = 0;     // Dummy write starts the erase
+    FCTL1 = FWKEY;
+    FCTL3 = FWKEY | LOCK;
+    __set_interrupt_state(state);
+}
+
+static void Flash_Write(void *dst, const void *src, unsigned char words) {
+    volatile unsigned int *to = (volatile unsigned int *)dst;
+    const unsigned int *from = (const unsigned int *)src;
+    __istate_t state = __get_interrupt_state();
+
+    __disable_interrupt();
+    FCTL3 = FWKEY;
+    FCTL1 = FWKEY | WRT;
+    while(words--) *to++ = *from++;
+    FCTL1 = FWKEY;
+    FCTL3 = FWKEY | LOCK;
+    __set_interrupt_state(state);
+}
+
+static unsigned char Store_Valid(const StoreRecord *record) {
+    return record->flags != 0xFF;
+}
+
+/* ========================= Public Interface ========================= */
+void Store_Init(void) {
+    unsigned char n, lo, hi, mid;
+    StoreSegment *segment;
+    const StoreRecord *last;
+
+    store_seg = 0xFF;                   // No segment found yet
+
+    // Newest segment: the valid header with the highest sequence number
+    for(n = 0; n < STORE_SEGMENTS; n++) {
+        segment = STORE_SEG(n);
+        if(segment->header.magic != STORE_MAGIC) continue;
+        if(store_seg == 0xFF || (int)(segment->header.seq - store_seq) > 0) {
+            store_seg = n;
+            store_seq = segment->header.seq;
+        }
+    }
+    if(store_seg == 0xFF) return;
+
+    // Records are appended in order: binary search for the first erased slot
+    segment = STORE_SEG(store_seg);
+    lo = 0;
+    hi = STORE_PER_SEG;
+    while(lo < hi) {
+        mid = (lo + hi) >> 1;
+        if(Store_Valid(&segment->records[mid])) lo = mid + 1;
+        else hi = mid;
+    }
+    store_fill = lo;
+
+    // Last record: here, or at the end of the previous segment if this one was
+    // opened just before a reset
+    if(store_fill) {
+        last = &segment->records[store_fill - 1];
+    } else {
+        segment = STORE_SEG((store_seg + STORE_SEGMENTS - 1) % STORE_SEGMENTS);
+        if(segment->header.magic != STORE_MAGIC || segment->header.seq != store_seq - 1) return;
+        last = &segment->records[STORE_PER_SEG - 1];
+    }
+    if(Store_Valid(last)) store_threshold = last->threshold;
+}
+
+unsigned int Store_LastThreshold(void) {
+    return store_threshold;
+}
+
+static void Store_Queue(unsigned long elapsed_cs, unsigned int threshold, unsigned char flags) {
+    __istate_t state = __get_interrupt_state();
+
+    __disable_interrupt();
+    store_threshold = threshold;
+    if(store_count < STORE_PENDING) {
+        store_pending[store_count].elapsed_cs = elapsed_cs;
+        store_pending[store_count].threshold = threshold;
+        store_pending[store_count].reserved = 0xFF;
+        store_pending[store_count].flags = flags;
+        store_count++;
+    } else {
+        store_dropped++;
+    }
+    __set_interrupt_state(state);
+}
+
+void Store_AddSession(unsigned long elapsed_cs, unsigned int threshold, unsigned char alarm) {
+    Store_Queue(elapsed_cs, threshold, STORE_SESSION | (alarm ? STORE_ALARM : 0));
+}
+
+void Store_AddThreshold(unsigned int threshold) {
+    Store_Queue(0, threshold, 0);
+}
+
+void Store_Service(void) {
+    StoreHeader header;
+    StoreRecord record;
+    unsigned char i = 0, n;
+    __istate_t state;
+
+    while(i < store_count) {
+        // Newest segment full (or no log yet): erase the oldest and reopen it
+        if(store_seg == 0xFF || store_fill >= STORE_PER_SEG) {
+            store_seg = (store_seg == 0xFF) ? 0 : (store_seg + 1) % STORE_SEGMENTS;
+            store_seq++;
+            header.magic = STORE_MAGIC;
+            header.seq = store_seq;
+            Flash_Erase(STORE_SEG(store_seg));
+            Flash_Write(&STORE_SEG(store_seg)->header, &header, sizeof header / sizeof(unsigned int));
+            store_fill = 0;
+        }
+
+        record = store_pending[i++];
+        Flash_Write(&STORE_SEG(store_seg)->records[store_fill], &record, sizeof record / sizeof(unsigned int));
+        store_fill++;
+    }
+
+    // Drop what was written; an ISR may have queued more meanwhile
+    state = __get_interrupt_state();
+    __disable_interrupt();
+    store_count -= i;
+    for(n = 0; n < store_count; n++) store_pending[n] = store_pending[n + i];
+    __set_interrupt_state(state);
+}
+
+unsigned char Store_Read(unsigned int back, StoreRecord *record) {
+    unsigned char seg = store_seg;
+    unsigned int fill = store_fill;
+    unsigned int seq = store_seq;
+    unsigned char n;
+
+    if(seg == 0xFF) return 0;
+
+    // Walk back segment by segment while the sequence numbers stay contiguous
+    for(n = 0; n < STORE_SEGMENTS; n++) {
+        if(back < fill) {
+            *record = STORE_SEG(seg)->records[fill - 1 - back];
+            return Store_Valid(record);
+        }
+        back -= fill;
+        seg = (seg + STORE_SEGMENTS - 1) % STORE_SEGMENTS;
+        seq--;
+        if(STORE_SEG(seg)->header.magic != STORE_MAGIC || STORE_SEG(seg)->header.seq != seq) return 0;
+        fill = STORE_PER_SEG;
+    }
+    return 0;
+}
@@ -0,0 +1,44 @@
+#ifndef STORE_H
+#define STORE_H
+
+/* ========================= Persistent Session Log (info flash) =========================
+ * Info segments D, C and B (3 x 128 bytes at 0x1800) form a ring of log
+ * segments. Each starts with a header (magic + sequence number) followed by
+ * up to 15 eight-byte records, appended in order; when the newest segment is
+ * full the oldest one is erased and reopened with the next sequence number,
+ * so every segment is erased equally often. Segment A is left alone.
+ *
+ * Records are queued in RAM and only programmed by Store_Service(), which the
+ * main loop calls while no session is running: an erase (~25 ms with the CPU
+ * held) or a program never lands inside a timing session.
+ *
+ * Store_Init() finds the newest segment from the three headers and its fill
+ * level by binary search, so the last threshold is restored in a fixed number
+ * of reads however much history there is.
+ */
+typedef struct {
+    unsigned long elapsed_cs;       // Session length in 1/100 s
+    unsigned int  threshold;        // Threshold in force (packed BCD mm:ss, see bcd.h)
+    unsigned char reserved;         // 0xFF
+    unsigned char flags;            // STORE_* below; never 0xFF, which marks erased flash
+} StoreRecord;
+
+#define STORE_ALARM     0x01        // Alarm fired during the session
+#define STORE_SESSION   0x02        // A timing session (otherwise a threshold change only)
+
+void Store_Init(void);
+
+// Last threshold in the log (packed BCD mm:ss), or 0 if the log is empty
+unsigned int Store_LastThreshold(void);
+
+// Queue a record (main or ISR); nothing touches flash until Store_Service()
+void Store_AddSession(unsigned long elapsed_cs, unsigned int threshold, unsigned char alarm);
+void Store_AddThreshold(unsigned int threshold);
+
+// Program all queued records in one batch. Call only outside a timing session.
+void Store_Service(void);
+
+// History, newest first (back = 0). Returns 0 past the oldest record.
+unsigned char Store_Read(unsigned int back, StoreRecord *record);
+
+#endif
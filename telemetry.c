@@ -0,0 +1,116 @@
+#include "msp430f5308.h"
+#include "intrinsics.h"
+#include "telemetry.h"
+
+#if TELEMETRY
+#include "clock.h"
+
+/* ========================= Configuration ========================= */
+#define TEL_BAUD        115200
+#define TEL_RING_SIZE   128         // 12 records (must be a power of two)
+#define TEL_RING_MASK   (TEL_RING_SIZE - 1)
+#define TEL_DMA_TRIGGER 17          // DMA0TSEL: UCA0TXIFG
+
+// Low-frequency baud generation (UCOS16 = 0), so 1 MHz still reaches 115200
+#define TEL_BR          ((unsigned int)(CLOCK_HZ_ACTUAL / TEL_BAUD))
+#define TEL_BRS         ((unsigned char)((CLOCK_HZ_ACTUAL * 8 + TEL_BAUD / 2) / TEL_BAUD - TEL_BR * 8L))
+
+/* ========================= Event Ring ========================= */
+// The producer owns tel_head, the DMA completion ISR owns tel_tail. tel_dma_len
+// is the stretch the DMA is moving right now (0 = idle).
+static unsigned char tel_ring[TEL_RING_SIZE];
+static volatile unsigned char tel_head;
+static volatile unsigned char tel_tail;
+static volatile unsigned char tel_dma_len;
+static unsigned char tel_seq;
+
+volatile unsigned int telem_dropped;
+
+// Start the DMA on the next contiguous stretch, if it is idle and there is one
+static void Telemetry_Kick(void) {
+    unsigned char len;
+
+    if(tel_dma_len || tel_head == tel_tail) return;
+
+    // Up to the head, or up to the end of the ring if the data wraps
+    len = (tel_head > tel_tail) ? tel_head - tel_tail : TEL_RING_SIZE - tel_tail;
+    tel_dma_len = len;
+
+    __data16_write_addr((unsigned short)&DMA0SA, (unsigned long)&tel_ring[tel_tail]);
+    DMA0SZ = len;
+    DMA0CTL = DMADT_0 | DMASRCINCR_3 | DMASBDB | DMAIE | DMAEN;
+
+    // The trigger is the rising edge of UCTXIFG: make one if the UART is idle
+    if(UCA0IFG & UCTXIFG) {
+        UCA0IFG &= ~UCTXIFG;
+        UCA0IFG |= UCTXIFG;
+    }
+}
+
+void Telemetry_Init(void) {
+    tel_head = 0;
+    tel_tail = 0;
+    tel_dma_len = 0;
+    tel_seq = 0;
+    telem_dropped = 0;
+
+    // UART: SMCLK, 8N1
+    UCA0CTL1 |= UCSWRST;
+    UCA0CTL0 = 0;
+    UCA0CTL1 = UCSSEL_2 | UCSWRST;
+    UCA0BR0 = TEL_BR & 0xFF;
+    UCA0BR1 = TEL_BR >> 8;
+    UCA0MCTL = TEL_BRS << 1;        // UCBRSx
+    P3SEL |= 0x08;                  // P3.3 = UCA0TXD
+    UCA0CTL1 &= ~UCSWRST;
+
+    // DMA channel 0: ring -> UCA0TXBUF, one byte per TX trigger
+    DMA0CTL = 0;
+    DMACTL0 = (DMACTL0 & 0xFF00) | TEL_DMA_TRIGGER;
+    __data16_write_addr((unsigned short)&DMA0DA, (unsigned long)&UCA0TXBUF);
+
+    Telemetry_Event(TEL_BOOT, 0, 0);
+}
+
+// Records do not divide the ring: each byte is placed modulo its size
+#define TEL_PUT(n, byte)    tel_ring[(head + (n)) & TEL_RING_MASK] = (unsigned char)(byte)
+
+void Telemetry_Event(unsigned char type, unsigned long value, unsigned long time_ms) {
+    unsigned char head = tel_head;
+    unsigned char seq = tel_seq++;
+
+    // Full: drop the record, the gap in seq tells the host
+    if(((tel_tail - head - 1) & TEL_RING_MASK) < TEL_RECORD_LEN) {
+        telem_dropped++;
+        return;
+    }
+
+    TEL_PUT(0, TEL_SYNC);
+    TEL_PUT(1, seq);
+    TEL_PUT(2, type);
+    TEL_PUT(3, value);
+    TEL_PUT(4, value >> 8);
+    TEL_PUT(5, value >> 16);
+    TEL_PUT(6, time_ms);
+    TEL_PUT(7, time_ms >> 8);
+    TEL_PUT(8, time_ms >> 16);
+    TEL_PUT(9, time_ms >> 24);
+    tel_head = (head + TEL_RECORD_LEN) & TEL_RING_MASK;    // Publish
+
+    Telemetry_Kick();
+}
+
+/* ========================= DMA ISR (stretch done) ========================= */
+#pragma vector = DMA_VECTOR
+__interrupt void Telemetry_DMA_ISR(void) {
+    switch(__even_in_range(DMAIV, 16)) {
+    case 2:                                     // DMA0IFG
+        tel_tail = (tel_tail + tel_dma_len) & TEL_RING_MASK;
+        tel_dma_len = 0;
+        Telemetry_Kick();
+        break;
+    default:
+        break;
+    }
+}
+#endif
@@ -0,0 +1,49 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+/* ========================= UART Telemetry (USCI_A0) =========================
+ * Timing events are streamed as fixed 10-byte records on P3.3 (UCA0TXD),
+ * 115200 8N1, multi-byte fields little endian:
+ *
+ *   0      1      2      3..5                 6..9
+ *   0xA5   seq    type   value (24 bits)      time (ms since boot)
+ *
+ * seq counts every event produced, including the ones dropped because the
+ * ring was full, so a gap in seq on the host means lost events.
+ *
+ * Producers: Telemetry_Event() must run with interrupts off (any ISR, or main
+ * inside a critical section), so the ring only ever has one writer at a time
+ * and needs no lock. The DMA controller is the consumer: it moves each
+ * contiguous stretch of the ring into UCA0TXBUF on the TX trigger, and its
+ * completion interrupt starts the next stretch. The CPU touches no bytes.
+ * host/telemetry_decode.c turns a capture into CSV.
+ */
+#ifndef TELEMETRY
+#define TELEMETRY       0
+#endif
+
+#define TEL_SYNC        0xA5
+#define TEL_RECORD_LEN  10
+
+// Event types (record byte 2) and their value. Times are whole seconds,
+// which 24 bits hold up to 99:59:59 and beyond.
+#define TEL_BOOT        0           // value: 0
+#define TEL_S3_ON       1           // value: 0; time is the first sample that saw S3 on
+#define TEL_S3_OFF      2           // value: 0; time as above
+#define TEL_SECOND      3           // value: elapsed seconds
+#define TEL_THRESHOLD   4           // value: new threshold in seconds
+#define TEL_ALARM_ON    5           // value: elapsed seconds
+#define TEL_ALARM_OFF   6           // value: elapsed seconds
+
+#if TELEMETRY
+extern volatile unsigned int telem_dropped;
+
+void Telemetry_Init(void);
+void Telemetry_Event(unsigned char type, unsigned long value, unsigned long time_ms);
+
+#define TELEMETRY_EVENT(type, value, time_ms)   Telemetry_Event(type, value, time_ms)
+#else
+#define TELEMETRY_EVENT(type, value, time_ms)
+#endif
+
+#endif
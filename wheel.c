@@ -0,0 +1,127 @@
+#include "intrinsics.h"
+#include "wheel.h"
+
+#define WHEEL_SLOT_COUNTS   (1UL << WHEEL_SHIFT)
+#define WHEEL_SLOT(time)    ((unsigned char)((time) >> WHEEL_SHIFT) & (WHEEL_SLOTS - 1))
+
+static WheelTimer *wheel_slots[WHEEL_SLOTS];
+static unsigned long wheel_time;        // Start of the slot the last Wheel_Run() reached
+static unsigned long wheel_next;        // Deadline the compare is set to
+static unsigned char wheel_armed;       // Timers in the slots
+
+// Into the slot of its deadline, or the slot reached if that has passed
+static void Wheel_Link(WheelTimer *timer) {
+    unsigned char slot;
+
+    if((long)(timer->due - wheel_time) < 0) slot = WHEEL_SLOT(wheel_time);
+    else slot = WHEEL_SLOT(timer->due);
+    timer->slot = slot;
+    timer->prev = 0;
+    timer->next = wheel_slots[slot];
+    if(timer->next) timer->next->prev = timer;
+    wheel_slots[slot] = timer;
+    wheel_armed++;
+}
+
+static void Wheel_Unlink(WheelTimer *timer) {
+    if(timer->prev) timer->prev->next = timer->next;
+    else wheel_slots[timer->slot] = timer->next;
+    if(timer->next) timer->next->prev = timer->prev;
+    timer->slot = WHEEL_IDLE;
+    wheel_armed--;
+}
+
+// Earliest deadline in the slots. The first slot from the one reached that
+// holds a timer due before the slot ends has it; past one turn, any slot may.
+static unsigned long Wheel_Earliest(void) {
+    unsigned long end = wheel_time, next = 0;
+    unsigned char n, found = 0;
+    WheelTimer *timer;
+
+    for(n = 0; n < WHEEL_SLOTS && !found; n++) {
+        timer = wheel_slots[WHEEL_SLOT(end)];
+        end += WHEEL_SLOT_COUNTS;
+        for(; timer; timer = timer->next) {
+            if((long)(timer->due - end) >= 0) continue;     // A later turn
+            if(!found || (long)(timer->due - next) < 0) next = timer->due;
+            found = 1;
+        }
+    }
+    for(n = 0; n < WHEEL_SLOTS && !found; n++) {
+        for(timer = wheel_slots[n]; timer; timer = timer->next) {
+            if(found && (long)(timer->due - next) >= 0) continue;
+            next = timer->due;
+            found = 1;
+        }
+    }
+    return next;
+}
+
+void Wheel_Start(WheelTimer *timer, unsigned long due, unsigned int period) {
+    __istate_t state = __get_interrupt_state();
+
+    __disable_interrupt();
+    if(Wheel_Armed(timer)) Wheel_Unlink(timer);
+    timer->due = due;
+    timer->period = period;
+    Wheel_Link(timer);
+    if(wheel_armed == 1 || (long)(due - wheel_next) < 0) {  // The new earliest
+        wheel_next = due;
+        Wheel_Compare(due);
+    }
+    __set_interrupt_state(state);
+}
+
+void Wheel_StartIn(WheelTimer *timer, unsigned int delay, unsigned int period) {
+    __istate_t state = __get_interrupt_state();
+
+    __disable_interrupt();
+    Wheel_Start(timer, Wheel_Now() + delay, period);
+    __set_interrupt_state(state);
+}
+
+// The compare stays: if it matches first, Wheel_Run() finds nothing due
+void Wheel_Cancel(WheelTimer *timer) {
+    __istate_t state = __get_interrupt_state();
+
+    __disable_interrupt();
+    if(Wheel_Armed(timer)) Wheel_Unlink(timer);
+    __set_interrupt_state(state);
+}
+
+unsigned char Wheel_Run(void) {
+    unsigned long now = Wheel_Now(), time = wheel_time, due, span;
+    unsigned char slot, wake = 0;
+    WheelTimer *timer;
+
+    // The slots from the one reached to now's, at most one turn
+    span = (now - wheel_time) >> WHEEL_SHIFT;
+    if(span >= WHEEL_SLOTS) span = WHEEL_SLOTS - 1;
+    do {
+        wheel_time = time;                  // Deadlines re-armed into the past land here
+        slot = WHEEL_SLOT(time);
+        timer = wheel_slots[slot];
+        while(timer) {
+            if((long)(timer->due - now) > 0) {
+                timer = timer->next;
+                continue;
+            }
+            due = timer->due;
+            Wheel_Unlink(timer);
+            if(timer->period) {
+                timer->due = due + timer->period;
+                Wheel_Link(timer);
+            }
+            if(timer->expire(due)) wake = 1;
+            timer = wheel_slots[slot];      // The expire may have changed the list
+        }
+        time += WHEEL_SLOT_COUNTS;
+    } while(span--);
+    wheel_time = now & ~(WHEEL_SLOT_COUNTS - 1);
+
+    if(wheel_armed) {
+        wheel_next = Wheel_Earliest();
+        Wheel_Compare(wheel_next);
+    }
+    return wake;
+}
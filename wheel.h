@@ -0,0 +1,59 @@
+#ifndef WHEEL_H
+#define WHEEL_H
+
+/* ========================= Timer Wheel =========================
+ * Software timers, one-shot or periodic, all served by one hardware compare.
+ * Times are 32-bit counts of the application's clock (Wheel_Now()).
+ *
+ * Armed timers hang in WHEEL_SLOTS lists hashed on due >> WHEEL_SHIFT, so a
+ * start is one list insert and a cancel one unlink, however many are armed.
+ * A deadline already passed goes into the slot the wheel has reached, and a
+ * deadline more than one turn ahead shares a slot with nearer ones and just
+ * waits out the extra turns.
+ *
+ * Nothing ticks: the compare is set to the earliest deadline, and when it
+ * matches Wheel_Run() expires every timer that is due, walking only the slots
+ * passed since the last match, and sets the compare to the next deadline.
+ * The tickless build counts ACLK, and the compare is TA0CCR0; the 1 ms build
+ * counts its tick, and the tick is the compare (it calls Wheel_Run() once the
+ * count reaches the deadline).
+ */
+#ifndef TICKLESS
+#define TICKLESS        0
+#endif
+
+#define WHEEL_SLOTS     16          // Power of two
+#if TICKLESS
+#define WHEEL_SHIFT     11          // Slot width 2048 counts (62.5 ms at 32768 Hz)
+#else
+#define WHEEL_SHIFT     6           // Slot width 64 counts (64 ms at 1 kHz)
+#endif
+
+typedef struct WheelTimer {
+    struct WheelTimer *next;
+    struct WheelTimer *prev;
+    unsigned long due;              // Wheel_Now() count it expires at
+    unsigned int  period;           // Re-armed this far after due; 0 = one-shot
+    unsigned char slot;             // Slot it hangs in, WHEEL_IDLE when not armed
+    unsigned char (*expire)(unsigned long due);     // In the compare ISR; 1 = wake main
+} WheelTimer;
+
+#define WHEEL_IDLE      0xFF
+#define WHEEL_TIMER(expire)     { 0, 0, 0, 0, WHEEL_IDLE, expire }
+
+// Provided by the application, called with interrupts off: the 32-bit clock,
+// and the compare set to a deadline (one already passed must fire at once)
+unsigned long Wheel_Now(void);
+void Wheel_Compare(unsigned long due);
+
+// ISR or main. A timer that is armed already is moved to the new deadline.
+void Wheel_Start(WheelTimer *timer, unsigned long due, unsigned int period);
+void Wheel_StartIn(WheelTimer *timer, unsigned int delay, unsigned int period);   // due = now + delay
+void Wheel_Cancel(WheelTimer *timer);
+#define Wheel_Armed(timer)      ((timer)->slot != WHEEL_IDLE)
+
+// Compare ISR: expire the timers that are due (a periodic one is re-armed
+// before its expire runs) and set the next compare. Returns 1 if main must wake.
+unsigned char Wheel_Run(void);
+
+#endif